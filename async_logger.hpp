@@ -0,0 +1,683 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "dji/dji_log.h"
+#include "thread_rings.hpp"
+
+namespace async_logger_detail {
+
+enum class Length : uint8_t {
+    None,
+    Char,       // hh
+    Short,      // h
+    Long,       // l
+    LongLong,   // ll
+    Size,       // z
+    Max,        // j
+    Ptrdiff,    // t
+    LongDouble, // L
+};
+
+// 参数在记录中的存放方式，由转换说明决定；生产者与格式化线程按同一规则读写
+enum class Kind : uint8_t {
+    Literal,  // "%%"，没有参数
+    Signed,   // 8 字节 int64_t
+    Unsigned, // 8 字节 uint64_t
+    Float,    // 8 字节 double
+    Pointer,  // 8 字节 uint64_t
+    String,   // 2 字节长度加字符串内容，不含结尾的 0
+    Wide,     // 宽字符与宽字符串：只消耗参数，不保存，输出 '?'
+    Count,    // %n：只消耗参数，不输出
+    Invalid,  // 无法识别的转换，之后的参数类型未知，停止记录
+};
+
+struct Spec {
+    const char *begin = nullptr; // '%' 的位置
+    const char *end = nullptr;   // 转换字符之后的位置
+    char conversion = 0;
+    Length length = Length::None;
+    bool star_width = false;
+    bool star_precision = false;
+    int precision = -1; // 格式串中直接给出的精度，-1 表示未给出
+};
+
+inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// 从 p 开始查找下一个转换说明（含 "%%"），没有时返回 false
+inline bool next_spec(const char *p, Spec &spec) {
+    p = std::strchr(p, '%');
+    if (p == nullptr) {
+        return false;
+    }
+    spec = Spec();
+    spec.begin = p++;
+    while (*p != '\0' && std::strchr("-+ #0", *p) != nullptr) {
+        p++;
+    }
+    if (*p == '*') {
+        spec.star_width = true;
+        p++;
+    }
+    while (is_digit(*p)) {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec.star_precision = true;
+            p++;
+        } else {
+            spec.precision = 0;
+            while (is_digit(*p)) {
+                spec.precision = spec.precision * 10 + (*p++ - '0');
+            }
+        }
+    }
+    switch (*p) {
+    case 'h':
+        spec.length = p[1] == 'h' ? Length::Char : Length::Short;
+        p += p[1] == 'h' ? 2 : 1;
+        break;
+    case 'l':
+        spec.length = p[1] == 'l' ? Length::LongLong : Length::Long;
+        p += p[1] == 'l' ? 2 : 1;
+        break;
+    case 'z':
+        spec.length = Length::Size;
+        p++;
+        break;
+    case 'j':
+        spec.length = Length::Max;
+        p++;
+        break;
+    case 't':
+        spec.length = Length::Ptrdiff;
+        p++;
+        break;
+    case 'L':
+        spec.length = Length::LongDouble;
+        p++;
+        break;
+    default:
+        break;
+    }
+    spec.conversion = *p;
+    spec.end = *p != '\0' ? p + 1 : p;
+    return true;
+}
+
+inline Kind kind_of(const Spec &spec) {
+    switch (spec.conversion) {
+    case '%':
+        return Kind::Literal;
+    case 'd':
+    case 'i':
+        return Kind::Signed;
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        return Kind::Unsigned;
+    case 'c':
+        return spec.length == Length::Long ? Kind::Wide : Kind::Signed;
+    case 's':
+        return spec.length == Length::Long ? Kind::Wide : Kind::String;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        return Kind::Float;
+    case 'p':
+        return Kind::Pointer;
+    case 'n':
+        return Kind::Count;
+    default:
+        return Kind::Invalid;
+    }
+}
+
+// 按长度修饰符取出整数参数；args 为 va_copy 得到的副本，按引用传递才能在多次调用之间推进
+inline int64_t signed_arg(Length length, va_list &args) {
+    switch (length) {
+    case Length::Long:
+        return va_arg(args, long);
+    case Length::LongLong:
+        return va_arg(args, long long);
+    case Length::Size:
+    case Length::Ptrdiff:
+        return va_arg(args, ptrdiff_t);
+    case Length::Max:
+        return va_arg(args, intmax_t);
+    default:
+        return va_arg(args, int);
+    }
+}
+
+inline uint64_t unsigned_arg(Length length, va_list &args) {
+    switch (length) {
+    case Length::Long:
+        return va_arg(args, unsigned long);
+    case Length::LongLong:
+        return va_arg(args, unsigned long long);
+    case Length::Size:
+        return va_arg(args, size_t);
+    case Length::Ptrdiff:
+        return (uint64_t)va_arg(args, ptrdiff_t);
+    case Length::Max:
+        return va_arg(args, uintmax_t);
+    default:
+        return va_arg(args, unsigned int);
+    }
+}
+
+class Writer {
+public:
+    Writer(uint8_t *data, size_t capacity) : data_(data), capacity_(capacity) {}
+
+    template <typename T> bool put(T value) {
+        if (capacity_ - used_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(data_ + used_, &value, sizeof(T));
+        used_ += sizeof(T);
+        return true;
+    }
+
+    // 放不下时截断字符串，返回是否完整写入
+    bool put_string(const char *text, size_t length) {
+        if (capacity_ - used_ < sizeof(uint16_t)) {
+            return false;
+        }
+        size_t room = capacity_ - used_ - sizeof(uint16_t);
+        uint16_t stored = (uint16_t)std::min(length, room);
+        put(stored);
+        std::memcpy(data_ + used_, text, stored);
+        used_ += stored;
+        return stored == length;
+    }
+
+    size_t used() const { return used_; }
+
+private:
+    uint8_t *data_;
+    size_t capacity_;
+    size_t used_ = 0;
+};
+
+class Reader {
+public:
+    Reader(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T> bool get(T &value) {
+        if (size_ - used_ < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, data_ + used_, sizeof(T));
+        used_ += sizeof(T);
+        return true;
+    }
+
+    bool get_string(std::string &text) {
+        uint16_t length = 0;
+        if (!get(length) || size_ - used_ < length) {
+            return false;
+        }
+        text.assign((const char *)data_ + used_, length);
+        used_ += length;
+        return true;
+    }
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t used_ = 0;
+};
+
+/**
+ * @brief Copy the arguments of format into writer without formatting them
+ *        将 format 对应的参数原样拷贝到 writer，不做格式化
+ *
+ * Integers and floating point values are widened to 8 bytes, strings are copied because the caller's buffer may be
+ * gone by the time the record is formatted. Returns false when something did not fit or could not be decoded.
+ * 整数与浮点数扩展为 8 字节保存；字符串需要拷贝，因为格式化时调用方的缓冲区可能已经失效。有内容放不下或
+ * 无法识别时返回 false。
+ */
+inline bool encode_args(const char *format, va_list &args, Writer &writer) {
+    Spec spec;
+    for (const char *p = format; next_spec(p, spec); p = spec.end) {
+        Kind kind = kind_of(spec);
+        if (kind == Kind::Literal) {
+            continue;
+        }
+        if (kind == Kind::Invalid) {
+            return false;
+        }
+
+        int stars[2] = {};
+        int star_count = 0;
+        if (spec.star_width) {
+            stars[star_count++] = va_arg(args, int);
+        }
+        if (spec.star_precision) {
+            stars[star_count++] = va_arg(args, int);
+        }
+        for (int i = 0; i < star_count; i++) {
+            if (!writer.put((int64_t)stars[i])) {
+                return false;
+            }
+        }
+
+        bool ok = true;
+        switch (kind) {
+        case Kind::Signed:
+            ok = writer.put(signed_arg(spec.length, args));
+            break;
+        case Kind::Unsigned:
+            ok = writer.put(unsigned_arg(spec.length, args));
+            break;
+        case Kind::Float:
+            ok = writer.put(spec.length == Length::LongDouble ? (double)va_arg(args, long double)
+                                                              : va_arg(args, double));
+            break;
+        case Kind::Pointer:
+            ok = writer.put((uint64_t)(uintptr_t)va_arg(args, void *));
+            break;
+        case Kind::String: {
+            const char *text = va_arg(args, const char *);
+            if (text == nullptr) {
+                text = "(null)";
+            }
+            // 带精度的 %s 可以指向不以 0 结尾的缓冲区，不能越过精度读取
+            int precision = spec.star_precision ? stars[star_count - 1] : spec.precision;
+            size_t length = 0;
+            size_t limit = precision >= 0 ? (size_t)precision : (size_t)-1;
+            while (length < limit && text[length] != '\0') {
+                length++;
+            }
+            ok = writer.put_string(text, length);
+            break;
+        }
+        case Kind::Wide:
+            if (spec.conversion == 'c') {
+                (void)va_arg(args, wint_t);
+            } else {
+                (void)va_arg(args, const wchar_t *);
+            }
+            break;
+        case Kind::Count:
+            (void)va_arg(args, void *);
+            break;
+        default:
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T> void append_formatted(std::string &line, const Spec &spec, const int *stars, int star_count,
+                                            T value) {
+    char conversion[32];
+    size_t length = std::min<size_t>(spec.end - spec.begin, sizeof(conversion) - 1);
+    std::memcpy(conversion, spec.begin, length);
+    conversion[length] = '\0';
+
+    char buffer[256];
+    int written = star_count == 0   ? std::snprintf(buffer, sizeof(buffer), conversion, value)
+                  : star_count == 1 ? std::snprintf(buffer, sizeof(buffer), conversion, stars[0], value)
+                                    : std::snprintf(buffer, sizeof(buffer), conversion, stars[0], stars[1], value);
+    if (written > 0) {
+        line.append(buffer, std::min<size_t>((size_t)written, sizeof(buffer) - 1));
+    }
+}
+
+// 按 format 与 encode_args 写入的参数格式化一条消息，追加到 line
+inline void format_args(const char *format, Reader &reader, std::string &line) {
+    Spec spec;
+    const char *p = format;
+    for (; next_spec(p, spec); p = spec.end) {
+        line.append(p, spec.begin);
+        Kind kind = kind_of(spec);
+        if (kind == Kind::Literal) {
+            line += '%';
+            continue;
+        }
+        if (kind == Kind::Invalid) {
+            line += "...";
+            return;
+        }
+
+        int stars[2] = {};
+        int star_count = 0;
+        for (bool star : {spec.star_width, spec.star_precision}) {
+            int64_t value = 0;
+            if (star) {
+                if (!reader.get(value)) {
+                    line += "...";
+                    return;
+                }
+                stars[star_count++] = (int)value;
+            }
+        }
+
+        bool ok = true;
+        switch (kind) {
+        case Kind::Signed: {
+            int64_t value = 0;
+            if ((ok = reader.get(value))) {
+                switch (spec.length) {
+                case Length::Long:
+                    append_formatted(line, spec, stars, star_count, (long)value);
+                    break;
+                case Length::LongLong:
+                    append_formatted(line, spec, stars, star_count, (long long)value);
+                    break;
+                case Length::Size:
+                case Length::Ptrdiff:
+                    append_formatted(line, spec, stars, star_count, (ptrdiff_t)value);
+                    break;
+                case Length::Max:
+                    append_formatted(line, spec, stars, star_count, (intmax_t)value);
+                    break;
+                default:
+                    append_formatted(line, spec, stars, star_count, (int)value);
+                    break;
+                }
+            }
+            break;
+        }
+        case Kind::Unsigned: {
+            uint64_t value = 0;
+            if ((ok = reader.get(value))) {
+                switch (spec.length) {
+                case Length::Long:
+                    append_formatted(line, spec, stars, star_count, (unsigned long)value);
+                    break;
+                case Length::LongLong:
+                    append_formatted(line, spec, stars, star_count, (unsigned long long)value);
+                    break;
+                case Length::Size:
+                    append_formatted(line, spec, stars, star_count, (size_t)value);
+                    break;
+                case Length::Ptrdiff:
+                    append_formatted(line, spec, stars, star_count, (ptrdiff_t)value);
+                    break;
+                case Length::Max:
+                    append_formatted(line, spec, stars, star_count, (uintmax_t)value);
+                    break;
+                default:
+                    append_formatted(line, spec, stars, star_count, (unsigned int)value);
+                    break;
+                }
+            }
+            break;
+        }
+        case Kind::Float: {
+            double value = 0;
+            if ((ok = reader.get(value))) {
+                if (spec.length == Length::LongDouble) {
+                    append_formatted(line, spec, stars, star_count, (long double)value);
+                } else {
+                    append_formatted(line, spec, stars, star_count, value);
+                }
+            }
+            break;
+        }
+        case Kind::Pointer: {
+            uint64_t value = 0;
+            if ((ok = reader.get(value))) {
+                append_formatted(line, spec, stars, star_count, (void *)(uintptr_t)value);
+            }
+            break;
+        }
+        case Kind::String: {
+            std::string text;
+            if ((ok = reader.get_string(text))) {
+                append_formatted(line, spec, stars, star_count, text.c_str());
+            }
+            break;
+        }
+        case Kind::Wide:
+            line += '?';
+            break;
+        default:
+            break;
+        }
+        if (!ok) {
+            line += "...";
+            return;
+        }
+    }
+    line += p;
+}
+
+} // namespace async_logger_detail
+
+/**
+ * @brief Log sink for the dji library that moves formatting and stdio off the logging threads
+ *        dji 库的日志输出，将格式化与 stdio 调用移出记录日志的线程
+ *
+ * While an AsyncLogger exists every enabled ESP_LOG* call stores a binary record in a ring owned by the calling
+ * thread: the tag and format pointers (string literals, so they double as the message id), a timestamp and the raw
+ * argument values. That is a handful of stores and no lock, no allocation and no stdio call. A background thread
+ * merges the rings by timestamp, formats the records in the same "[LEVEL][TAG] message" layout the default sink
+ * prints, and writes each batch with one call per stream.
+ * AsyncLogger 存在期间，每个已启用的 ESP_LOG* 调用都在调用线程自己的环形缓冲区中写入一条二进制记录：tag 与
+ * format 指针（均为字符串字面量，同时充当消息 id）、时间戳以及参数的原始值。这只是几次写内存操作，不加锁、
+ * 不分配内存、不调用 stdio。后台线程按时间戳合并各线程的缓冲区，以默认输出相同的 "[LEVEL][TAG] message"
+ * 格式格式化记录，每批记录对每个输出流只调用一次写入。
+ *
+ * A full ring drops the record and counts it rather than waiting, and the producer never takes a lock to wake the
+ * background thread, which also polls, so logging cannot block the BLE callback thread. Construct the logger before
+ * the threads that log start and destroy it after they stop, like dji_set_log_sink requires.
+ * 缓冲区满时丢弃记录并计数而不等待；生产者唤醒后台线程时也不加锁（后台线程同时定期轮询），因此记录日志不会
+ * 阻塞 BLE 回调线程。与 dji_set_log_sink 的要求一致，需在记录日志的线程启动前构造，在其停止后析构。
+ */
+class AsyncLogger {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        size_t ring_records = 256;                   // 每个线程的缓冲区容量，向上取整为 2 的幂
+        std::chrono::milliseconds poll_interval{50}; // 后台线程未被唤醒时的轮询间隔
+        FILE *output = nullptr;                      // nullptr 时错误与警告写 stderr，其余写 stdout
+    };
+
+    struct Stats {
+        uint64_t records = 0;   // 已格式化输出的记录数
+        uint64_t dropped = 0;   // 因线程缓冲区已满而丢弃的记录数
+        uint64_t truncated = 0; // 参数超出单条记录容量而被截断的记录数
+        size_t threads = 0;     // 当前登记的线程缓冲区数
+    };
+
+    static Config default_config() { return Config(); }
+
+    explicit AsyncLogger(Config config = default_config())
+        : config_(config), buffers_(std::bit_ceil(config.ring_records)),
+          worker_(config.poll_interval, [this] { drain(); }) {
+        dji_set_log_sink(&AsyncLogger::sink, this);
+    }
+
+    ~AsyncLogger() {
+        dji_set_log_sink(nullptr, nullptr);
+        worker_.stop();
+    }
+
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+
+    Stats stats() const {
+        Stats stats;
+        stats.records = records_.load(std::memory_order_relaxed);
+        stats.threads = buffers_.visit(
+            [&](const ThreadBuffer &buffer) {
+                stats.dropped += buffer.dropped.load(std::memory_order_relaxed);
+                stats.truncated += buffer.truncated.load(std::memory_order_relaxed);
+            },
+            [&] {
+                stats.dropped += retired_dropped_;
+                stats.truncated += retired_truncated_;
+            });
+        return stats;
+    }
+
+private:
+    static constexpr size_t cache_line = 64;
+    static constexpr size_t record_size = 256;
+
+    struct alignas(cache_line) Record {
+        Clock::time_point timestamp;
+        const char *tag;
+        const char *format;
+        uint16_t size; // args 中已使用的字节数
+        uint8_t level;
+        std::array<uint8_t, record_size - sizeof(Clock::time_point) - 2 * sizeof(const char *) - 4> args;
+    };
+    static_assert(sizeof(Record) == record_size);
+
+    // 单生产者（所属线程）/单消费者（后台线程）的记录环
+    struct ThreadBuffer {
+        explicit ThreadBuffer(size_t capacity) : records(capacity), mask(capacity - 1) {}
+
+        std::vector<Record> records;
+        const size_t mask;
+
+        alignas(cache_line) std::atomic<size_t> tail = 0;
+        size_t cached_head = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<uint64_t> truncated = 0;
+
+        alignas(cache_line) std::atomic<size_t> head = 0;
+
+        const Record *front() const {
+            size_t position = head.load(std::memory_order_relaxed);
+            return position != tail.load(std::memory_order_acquire) ? &records[position & mask] : nullptr;
+        }
+        void pop() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+        bool empty() const { return front() == nullptr; }
+    };
+
+    static void sink(int level, const char *tag, const char *format, va_list args, void *user_data) {
+        static_cast<AsyncLogger *>(user_data)->write(level, tag, format, args);
+    }
+
+    void write(int level, const char *tag, const char *format, va_list args) {
+        ThreadBuffer &buffer = buffers_.local();
+        size_t tail = buffer.tail.load(std::memory_order_relaxed);
+        if (tail - buffer.cached_head > buffer.mask) {
+            buffer.cached_head = buffer.head.load(std::memory_order_acquire);
+            if (tail - buffer.cached_head > buffer.mask) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        Record &record = buffer.records[tail & buffer.mask];
+        record.timestamp = Clock::now();
+        record.tag = tag;
+        record.format = format;
+        record.level = (uint8_t)level;
+        async_logger_detail::Writer writer(record.args.data(), record.args.size());
+        // sink 收到的 va_list 可能已退化为指针，拷贝一份才能按引用逐个取参数
+        va_list copy;
+        va_copy(copy, args);
+        bool complete = async_logger_detail::encode_args(format, copy, writer);
+        va_end(copy);
+        record.size = (uint16_t)writer.used();
+        if (!complete) {
+            buffer.truncated.fetch_add(1, std::memory_order_relaxed);
+        }
+        buffer.tail.store(tail + 1, std::memory_order_release);
+
+        worker_.wake();
+    }
+
+    // 按时间戳合并各线程的记录并格式化，每个输出流一次写入；只在后台线程上调用
+    void drain() {
+        std::vector<std::shared_ptr<ThreadBuffer>> &buffers = drain_buffers_;
+        buffers_.snapshot(
+            buffers, [](const ThreadBuffer &buffer) { return buffer.empty(); },
+            [this](const ThreadBuffer &buffer) {
+                retired_dropped_ += buffer.dropped.load(std::memory_order_relaxed);
+                retired_truncated_ += buffer.truncated.load(std::memory_order_relaxed);
+            });
+
+        uint64_t count = 0;
+        for (;;) {
+            ThreadBuffer *earliest = nullptr;
+            const Record *first = nullptr;
+            for (const auto &buffer : buffers) {
+                const Record *record = buffer->front();
+                if (record != nullptr && (first == nullptr || record->timestamp < first->timestamp)) {
+                    earliest = buffer.get();
+                    first = record;
+                }
+            }
+            if (first == nullptr) {
+                break;
+            }
+
+            std::string &line = config_.output != nullptr || first->level > DJI_LOG_LEVEL_WARN ? out_ : err_;
+            line += '[';
+            line += dji_log_level_name(first->level);
+            line += "][";
+            line += first->tag;
+            line += "] ";
+            async_logger_detail::Reader reader(first->args.data(), first->size);
+            async_logger_detail::format_args(first->format, reader, line);
+            line += '\n';
+            earliest->pop();
+            count++;
+        }
+        if (count == 0) {
+            return;
+        }
+
+        records_.fetch_add(count, std::memory_order_relaxed);
+        write_out(out_, config_.output != nullptr ? config_.output : stdout);
+        write_out(err_, stderr);
+    }
+
+    static void write_out(std::string &text, FILE *stream) {
+        if (text.empty()) {
+            return;
+        }
+        std::fwrite(text.data(), 1, text.size(), stream);
+        std::fflush(stream);
+        text.clear();
+    }
+
+    const Config config_;
+    ThreadRingRegistry<ThreadBuffer> buffers_;
+    // 由 buffers_ 的锁保护
+    uint64_t retired_dropped_ = 0;
+    uint64_t retired_truncated_ = 0;
+    std::atomic<uint64_t> records_ = 0;
+
+    // 仅由后台线程使用，跨批次复用
+    std::vector<std::shared_ptr<ThreadBuffer>> drain_buffers_;
+    std::string out_;
+    std::string err_;
+
+    PollingWorker worker_;
+};
@@ -0,0 +1,635 @@
+// dji 协议库的微基准测试，结果以 JSON 输出，便于在版本之间比较
+//
+// 用法: osmo_bench [--filter <子串>] [--min-time <秒>] [--repetitions <次数>] [--output <路径>]
+//
+// 每个基准先校验一次结果（例如各 CRC 内核与逐字节参考实现逐位一致、creator 与 encoder 输出相同），
+// 校验失败时不计时，该项带 "error" 字段输出，进程以非零值退出。
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dji/custom_crc16.h"
+#include "dji/custom_crc32.h"
+#include "dji/dji_allocator.h"
+#include "dji/dji_log.h"
+#include "dji/dji_protocol_data_descriptors.h"
+#include "dji/dji_protocol_data_processor.h"
+#include "dji/dji_protocol_data_structures.h"
+#include "dji/dji_protocol_parser.h"
+#include "dji/enums_logic.h"
+#include "frame_cache.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string filter;
+    double min_time = 0.2;
+    int repetitions = 5;
+    std::string output;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0;
+    double bytes_per_second = 0;
+    double allocations_per_op = 0;
+    std::string error;
+};
+
+// 只统计 dji_malloc，即库自身在每次操作中的堆分配
+uint64_t allocations = 0;
+
+void *counting_malloc(size_t size, void *) {
+    allocations++;
+    return std::malloc(size);
+}
+
+void counting_free(void *ptr, void *) { std::free(ptr); }
+
+// 库在解析路径上会输出 INFO 日志，基准只测协议处理本身，日志直接丢弃
+void discard_log(int, const char *, const char *, va_list, void *) {}
+
+// 阻止编译器把被测调用的结果当作无用代码删除
+template <typename T> void keep(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+class Runner {
+public:
+    explicit Runner(Options options) : options_(std::move(options)) {}
+
+    bool selected(const std::string &name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+
+    // 记录一个未通过校验的基准
+    void fail(const std::string &name, const std::string &error) {
+        if (selected(name)) {
+            Result result;
+            result.name = name;
+            result.error = error;
+            results_.push_back(result);
+        }
+    }
+
+    // 先确定每轮的迭代次数使单轮不短于 min_time，再重复 repetitions 轮取 ns/op 的中位数
+    template <typename F> void run(const std::string &name, size_t bytes_per_op, F &&op) {
+        if (!selected(name)) {
+            return;
+        }
+
+        uint64_t iterations = 1;
+        while (true) {
+            double seconds = time(iterations, op);
+            if (seconds >= options_.min_time || iterations >= (1ull << 40)) {
+                break;
+            }
+            // 按已测得的速度估算，留 20% 余量，且每次至多放大 10 倍
+            double scale = seconds > 0 ? options_.min_time * 1.2 / seconds : 10;
+            iterations = (uint64_t)(iterations * std::clamp(scale, 2.0, 10.0));
+        }
+
+        std::vector<double> samples;
+        uint64_t allocated = 0;
+        for (int i = 0; i < options_.repetitions; i++) {
+            uint64_t before = allocations;
+            samples.push_back(time(iterations, op) * 1e9 / iterations);
+            allocated += allocations - before;
+        }
+        std::sort(samples.begin(), samples.end());
+
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        result.ns_per_op = samples[samples.size() / 2];
+        result.bytes_per_second = bytes_per_op != 0 ? bytes_per_op * 1e9 / result.ns_per_op : 0;
+        result.allocations_per_op = (double)allocated / ((double)iterations * options_.repetitions);
+        results_.push_back(result);
+    }
+
+    bool failed() const {
+        return std::any_of(results_.begin(), results_.end(), [](const Result &r) { return !r.error.empty(); });
+    }
+
+    std::string json() const {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+        std::string out = "{\n  \"context\": {\n";
+        out += "    \"date\": \"" + std::string(date) + "\",\n";
+        out += "    \"compiler\": \"" + escape(compiler()) + "\",\n";
+        out += "    \"crc32_kernel\": \"" + std::string(crc32_kernel_name()) + "\",\n";
+        out += "    \"min_time\": " + number(options_.min_time) + ",\n";
+        out += "    \"repetitions\": " + std::to_string(options_.repetitions) + "\n";
+        out += "  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results_.size(); i++) {
+            const Result &r = results_[i];
+            out += i == 0 ? "\n" : ",\n";
+            out += "    {\"name\": \"" + escape(r.name) + "\"";
+            if (!r.error.empty()) {
+                out += ", \"error\": \"" + escape(r.error) + "\"}";
+                continue;
+            }
+            out += ", \"iterations\": " + std::to_string(r.iterations);
+            out += ", \"ns_per_op\": " + number(r.ns_per_op);
+            out += ", \"bytes_per_second\": " + number(r.bytes_per_second);
+            out += ", \"allocations_per_op\": " + number(r.allocations_per_op) + "}";
+        }
+        out += "\n  ]\n}\n";
+        return out;
+    }
+
+private:
+    template <typename F> static double time(uint64_t iterations, F &op) {
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            op();
+        }
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static std::string number(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        return buffer;
+    }
+
+    static std::string escape(const std::string &value) {
+        std::string out;
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+            }
+            out += c;
+        }
+        return out;
+    }
+
+    static std::string compiler() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    Options options_;
+    std::vector<Result> results_;
+};
+
+// 确定性的测试数据，同一版本的每次运行输入相同
+std::vector<uint8_t> pattern(size_t length) {
+    std::vector<uint8_t> data(length);
+    uint32_t state = 0x12345678;
+    for (uint8_t &byte : data) {
+        state = state * 1664525u + 1013904223u;
+        byte = (uint8_t)(state >> 24);
+    }
+    return data;
+}
+
+const size_t payload_sizes[] = {16, 64, 256, PROTOCOL_MAX_DATA_LENGTH};
+
+void bench_crc(Runner &runner) {
+    using Crc16Kernel = crc16_t (*)(crc16_t, const void *, size_t);
+    using Crc32Kernel = crc32_t (*)(crc32_t, const void *, size_t);
+    const std::pair<const char *, Crc16Kernel> crc16_kernels[] = {
+        {"table", crc16_update_table},
+        {"slice8", crc16_update_slice8},
+    };
+    std::vector<std::pair<const char *, Crc32Kernel>> crc32_kernels = {
+        {"table", crc32_update_table},
+        {"slice8", crc32_update_slice8},
+    };
+    if (crc32_clmul_supported()) {
+        crc32_kernels.push_back({"clmul", crc32_update_clmul});
+    }
+
+    for (size_t size : payload_sizes) {
+        std::vector<uint8_t> data = pattern(size);
+        std::string suffix = "/" + std::to_string(size);
+
+        // 逐字节查表内核作为参考，其余内核与入口函数的结果须逐位一致
+        uint16_t crc16 = (uint16_t)crc16_finalize(crc16_update_table(crc_init(), data.data(), size));
+        uint32_t crc32 = (uint32_t)crc32_finalize(crc32_update_table(crc32_init(), data.data(), size));
+
+        if (calculate_crc16(data.data(), size) != crc16) {
+            runner.fail("calculate_crc16" + suffix, "result differs from crc16_update_table");
+        } else {
+            runner.run("calculate_crc16" + suffix, size, [&] { keep(calculate_crc16(data.data(), size)); });
+        }
+        if (calculate_crc32(data.data(), size) != crc32) {
+            runner.fail("calculate_crc32" + suffix, "result differs from crc32_update_table");
+        } else {
+            runner.run("calculate_crc32" + suffix, size, [&] { keep(calculate_crc32(data.data(), size)); });
+        }
+
+        for (auto [name, kernel] : crc16_kernels) {
+            std::string bench = std::string("crc16_update_") + name + suffix;
+            if ((uint16_t)crc16_finalize(kernel(crc_init(), data.data(), size)) != crc16) {
+                runner.fail(bench, "result differs from crc16_update_table");
+                continue;
+            }
+            runner.run(bench, size, [&, kernel = kernel] { keep(kernel(crc_init(), data.data(), size)); });
+        }
+        for (auto [name, kernel] : crc32_kernels) {
+            std::string bench = std::string("crc32_update_") + name + suffix;
+            if ((uint32_t)crc32_finalize(kernel(crc32_init(), data.data(), size)) != crc32) {
+                runner.fail(bench, "result differs from crc32_update_table");
+                continue;
+            }
+            runner.run(bench, size, [&, kernel = kernel] { keep(kernel(crc32_init(), data.data(), size)); });
+        }
+    }
+}
+
+// 长度 0..crc_algebra_max_length 的任意两段数据，拼接、补零与局部修改后的 CRC 须与直接计算的结果逐位一致
+constexpr size_t crc_algebra_max_length = 128;
+
+template <typename Crc, typename Update, typename Combine>
+bool combine_matches(const std::vector<uint8_t> &data, Crc init, Update update, Combine combine) {
+    for (size_t len1 = 0; len1 <= crc_algebra_max_length; len1++) {
+        Crc first = update(init, data.data(), len1);
+        for (size_t len2 = 0; len2 <= crc_algebra_max_length; len2++) {
+            Crc second = update(init, data.data() + len1, len2);
+            if (combine(first, second, len2) != update(init, data.data(), len1 + len2)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template <typename Crc, typename Update, typename Shift> bool shift_matches(Crc init, Update update, Shift shift) {
+    const uint8_t zero = 0;
+    std::vector<uint8_t> data = pattern(crc_algebra_max_length);
+    Crc crc = update(init, data.data(), data.size());
+    Crc direct = crc;
+    for (size_t zero_len = 0; zero_len <= PROTOCOL_MAX_FRAME_LENGTH; zero_len++) {
+        if (shift(crc, zero_len) != direct) {
+            return false;
+        }
+        direct = update(direct, &zero, 1);
+    }
+    return true;
+}
+
+// 把 [offset, offset + len) 换成另一段数据，覆盖每个起点与 1..4 字节的长度
+template <typename Crc, typename Update, typename Patch> bool patch_matches(Crc init, Update update, Patch patch) {
+    std::vector<uint8_t> data = pattern(2 * crc_algebra_max_length);
+    std::vector<uint8_t> replacement = pattern(2 * crc_algebra_max_length + 4);
+    Crc crc = update(init, data.data(), data.size());
+    for (size_t len = 1; len <= 4; len++) {
+        for (size_t offset = 0; offset + len <= data.size(); offset++) {
+            std::vector<uint8_t> modified = data;
+            std::memcpy(&modified[offset], &replacement[offset + 4], len);
+            Crc patched = patch(crc, &data[offset], &modified[offset], len, data.size() - offset - len);
+            if (patched != update(init, modified.data(), modified.size())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void bench_crc_algebra(Runner &runner) {
+    std::vector<uint8_t> data = pattern(2 * crc_algebra_max_length);
+    const size_t len2 = PROTOCOL_MAX_DATA_LENGTH;
+    const std::string suffix = "/" + std::to_string(len2);
+
+    if (!combine_matches(data, crc_init(), crc16_update_table, crc16_combine)) {
+        runner.fail("crc16_combine" + suffix, "result differs from the crc of the concatenated buffers");
+    } else {
+        runner.run("crc16_combine" + suffix, 0, [&] { keep(crc16_combine(0x1234, 0x5678, len2)); });
+    }
+    if (!combine_matches(data, crc32_init(), crc32_update_table, crc32_combine)) {
+        runner.fail("crc32_combine" + suffix, "result differs from the crc of the concatenated buffers");
+    } else {
+        runner.run("crc32_combine" + suffix, 0, [&] { keep(crc32_combine(0x12345678, 0x9ABCDEF0, len2)); });
+    }
+    if (!shift_matches(crc_init(), crc16_update_table, crc16_shift)) {
+        runner.fail("crc16_shift" + suffix, "result differs from updating over zero bytes");
+    } else {
+        runner.run("crc16_shift" + suffix, 0, [&] { keep(crc16_shift(0x1234, len2)); });
+    }
+    if (!shift_matches(crc32_init(), crc32_update_table, crc32_shift)) {
+        runner.fail("crc32_shift" + suffix, "result differs from updating over zero bytes");
+    } else {
+        runner.run("crc32_shift" + suffix, 0, [&] { keep(crc32_shift(0x12345678, len2)); });
+    }
+    if (!patch_matches(crc_init(), crc16_update_table, crc16_patch)) {
+        runner.fail("crc16_patch", "result differs from the crc of the modified buffer");
+    }
+    if (!patch_matches(crc32_init(), crc32_update_table, crc32_patch)) {
+        runner.fail("crc32_patch", "result differs from the crc of the modified buffer");
+    }
+}
+
+std::string descriptor_name(const data_descriptor_t &descriptor) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "%02X_%02X", descriptor.cmd_set, descriptor.cmd_id);
+    return name;
+}
+
+// 对每个带编码器的描述符与若干 SEQ，改写 SEQ 后的帧须与用新 SEQ 重新编码的帧逐字节相同；返回第一处不一致
+std::string check_frame_set_seq() {
+    std::vector<uint8_t> structure = pattern(64);
+    std::vector<uint16_t> seqs = {0x0000, 0x00FF, 0xFF00, 0xFFFF};
+    uint32_t state = 0x9E3779B9;
+    for (int i = 0; i < 4; i++) {
+        state = state * 1664525u + 1013904223u;
+        seqs.push_back((uint16_t)(state >> 16));
+    }
+
+    for (size_t i = 0; i < DATA_DESCRIPTORS_COUNT; i++) {
+        const data_descriptor_t &descriptor = data_descriptors[i];
+        if (descriptor.encoder == nullptr) {
+            continue;
+        }
+        uint8_t original[PROTOCOL_MAX_FRAME_LENGTH];
+        size_t length = 0;
+        if (protocol_encode_frame_into(original, sizeof(original), descriptor.cmd_set, descriptor.cmd_id,
+                                       CMD_WAIT_RESULT, structure.data(), 0x1234, &length) != 0) {
+            return descriptor_name(descriptor) + ": encoding failed";
+        }
+        for (uint16_t seq : seqs) {
+            uint8_t stamped[PROTOCOL_MAX_FRAME_LENGTH];
+            uint8_t encoded[PROTOCOL_MAX_FRAME_LENGTH];
+            size_t encoded_length = 0;
+            std::memcpy(stamped, original, length);
+            if (protocol_frame_set_seq(stamped, length, seq) != 0 ||
+                protocol_encode_frame_into(encoded, sizeof(encoded), descriptor.cmd_set, descriptor.cmd_id,
+                                           CMD_WAIT_RESULT, structure.data(), seq, &encoded_length) != 0 ||
+                encoded_length != length || std::memcmp(stamped, encoded, length) != 0) {
+                char error[96];
+                std::snprintf(error, sizeof(error), "%s SEQ 0x%04X: result differs from re-encoding with the new SEQ",
+                              descriptor_name(descriptor).c_str(), seq);
+                return error;
+            }
+        }
+    }
+    return "";
+}
+
+void bench_frames(Runner &runner) {
+    for (size_t size : payload_sizes) {
+        std::vector<uint8_t> payload = pattern(size);
+        std::vector<uint8_t> frame(PROTOCOL_FULL_FRAME_LENGTH(size));
+        std::memcpy(&frame[PROTOCOL_HEADER_LENGTH], payload.data(), size);
+        size_t frame_length = protocol_write_envelope(frame.data(), 0x1D, 0x02, 0x00, 0x1234, size);
+        std::string name = "protocol_parse_notification/" + std::to_string(size);
+
+        protocol_frame_t parsed;
+        if (protocol_parse_notification(frame.data(), frame_length, &parsed) != 0 || parsed.seq != 0x1234 ||
+            parsed.data_length != size + 2 || std::memcmp(parsed.data + 2, payload.data(), size) != 0) {
+            runner.fail(name, "frame written by protocol_write_envelope did not parse back");
+            continue;
+        }
+        runner.run(name, frame_length, [&] {
+            protocol_parse_notification(frame.data(), frame_length, &parsed);
+            keep(parsed);
+        });
+    }
+
+    // 以拍录控制命令为例，比较分配版本与写入调用方缓冲区的版本
+    record_control_command_frame_t command = {};
+    command.device_id = 0x33FF0000;
+    command.record_ctrl = 1;
+    uint8_t expected[PROTOCOL_MAX_FRAME_LENGTH];
+    size_t expected_length = 0;
+    if (protocol_encode_frame_into(expected, sizeof(expected), 0x1D, 0x03, CMD_WAIT_RESULT, &command, 7,
+                                   &expected_length) != 0) {
+        runner.fail("protocol_encode_frame_into/record_control", "encoding failed");
+        runner.fail("protocol_create_frame/record_control", "encoding failed");
+        return;
+    }
+    runner.run("protocol_encode_frame_into/record_control", expected_length, [&] {
+        uint8_t out[PROTOCOL_MAX_FRAME_LENGTH];
+        size_t length = 0;
+        protocol_encode_frame_into(out, sizeof(out), 0x1D, 0x03, CMD_WAIT_RESULT, &command, 7, &length);
+        keep(out);
+    });
+
+    size_t created_length = 0;
+    uint8_t *created = protocol_create_frame(0x1D, 0x03, CMD_WAIT_RESULT, &command, 7, &created_length);
+    bool same = created != nullptr && created_length == expected_length &&
+                std::memcmp(created, expected, expected_length) == 0;
+    dji_free(created);
+    if (!same) {
+        runner.fail("protocol_create_frame/record_control", "result differs from protocol_encode_frame_into");
+    } else {
+        runner.run("protocol_create_frame/record_control", expected_length, [&] {
+            size_t length = 0;
+            uint8_t *frame = protocol_create_frame(0x1D, 0x03, CMD_WAIT_RESULT, &command, 7, &length);
+            keep(frame);
+            dji_free(frame);
+        });
+    }
+
+    uint8_t stamped[PROTOCOL_MAX_FRAME_LENGTH];
+    std::memcpy(stamped, expected, expected_length);
+    std::string error = check_frame_set_seq();
+    if (!error.empty()) {
+        runner.fail("protocol_frame_set_seq/record_control", error);
+    } else {
+        uint16_t seq = 0;
+        runner.run("protocol_frame_set_seq/record_control", expected_length, [&] {
+            protocol_frame_set_seq(stamped, expected_length, seq++);
+            keep(stamped);
+        });
+    }
+
+    // 查找一次模板后每次发送只拷贝并改写 SEQ，即 OsmoDevice::send_frame_async 的编码开销
+    FrameTemplateCache cache;
+    const FrameTemplate *frame_template = cache.get(0x1D, 0x03, CMD_WAIT_RESULT, &command);
+    if (frame_template == nullptr || frame_template->stamp(7, stamped, sizeof(stamped)) != expected_length ||
+        std::memcmp(stamped, expected, expected_length) != 0) {
+        runner.fail("frame_template_stamp/record_control", "result differs from protocol_encode_frame_into");
+    } else {
+        uint16_t seq = 0;
+        runner.run("frame_template_stamp/record_control", expected_length, [&] {
+            frame_template->stamp(seq++, stamped, sizeof(stamped));
+            keep(stamped);
+        });
+    }
+}
+
+// 依次尝试应答帧与命令帧，返回解析器接受的第一种类型，都不接受时返回 -1
+int accepted_cmd_type(data_parser_func_t parser, const std::vector<uint8_t> &data, uint8_t *out) {
+    for (int cmd_type : {ACK_NO_RESPONSE, CMD_NO_RESPONSE}) {
+        if (parser(data.data(), data.size(), out, (uint8_t)cmd_type) == 0) {
+            return cmd_type;
+        }
+    }
+    return -1;
+}
+
+void bench_descriptors(Runner &runner) {
+    // 分别查找表中的第一项、中间一项、最后一项与不存在的键：查找开销与表项位置及表长无关时，四者耗时应相同
+    const std::pair<const char *, size_t> positions[] = {
+        {"first", 0},
+        {"middle", DATA_DESCRIPTORS_COUNT / 2},
+        {"last", DATA_DESCRIPTORS_COUNT - 1},
+    };
+    for (auto [position, index] : positions) {
+        const data_descriptor_t &descriptor = data_descriptors[index];
+        std::string name = std::string("find_data_descriptor/") + position;
+        if (find_data_descriptor(descriptor.cmd_set, descriptor.cmd_id) != &descriptor) {
+            runner.fail(name, "lookup did not return the table entry");
+            continue;
+        }
+        runner.run(name, 0, [&descriptor] { keep(find_data_descriptor(descriptor.cmd_set, descriptor.cmd_id)); });
+    }
+    runner.run("find_data_descriptor/miss", 0, [] { keep(find_data_descriptor(0x7F, 0x7F)); });
+
+    // 任何结构体都不超过 64 字节；解析输出留出柔性数组的空间
+    std::vector<uint8_t> structure = pattern(64);
+    std::vector<uint8_t> data = pattern(64);
+    alignas(8) uint8_t out[256];
+
+    for (size_t i = 0; i < DATA_DESCRIPTORS_COUNT; i++) {
+        const data_descriptor_t &descriptor = data_descriptors[i];
+        std::string key = descriptor_name(descriptor);
+
+        if (descriptor.encoder != nullptr) {
+            size_t length = 0;
+            if (descriptor.encoder(structure.data(), out, sizeof(out), &length, CMD_WAIT_RESULT) != 0) {
+                runner.fail("encoder/" + key, "encoder rejected a command structure");
+            } else {
+                runner.run("encoder/" + key, length, [&] {
+                    size_t written = 0;
+                    descriptor.encoder(structure.data(), out, sizeof(out), &written, CMD_WAIT_RESULT);
+                    keep(out);
+                });
+            }
+        }
+
+        if (descriptor.creator != nullptr) {
+            size_t length = 0;
+            uint8_t *created = descriptor.creator(structure.data(), &length, CMD_WAIT_RESULT);
+            size_t encoded = 0;
+            bool same = created != nullptr &&
+                        (descriptor.encoder == nullptr ||
+                         (descriptor.encoder(structure.data(), out, sizeof(out), &encoded, CMD_WAIT_RESULT) == 0 &&
+                          encoded == length && std::memcmp(created, out, length) == 0));
+            dji_free(created);
+            if (!same) {
+                runner.fail("creator/" + key, "creator failed or differs from the encoder");
+            } else {
+                runner.run("creator/" + key, length, [&] {
+                    size_t created_length = 0;
+                    uint8_t *payload = descriptor.creator(structure.data(), &created_length, CMD_WAIT_RESULT);
+                    keep(payload);
+                    dji_free(payload);
+                });
+            }
+        }
+
+        if (descriptor.parser != nullptr) {
+            int cmd_type = accepted_cmd_type(descriptor.parser, data, out);
+            if (cmd_type < 0) {
+                runner.fail("parser/" + key, "parser rejected both response and command payloads");
+                continue;
+            }
+            runner.run("parser/" + key, data.size(), [&] {
+                descriptor.parser(data.data(), data.size(), out, (uint8_t)cmd_type);
+                keep(out);
+            });
+
+            // protocol_parse_data 的输入以 CmdSet 与 CmdID 开头，输出结构体由库分配
+            std::vector<uint8_t> segment = {descriptor.cmd_set, descriptor.cmd_id};
+            segment.insert(segment.end(), data.begin(), data.end());
+            size_t parsed_length = 0;
+            void *parsed = protocol_parse_data(segment.data(), segment.size(), (uint8_t)cmd_type, &parsed_length);
+            bool ok = parsed != nullptr && parsed_length == data.size();
+            dji_free(parsed);
+            if (!ok) {
+                runner.fail("protocol_parse_data/" + key, "descriptor lookup or parse failed");
+                continue;
+            }
+            runner.run("protocol_parse_data/" + key, segment.size(), [&] {
+                size_t length = 0;
+                void *structure_out = protocol_parse_data(segment.data(), segment.size(), (uint8_t)cmd_type, &length);
+                keep(structure_out);
+                dji_free(structure_out);
+            });
+        }
+    }
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        if (arg == "--filter") {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time") {
+            options.min_time = std::atof(argv[++i]);
+        } else if (arg == "--repetitions") {
+            options.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--output") {
+            options.output = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return options.min_time > 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--filter <substring>] [--min-time <seconds>] [--repetitions <count>] "
+                             "[--output <path>]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    dji_set_allocator(counting_malloc, counting_free, nullptr);
+    dji_set_log_sink(discard_log, nullptr);
+
+    Runner runner(options);
+    bench_crc(runner);
+    bench_crc_algebra(runner);
+    bench_frames(runner);
+    bench_descriptors(runner);
+
+    std::string json = runner.json();
+    if (options.output.empty()) {
+        std::fputs(json.c_str(), stdout);
+    } else {
+        FILE *file = std::fopen(options.output.c_str(), "wb");
+        if (file == nullptr || std::fwrite(json.data(), 1, json.size(), file) != json.size()) {
+            std::fprintf(stderr, "Failed to write %s\n", options.output.c_str());
+            return 1;
+        }
+        std::fclose(file);
+    }
+    return runner.failed() ? 1 : 0;
+}
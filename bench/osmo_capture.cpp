@@ -0,0 +1,487 @@
+// 抓包文件的离线查询：建立旁路索引后按设备、命令、SEQ 与时间范围随机读取匹配的帧，只解析这些帧，每行输出一个 JSON
+//
+// 用法: osmo_capture index <抓包文件> [--index <路径>]
+//       osmo_capture query <抓包文件> [--index <路径>] [--device <地址|编号>] [--cmd <CmdSet>/<CmdID>] [--seq <n>]
+//                          [--from <时间>] [--to <时间>] [--limit <n>] [--hex]
+//       osmo_capture records <抓包文件> [--index <路径>] [--device <地址|编号>] [--from <时间>] [--to <时间>]
+//                            [--limit <n>]
+// 时间可以是抓包当天的本地时间 HH:MM[:SS[.ffffff]]、完整的 YYYY-MM-DD HH:MM[:SS[.ffffff]]，或相对抓包开始的 +<秒>；
+// 范围两端都包含在内。索引缺失或抓包文件在建立索引后发生变化时，query 与 records 会先重建索引
+// query 输出匹配的帧，请求的应答嵌套在 "response" 中；records 按记录输出原始数据
+#include <algorithm>
+#include <cctype>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "capture_file.hpp"
+#include "capture_index.hpp"
+#include "dji/dji_allocator.h"
+#include "dji/dji_log.h"
+#include "dji/dji_protocol_data_processor.h"
+#include "dji/dji_protocol_data_structures.h"
+#include "dji/enums_logic.h"
+
+namespace {
+
+struct Options {
+    std::string command;
+    std::string capture;
+    std::string index;
+    std::string device;
+    std::string cmd;
+    std::string seq;
+    std::string from;
+    std::string to;
+    uint64_t limit = UINT64_MAX;
+    bool hex = false;
+};
+
+bool parse_options(int argc, char **argv, Options &options) {
+    if (argc < 3) {
+        return false;
+    }
+    options.command = argv[1];
+    options.capture = argv[2];
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hex") {
+            options.hex = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--index") {
+            options.index = value;
+        } else if (arg == "--device") {
+            options.device = value;
+        } else if (arg == "--cmd") {
+            options.cmd = value;
+        } else if (arg == "--seq") {
+            options.seq = value;
+        } else if (arg == "--from") {
+            options.from = value;
+        } else if (arg == "--to") {
+            options.to = value;
+        } else if (arg == "--limit") {
+            options.limit = std::strtoull(value.c_str(), nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    if (options.index.empty()) {
+        options.index = CaptureIndex::default_path(options.capture);
+    }
+    return options.command == "index" || options.command == "query" || options.command == "records";
+}
+
+// Windows 上没有 localtime_r，对应的 localtime_s 参数顺序相反
+struct tm local_time(time_t seconds) {
+    struct tm tm = {};
+#ifdef _WIN32
+    localtime_s(&tm, &seconds);
+#else
+    localtime_r(&seconds, &tm);
+#endif
+    return tm;
+}
+
+bool equals_ignore_case(const std::string &a, const std::string &b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::tolower((unsigned char)x) == std::tolower((unsigned char)y);
+           });
+}
+
+// 解析 --from/--to，换算为抓包文件的单调时钟时间戳
+bool parse_time(const std::string &text, const CaptureFile &capture, int64_t &timestamp) {
+    const CaptureFileHeader &header = capture.header();
+    if (!text.empty() && text[0] == '+') {
+        char *end = nullptr;
+        double seconds = std::strtod(text.c_str() + 1, &end);
+        if (end == text.c_str() + 1 || *end != '\0') {
+            return false;
+        }
+        timestamp = header.monotonic_ns + (int64_t)(seconds * 1e9);
+        return true;
+    }
+
+    struct tm tm = local_time((time_t)(header.wall_clock_ns / 1000000000));
+    int hour = 0;
+    int minute = 0;
+    double second = 0;
+    int consumed = 0;
+    std::string clock = text;
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2d-%2d%n", &year, &month, &day, &consumed) == 3) {
+        if (text.size() <= (size_t)consumed + 1 || (text[consumed] != 'T' && text[consumed] != ' ')) {
+            return false;
+        }
+        tm.tm_year = year - 1900;
+        tm.tm_mon = month - 1;
+        tm.tm_mday = day;
+        clock = text.substr(consumed + 1);
+    }
+    consumed = 0;
+    int fields = std::sscanf(clock.c_str(), "%2d:%2d%n:%lf%n", &hour, &minute, &consumed, &second, &consumed);
+    if (fields < 2 || (size_t)consumed != clock.size() || hour > 23 || minute > 59 || second < 0 || second >= 61) {
+        return false;
+    }
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    time_t seconds = std::mktime(&tm);
+    if (seconds == (time_t)-1) {
+        return false;
+    }
+    int64_t wall_clock_ns = (int64_t)seconds * 1000000000 + (int64_t)(second * 1e9);
+    timestamp = header.monotonic_ns + (wall_clock_ns - header.wall_clock_ns);
+    return true;
+}
+
+std::string format_time(const CaptureFile &capture, int64_t timestamp) {
+    int64_t wall_clock_ns = capture.wall_clock_ns(timestamp);
+    struct tm tm = local_time((time_t)(wall_clock_ns / 1000000000));
+    char buffer[64];
+    size_t n = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::snprintf(buffer + n, sizeof(buffer) - n, ".%06d", (int)(wall_clock_ns % 1000000000 / 1000));
+    return buffer;
+}
+
+std::string hex(const uint8_t *data, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        text[2 * i] = digits[data[i] >> 4];
+        text[2 * i + 1] = digits[data[i] & 0x0F];
+    }
+    return text;
+}
+
+std::string json_string(const std::string &text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+bool parse_number(const std::string &text, int base, unsigned long max, unsigned long &value) {
+    char *end = nullptr;
+    value = std::strtoul(text.c_str(), &end, base);
+    return !text.empty() && *end == '\0' && value <= max;
+}
+
+// --cmd 的 CmdSet/CmdID 按十六进制解析，如 1D/03
+bool parse_cmd(const std::string &text, uint8_t &cmd_set, uint8_t &cmd_id) {
+    size_t slash = text.find('/');
+    unsigned long set = 0;
+    unsigned long id = 0;
+    if (slash == std::string::npos || !parse_number(text.substr(0, slash), 16, 0xFF, set) ||
+        !parse_number(text.substr(slash + 1), 16, 0xFF, id)) {
+        return false;
+    }
+    cmd_set = (uint8_t)set;
+    cmd_id = (uint8_t)id;
+    return true;
+}
+
+class Query {
+public:
+    Query(const CaptureFile &capture, const CaptureIndex &index, bool with_hex)
+        : capture_(capture), index_(index), hex_(with_hex) {
+        CaptureFile::Record record;
+        for (const CaptureIndexDevice &device : index.devices()) {
+            if (capture.read(device.offset, record) && record.type() == CaptureType::Device) {
+                addresses_[device.device].assign((const char *)record.data, record.length());
+            }
+        }
+        for (const CaptureIndexBlock &block : index.blocks()) {
+            first_ = std::min(first_, block.first_timestamp);
+            last_ = std::max(last_, block.last_timestamp);
+        }
+    }
+
+    const std::map<uint32_t, std::string> &addresses() const { return addresses_; }
+    // 抓包中记录时间戳的范围，索引中超出它的帧必然已损坏
+    int64_t first() const { return first_; }
+    int64_t last() const { return last_; }
+
+    // 帧的一行 JSON；请求的应答作为 "response" 嵌套输出
+    std::string describe(const CaptureIndexFrame &frame, bool with_peer = true) const {
+        std::ostringstream json;
+        auto address = addresses_.find(frame.device);
+        char head[160];
+        std::snprintf(head, sizeof(head),
+                      ", \"device\": %" PRIu32 ", \"direction\": \"%s\", \"cmd\": \"%02X/%02X\", \"cmd_type\": "
+                      "\"0x%02X\", \"seq\": %u, \"length\": %u, \"offset\": %" PRIu64,
+                      frame.device, frame.direction == (uint8_t)CaptureType::Write ? "write" : "notify",
+                      frame.cmd_set, frame.cmd_id, frame.cmd_type, frame.seq, frame.frame_length, frame.offset);
+        json << "{\"time\": \"" << format_time(capture_, frame.timestamp) << "\"" << head;
+        if (address != addresses_.end()) {
+            json << ", \"address\": " << json_string(address->second);
+        }
+        json << decode(frame);
+
+        const CaptureIndexFrame *peer = index_.peer(frame);
+        if (with_peer && peer != nullptr && !frame.is_response() && peer->timestamp >= first_ &&
+            peer->timestamp <= last_) {
+            json << ", \"latency_us\": " << peer->timestamp / 1000 - frame.timestamp / 1000;
+            json << ", \"response\": " << describe(*peer, false);
+        }
+        json << "}";
+        return json.str();
+    }
+
+private:
+    // 重新校验帧并用描述符解析数据段，只对匹配的帧进行
+    std::string decode(const CaptureIndexFrame &frame) const {
+        uint8_t bytes[PROTOCOL_MAX_FRAME_LENGTH];
+        size_t length = CaptureIndex::read_frame(capture_, frame, bytes);
+        if (length == 0) {
+            return ", \"status\": \"unavailable\"";
+        }
+        std::string out = hex_ ? ", \"frame\": \"" + hex(bytes, length) + "\"" : "";
+        protocol_frame_t parsed;
+        if (protocol_parse_notification(bytes, length, &parsed) != 0) {
+            return out + ", \"status\": \"invalid\"";
+        }
+        if (find_data_descriptor(frame.cmd_set, frame.cmd_id) == nullptr) {
+            return out + ", \"status\": \"unknown\", \"data\": \"" + hex(parsed.data + 2, parsed.data_length - 2) +
+                   "\"";
+        }
+        size_t structure_length = 0;
+        void *structure = protocol_parse_data(parsed.data, parsed.data_length, parsed.cmd_type, &structure_length);
+        if (structure == nullptr) {
+            // 多数描述符不解析命令帧，而命令帧的数据段就是编码器拷贝的紧凑结构体，可读字段直接从数据段取
+            return out + ", \"status\": \"unparsed\", \"data\": \"" + hex(parsed.data + 2, parsed.data_length - 2) +
+                   "\"" + fields(frame, parsed.data + 2, parsed.data_length - 2);
+        }
+        out += ", \"status\": \"ok\", \"structure\": \"" + hex((const uint8_t *)structure, structure_length) + "\"";
+        out += fields(frame, structure, structure_length);
+        dji_free(structure);
+        return out;
+    }
+
+    // 常用消息的可读字段，其余消息只输出解析后的结构体
+    static std::string fields(const CaptureIndexFrame &frame, const void *structure, size_t length) {
+        uint16_t key = (uint16_t)(frame.cmd_set << 8 | frame.cmd_id);
+        char buffer[256];
+        if (key == 0x1D02 && !frame.is_response() && length >= sizeof(camera_status_push_command_frame)) {
+            camera_status_push_command_frame status;
+            std::memcpy(&status, structure, sizeof(status));
+            std::snprintf(buffer, sizeof(buffer),
+                          ", \"fields\": {\"camera_mode\": \"%s\", \"camera_status\": \"%s\", \"video_resolution\": "
+                          "\"%s\", \"fps\": \"%s\", \"eis_mode\": \"%s\", \"record_time\": %u, \"battery\": %u}",
+                          camera_mode_to_string((camera_mode_t)status.camera_mode),
+                          camera_status_to_string((camera_status_t)status.camera_status),
+                          video_resolution_to_string((video_resolution_t)status.video_resolution),
+                          fps_idx_to_string((fps_idx_t)status.fps_idx), eis_mode_to_string((eis_mode_t)status.eis_mode),
+                          status.record_time, status.camera_bat_percentage);
+        } else if (key == 0x1D03 && !frame.is_response() && length >= sizeof(record_control_command_frame_t)) {
+            record_control_command_frame_t command;
+            std::memcpy(&command, structure, sizeof(command));
+            std::snprintf(buffer, sizeof(buffer), ", \"fields\": {\"record_ctrl\": \"%s\"}",
+                          command.record_ctrl == 0 ? "start" : "stop");
+        } else if (key == 0x1D04 && !frame.is_response() && length >= sizeof(camera_mode_switch_command_frame_t)) {
+            camera_mode_switch_command_frame_t command;
+            std::memcpy(&command, structure, sizeof(command));
+            std::snprintf(buffer, sizeof(buffer), ", \"fields\": {\"mode\": \"%s\"}",
+                          camera_mode_to_string((camera_mode_t)command.mode));
+        } else if (key == 0x0011 && !frame.is_response() && length >= sizeof(key_report_command_frame_t)) {
+            key_report_command_frame_t report;
+            std::memcpy(&report, structure, sizeof(report));
+            std::snprintf(buffer, sizeof(buffer), ", \"fields\": {\"key_code\": %u, \"mode\": %u, \"key_value\": %u}",
+                          report.key_code, report.mode, report.key_value);
+        } else if (frame.is_response() && (key == 0x1D03 || key == 0x1D04 || key == 0x0011) && length >= 1) {
+            // 这几个应答的第一个字节都是返回码
+            std::snprintf(buffer, sizeof(buffer), ", \"fields\": {\"ret_code\": %u}",
+                          *static_cast<const uint8_t *>(structure));
+        } else {
+            return "";
+        }
+        return buffer;
+    }
+
+    const CaptureFile &capture_;
+    const CaptureIndex &index_;
+    const bool hex_;
+    std::map<uint32_t, std::string> addresses_;
+    int64_t first_ = INT64_MAX;
+    int64_t last_ = INT64_MIN;
+};
+
+void quiet_log(int, const char *, const char *, va_list, void *) {}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s index <capture> [--index <path>]\n"
+                     "       %s query <capture> [--index <path>] [--device <address|id>] [--cmd <set>/<id>] "
+                     "[--seq <n>] [--from <time>] [--to <time>] [--limit <n>] [--hex]\n"
+                     "       %s records <capture> [--index <path>] [--device <address|id>] [--from <time>] "
+                     "[--to <time>] [--limit <n>]\n",
+                     argv[0], argv[0], argv[0]);
+        return 2;
+    }
+    // 校验失败的帧在输出中以 status 标出，不再重复打印协议库日志
+    dji_set_log_sink(quiet_log, nullptr);
+
+    try {
+        CaptureFile capture(options.capture);
+        bool rebuild = options.command == "index";
+        if (!rebuild) {
+            try {
+                rebuild = !CaptureIndex(options.index).matches(capture);
+            } catch (const std::exception &) {
+                rebuild = true;
+            }
+        }
+        if (rebuild) {
+            CaptureIndex::BuildStats stats = CaptureIndex::build(capture, options.index);
+            if (options.command == "index") {
+                CaptureIndex index(options.index);
+                std::printf("{\"index\": %s, \"records\": %" PRIu64 ", \"frames\": %" PRIu64 ", \"pairs\": %" PRIu64
+                            ", \"unanswered\": %" PRIu64 ", \"orphan_responses\": %" PRIu64
+                            ", \"bytes_discarded\": %" PRIu64 ", \"crc_errors\": %" PRIu64 ", \"commands\": {",
+                            json_string(options.index).c_str(), stats.records, stats.frames, stats.pairs,
+                            stats.unanswered, stats.orphan_responses, stats.bytes_discarded, stats.crc_errors);
+                for (size_t i = 0; i < index.keys().size(); i++) {
+                    const CaptureIndexKey &key = index.keys()[i];
+                    std::printf("%s\"%02X/%02X\": %" PRIu32, i == 0 ? "" : ", ", key.cmd_set, key.cmd_id, key.count);
+                }
+                std::printf("}}\n");
+                return 0;
+            }
+        }
+
+        CaptureIndex index(options.index);
+        Query query(capture, index, options.hex);
+
+        int64_t from = INT64_MIN;
+        int64_t to = INT64_MAX;
+        if ((!options.from.empty() && !parse_time(options.from, capture, from)) ||
+            (!options.to.empty() && !parse_time(options.to, capture, to))) {
+            std::fprintf(stderr, "Invalid time, expected HH:MM[:SS], YYYY-MM-DD HH:MM[:SS] or +<seconds>\n");
+            return 2;
+        }
+        from = std::max(from, query.first());
+        to = std::min(to, query.last());
+        std::set<uint32_t> devices;
+        for (const auto &[id, address] : query.addresses()) {
+            unsigned long number = 0;
+            if (options.device.empty() || equals_ignore_case(options.device, address) ||
+                (parse_number(options.device, 10, UINT32_MAX, number) && number == id)) {
+                devices.insert(id);
+            }
+        }
+        if (devices.empty() && !options.device.empty()) {
+            std::fprintf(stderr, "No device matches %s\n", options.device.c_str());
+            return 1;
+        }
+
+        if (options.command == "records") {
+            // 块之间可能重叠，逐块检查时间范围而不是二分查找
+            uint64_t printed = 0;
+            for (const CaptureIndexBlock &block : index.blocks()) {
+                if (block.last_timestamp < from || block.first_timestamp > to) {
+                    continue;
+                }
+                capture.for_each(
+                    [&](const CaptureFile::Record &record) {
+                        if (record.offset >= block.end || printed >= options.limit) {
+                            return false;
+                        }
+                        if (record.type() != CaptureType::Device && record.header->timestamp >= from &&
+                            record.header->timestamp <= to && devices.count(record.header->device) != 0) {
+                            std::printf("{\"time\": \"%s\", \"device\": %" PRIu32
+                                        ", \"direction\": \"%s\", \"offset\": %zu, \"data\": \"%s\"}\n",
+                                        format_time(capture, record.header->timestamp).c_str(), record.header->device,
+                                        record.type() == CaptureType::Write ? "write" : "notify", record.offset,
+                                        hex(record.data, record.length()).c_str());
+                            printed++;
+                        }
+                        return true;
+                    },
+                    block.offset);
+            }
+            return 0;
+        }
+
+        uint8_t cmd_set = 0;
+        uint8_t cmd_id = 0;
+        unsigned long seq = 0;
+        if ((!options.cmd.empty() && !parse_cmd(options.cmd, cmd_set, cmd_id)) ||
+            (!options.seq.empty() && !parse_number(options.seq, 10, UINT16_MAX, seq))) {
+            std::fprintf(stderr, "Invalid --cmd or --seq, expected e.g. --cmd 1D/03 --seq 12\n");
+            return 2;
+        }
+        auto selected = [&](const CaptureIndexFrame &frame) {
+            return frame.timestamp >= from && frame.timestamp <= to && devices.count(frame.device) != 0 &&
+                   (options.cmd.empty() || (frame.cmd_set == cmd_set && frame.cmd_id == cmd_id));
+        };
+
+        std::vector<const CaptureIndexFrame *> matches;
+        if (!options.seq.empty()) {
+            for (uint32_t device : devices) {
+                for (const CaptureIndexPair &pair : index.pairs(device, (uint16_t)seq)) {
+                    const CaptureIndexFrame *frame =
+                        index.frame(pair.request != capture_index_none ? pair.request : pair.response);
+                    if (frame != nullptr && selected(*frame)) {
+                        matches.push_back(frame);
+                    }
+                }
+            }
+        } else {
+            for (const CaptureIndexKey &key : index.keys()) {
+                if (!options.cmd.empty() && (key.cmd_set != cmd_set || key.cmd_id != cmd_id)) {
+                    continue;
+                }
+                for (const CaptureIndexFrame &frame : index.frames(key.cmd_set, key.cmd_id, from, to)) {
+                    // 请求也在范围内时，应答随请求一起输出
+                    const CaptureIndexFrame *peer = index.peer(frame);
+                    if (selected(frame) && !(frame.is_response() && peer != nullptr && selected(*peer))) {
+                        matches.push_back(&frame);
+                    }
+                }
+            }
+        }
+        std::stable_sort(matches.begin(), matches.end(), [](const CaptureIndexFrame *a, const CaptureIndexFrame *b) {
+            return a->timestamp < b->timestamp;
+        });
+        if (matches.size() > options.limit) {
+            matches.resize(options.limit);
+        }
+        for (const CaptureIndexFrame *frame : matches) {
+            std::printf("%s\n", query.describe(*frame).c_str());
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,195 @@
+// 把抓包文件中的通知按原速、N 倍速或最快速度送回主机协议栈（解码、应答匹配与分发），结果以 JSON 输出
+//
+// 用法: osmo_replay <抓包文件> [--speed <倍数>|max] [--output <路径>] [--metrics <路径>]
+// --metrics 写出回放结束时的 Prometheus 文本，包含每台设备的解码错误与分发计数
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_file.hpp"
+#include "capture_replayer.hpp"
+#include "dji/dji_log.h"
+#include "metrics.hpp"
+#include "osmo_device.hpp"
+
+namespace {
+
+struct Options {
+    std::string capture;
+    double speed = 1;
+    std::string output;
+    std::string metrics;
+};
+
+// 带引号的 JSON 字符串，路径中可能含有引号、反斜杠（Windows）或控制字符
+std::string json_string(const std::string &text) {
+    std::string out = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        } else if (c < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            out += buffer;
+        } else {
+            out += (char)c;
+        }
+    }
+    return out + "\"";
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            if (!options.capture.empty()) {
+                return false;
+            }
+            options.capture = arg;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--speed") {
+            options.speed = value == "max" ? 0 : std::atof(value.c_str());
+            if (options.speed <= 0 && value != "max") {
+                return false;
+            }
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--metrics") {
+            options.metrics = value;
+        } else {
+            return false;
+        }
+    }
+    return !options.capture.empty();
+}
+
+// 通知已全部投递后，等读取线程与分发线程处理完积压的帧：分发计数 50ms 内不再变化即认为结束
+uint64_t dispatched(const std::vector<std::unique_ptr<OsmoDevice>> &devices) {
+    uint64_t total = 0;
+    for (const auto &device : devices) {
+        Dispatcher::Stats stats = device->dispatcher_stats();
+        total += stats.delivered + stats.unhandled + stats.dropped;
+    }
+    return total;
+}
+
+void settle(const std::vector<std::unique_ptr<OsmoDevice>> &devices) {
+    uint64_t last = dispatched(devices);
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        uint64_t now = dispatched(devices);
+        if (now == last) {
+            return;
+        }
+        last = now;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s <capture> [--speed <factor>|max] [--output <path>] [--metrics <path>]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    // 设备日志写到标准错误，标准输出只留给 JSON 结果
+    dji_set_log_sink(dji_log_stderr_sink, nullptr);
+
+    try {
+        CaptureFile file(options.capture);
+        CaptureReplayer replayer(file);
+        MetricsRegistry registry;
+
+        // 订阅状态推送与按键上报，使它们像实时运行时一样被交给处理函数
+        std::atomic<uint64_t> status_pushes = 0;
+        std::atomic<uint64_t> key_reports = 0;
+        std::vector<std::unique_ptr<OsmoDevice>> devices;
+        for (const auto &[id, address] : replayer.devices()) {
+            devices.push_back(
+                std::make_unique<OsmoDevice>("00:00:00:00:00:00", replayer.create_transport(id), registry));
+            devices.back()->subscribe<camera_status_push_command_frame>(
+                [&status_pushes](const MessageView<camera_status_push_command_frame> &) {
+                    status_pushes.fetch_add(1, std::memory_order_relaxed);
+                });
+            devices.back()->subscribe<key_report_command_frame_t>(
+                [&key_reports](const MessageView<key_report_command_frame_t> &) {
+                    key_reports.fetch_add(1, std::memory_order_relaxed);
+                });
+        }
+
+        CaptureReplayer::Stats stats = replayer.run(options.speed);
+        settle(devices);
+
+        Dispatcher::Stats dispatch;
+        for (const auto &device : devices) {
+            Dispatcher::Stats device_stats = device->dispatcher_stats();
+            dispatch.delivered += device_stats.delivered;
+            dispatch.unhandled += device_stats.unhandled;
+            dispatch.dropped += device_stats.dropped;
+        }
+        if (!options.metrics.empty()) {
+            std::string text = registry.prometheus_text();
+            FILE *metrics = std::fopen(options.metrics.c_str(), "wb");
+            if (metrics == nullptr || std::fwrite(text.data(), 1, text.size(), metrics) != text.size()) {
+                std::fprintf(stderr, "Failed to write %s\n", options.metrics.c_str());
+                return 1;
+            }
+            std::fclose(metrics);
+        }
+        devices.clear();
+
+        auto seconds = [](CaptureReplayer::Clock::duration duration) {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.6f", std::chrono::duration<double>(duration).count());
+            return std::string(buffer);
+        };
+        std::ostringstream json;
+        json << "{\n";
+        json << "  \"capture\": " << json_string(options.capture) << ",\n";
+        json << "  \"speed\": " << (options.speed > 0 ? std::to_string(options.speed) : "\"max\"") << ",\n";
+        json << "  \"devices\": " << replayer.devices().size() << ",\n";
+        json << "  \"notifications\": " << stats.notifications << ",\n";
+        json << "  \"bytes\": " << stats.bytes << ",\n";
+        json << "  \"skipped\": " << stats.skipped << ",\n";
+        json << "  \"host_writes\": " << stats.writes << ",\n";
+        json << "  \"captured_seconds\": " << seconds(stats.captured) << ",\n";
+        json << "  \"replay_seconds\": " << seconds(stats.elapsed) << ",\n";
+        json << "  \"max_lag_seconds\": " << seconds(stats.max_lag) << ",\n";
+        json << "  \"dispatched\": {\"delivered\": " << dispatch.delivered << ", \"unhandled\": " << dispatch.unhandled
+             << ", \"dropped\": " << dispatch.dropped << "},\n";
+        json << "  \"status_pushes\": " << status_pushes.load() << ",\n";
+        json << "  \"key_reports\": " << key_reports.load() << "\n";
+        json << "}\n";
+
+        std::string text = json.str();
+        if (options.output.empty()) {
+            std::fputs(text.c_str(), stdout);
+        } else {
+            FILE *output = std::fopen(options.output.c_str(), "wb");
+            if (output == nullptr || std::fwrite(text.data(), 1, text.size(), output) != text.size()) {
+                std::fprintf(stderr, "Failed to write %s\n", options.output.c_str());
+                return 1;
+            }
+            std::fclose(output);
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,272 @@
+// 在模拟相机上运行完整的主机协议栈：每台虚拟相机对应一个 OsmoDevice，完成连接握手后周期性地切换录制状态，
+// 结果以 JSON 输出。链路损伤参数同时作用于两个方向（--fragment 只作用于通知），相同 --seed 得到相同的损伤
+//
+// 用法: osmo_sim [--cameras <数量>] [--seconds <秒>] [--interval-ms <毫秒>] [--status-ms <毫秒>]
+//               [--response-us <微秒>] [--mtu <字节>] [--timeout-ms <毫秒>] [--output <路径>] [--capture <路径>]
+//               [--latency-us <微秒>] [--jitter-us <微秒>] [--distribution uniform|normal|pareto] [--loss <概率>]
+//               [--duplicate <概率>] [--reorder <概率>] [--bandwidth <字节每秒>] [--fragment <字节>] [--seed <种子>]
+// 设备日志打印到标准错误，标准输出只有 JSON 结果；需要单独保存结果时使用 --output
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "camera_simulator.hpp"
+#include "capture.hpp"
+#include "dji/dji_log.h"
+#include "event_loop.hpp"
+#include "link_emulator.hpp"
+#include "metrics.hpp"
+#include "osmo_device.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    size_t cameras = 100;
+    double seconds = 5;
+    std::chrono::milliseconds interval{100};
+    std::chrono::milliseconds status{500};
+    std::chrono::microseconds response{2000};
+    size_t mtu = 244;
+    std::chrono::milliseconds timeout{5000};
+    std::string output;
+    std::string capture;
+    LinkEmulator::Config link;
+};
+
+struct Totals {
+    std::atomic<uint64_t> connected = 0;
+    std::atomic<uint64_t> connect_failures = 0;
+    std::atomic<uint64_t> commands = 0;
+    std::atomic<uint64_t> command_failures = 0;
+    std::atomic<uint64_t> status_pushes = 0;
+    std::atomic<size_t> finished = 0;
+    Histogram connect_time;
+    Histogram round_trip;
+    // 命令发出至以失败完成的时间，链路无应答时应接近 --timeout-ms
+    Histogram failed_after;
+};
+
+// 连接后交替发送开始与停止录制，直到 end；各设备的起始时间在一个 interval 内均匀错开
+Task<void> drive(OsmoDevice &device, EventLoop &loop, size_t index, const Options &options, Clock::time_point end,
+                 Totals &totals) {
+    Clock::time_point start = Clock::now();
+    if (co_await device.connect()) {
+        totals.connect_time.observe(Clock::now() - start);
+        totals.connected.fetch_add(1, std::memory_order_relaxed);
+
+        co_await loop.sleep_for(options.interval * index / options.cameras);
+        record_control_command_frame_t record = {};
+        record.device_id = 0xFF33;
+        while (Clock::now() < end) {
+            record.record_ctrl = record.record_ctrl == 0 ? 1 : 0;
+            Clock::time_point sent = Clock::now();
+            auto response = co_await device.send(record, CMD_WAIT_RESULT, options.timeout);
+            if (response && response->ret_code == 0) {
+                totals.round_trip.observe(Clock::now() - sent);
+                totals.commands.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                totals.failed_after.observe(Clock::now() - sent);
+                totals.command_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            co_await loop.sleep_for(options.interval);
+        }
+    } else {
+        totals.connect_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (totals.finished.fetch_add(1) + 1 == options.cameras) {
+        loop.stop();
+    }
+}
+
+bool parse_options(int argc, char **argv, Options &options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        const char *value = argv[++i];
+        if (arg == "--cameras") {
+            options.cameras = (size_t)std::atoll(value);
+        } else if (arg == "--seconds") {
+            options.seconds = std::atof(value);
+        } else if (arg == "--interval-ms") {
+            options.interval = std::chrono::milliseconds(std::atoll(value));
+        } else if (arg == "--status-ms") {
+            options.status = std::chrono::milliseconds(std::atoll(value));
+        } else if (arg == "--response-us") {
+            options.response = std::chrono::microseconds(std::atoll(value));
+        } else if (arg == "--mtu") {
+            options.mtu = (size_t)std::atoll(value);
+        } else if (arg == "--timeout-ms") {
+            options.timeout = std::chrono::milliseconds(std::atoll(value));
+        } else if (arg == "--output") {
+            options.output = value;
+        } else if (arg == "--capture") {
+            options.capture = value;
+        } else if (arg == "--latency-us") {
+            options.link.write.latency = std::chrono::microseconds(std::atoll(value));
+        } else if (arg == "--jitter-us") {
+            options.link.write.jitter = std::chrono::microseconds(std::atoll(value));
+        } else if (arg == "--distribution") {
+            std::string name = value;
+            if (name == "uniform") {
+                options.link.write.distribution = LinkEmulator::Distribution::Uniform;
+            } else if (name == "normal") {
+                options.link.write.distribution = LinkEmulator::Distribution::Normal;
+            } else if (name == "pareto") {
+                options.link.write.distribution = LinkEmulator::Distribution::Pareto;
+            } else {
+                return false;
+            }
+        } else if (arg == "--loss") {
+            options.link.write.loss = std::atof(value);
+        } else if (arg == "--duplicate") {
+            options.link.write.duplicate = std::atof(value);
+        } else if (arg == "--reorder") {
+            options.link.write.reorder = std::atof(value);
+        } else if (arg == "--bandwidth") {
+            options.link.write.bandwidth = (uint64_t)std::atoll(value);
+        } else if (arg == "--fragment") {
+            options.link.notify.fragment = (size_t)std::atoll(value);
+        } else if (arg == "--seed") {
+            options.link.seed = (uint64_t)std::strtoull(value, nullptr, 0);
+        } else {
+            return false;
+        }
+    }
+    // 两个方向使用相同的损伤，通知另外可以分片
+    size_t fragment = options.link.notify.fragment;
+    options.link.notify = options.link.write;
+    options.link.notify.fragment = fragment;
+    return options.cameras > 0 && options.seconds > 0 && options.interval.count() > 0 && options.mtu > 0;
+}
+
+std::string quantiles(const Histogram::Snapshot &snapshot) {
+    char buffer[160];
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"count\": %llu, \"p50\": %llu, \"p90\": %llu, \"p99\": %llu, \"max\": %llu}",
+                  (unsigned long long)snapshot.count, (unsigned long long)snapshot.quantile(0.5),
+                  (unsigned long long)snapshot.quantile(0.9), (unsigned long long)snapshot.quantile(0.99),
+                  (unsigned long long)snapshot.quantile(1.0));
+    return buffer;
+}
+
+std::string link_stats(const LinkEmulator::DirectionStats &stats) {
+    std::ostringstream json;
+    json << "{\"packets\": " << stats.packets << ", \"dropped\": " << stats.dropped
+         << ", \"duplicated\": " << stats.duplicated << ", \"reordered\": " << stats.reordered
+         << ", \"fragments\": " << stats.fragments << ", \"delivered\": " << stats.delivered
+         << ", \"failed\": " << stats.failed << "}";
+    return json.str();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--cameras <count>] [--seconds <seconds>] [--interval-ms <ms>] [--status-ms <ms>] "
+                     "[--response-us <us>] [--mtu <bytes>] [--timeout-ms <ms>] [--output <path>] [--capture <path>] "
+                     "[--latency-us <us>] [--jitter-us <us>] [--distribution uniform|normal|pareto] [--loss <p>] "
+                     "[--duplicate <p>] [--reorder <p>] [--bandwidth <bytes/s>] [--fragment <bytes>] [--seed <seed>]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    // 设备日志写到标准错误，标准输出只留给 JSON 结果
+    dji_set_log_sink(dji_log_stderr_sink, nullptr);
+
+    CameraSimulator::Config config;
+    config.mtu = options.mtu;
+    config.response_delay = options.response;
+    config.status_interval = options.status;
+    CameraSimulator simulator(config);
+    LinkEmulator link(options.link);
+
+    // 每台设备的指标都带地址标签，使用独立的注册表，避免上千台设备的序列留在全局注册表中
+    MetricsRegistry registry;
+    // 记录主机侧收发的原始数据，供 osmo_replay 回放
+    std::optional<CaptureWriter> capture;
+    if (!options.capture.empty()) {
+        capture.emplace(options.capture);
+    }
+    EventLoop loop;
+    Totals totals;
+
+    std::vector<std::unique_ptr<OsmoDevice>> devices;
+    devices.reserve(options.cameras);
+    for (size_t i = 0; i < options.cameras; i++) {
+        devices.push_back(std::make_unique<OsmoDevice>("00:00:00:00:00:00", link.wrap(simulator.create_camera()),
+                                                       registry));
+        devices.back()->set_event_loop(&loop);
+        if (capture) {
+            devices.back()->set_capture(&*capture);
+        }
+        devices.back()->subscribe<camera_status_push_command_frame>(
+            [&totals](const MessageView<camera_status_push_command_frame> &) {
+                totals.status_pushes.fetch_add(1, std::memory_order_relaxed);
+            });
+    }
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(options.seconds));
+    for (size_t i = 0; i < options.cameras; i++) {
+        spawn(loop, drive(*devices[i], loop, i, options, end, totals));
+    }
+    loop.run();
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    devices.clear();
+
+    CameraSimulator::Stats stats = simulator.stats();
+    char rate[32];
+    std::snprintf(rate, sizeof(rate), "%.1f", totals.commands.load() / elapsed);
+    char seconds[32];
+    std::snprintf(seconds, sizeof(seconds), "%.3f", elapsed);
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"cameras\": " << options.cameras << ",\n";
+    json << "  \"seconds\": " << seconds << ",\n";
+    json << "  \"connected\": " << totals.connected.load() << ",\n";
+    json << "  \"connect_failures\": " << totals.connect_failures.load() << ",\n";
+    json << "  \"connect_us\": " << quantiles(totals.connect_time.snapshot()) << ",\n";
+    json << "  \"commands\": " << totals.commands.load() << ",\n";
+    json << "  \"command_failures\": " << totals.command_failures.load() << ",\n";
+    json << "  \"commands_per_second\": " << rate << ",\n";
+    json << "  \"round_trip_us\": " << quantiles(totals.round_trip.snapshot()) << ",\n";
+    json << "  \"failed_after_us\": " << quantiles(totals.failed_after.snapshot()) << ",\n";
+    json << "  \"status_pushes_received\": " << totals.status_pushes.load() << ",\n";
+    json << "  \"simulator\": {\"frames_received\": " << stats.frames_received
+         << ", \"frames_sent\": " << stats.frames_sent << ", \"status_pushes\": " << stats.status_pushes
+         << ", \"handshakes\": " << stats.handshakes << ", \"unhandled\": " << stats.unhandled
+         << ", \"notifications\": " << stats.notifications << ", \"bytes_notified\": " << stats.bytes_notified
+         << "},\n";
+    json << "  \"link\": {\"notify\": " << link_stats(link.stats().notify)
+         << ", \"write\": " << link_stats(link.stats().write) << "}\n";
+    json << "}\n";
+
+    std::string text = json.str();
+    if (options.output.empty()) {
+        std::fputs(text.c_str(), stdout);
+    } else {
+        FILE *file = std::fopen(options.output.c_str(), "wb");
+        if (file == nullptr || std::fwrite(text.data(), 1, text.size(), file) != text.size()) {
+            std::fprintf(stderr, "Failed to write %s\n", options.output.c_str());
+            return 1;
+        }
+        std::fclose(file);
+    }
+    // 有链路损伤时失败是被测量的结果，只有无损链路上的失败才算错误
+    bool impaired = options.link.notify.active() || options.link.write.active();
+    return impaired || (totals.connect_failures.load() == 0 && totals.command_failures.load() == 0) ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dji/dji_log.h"
+#include "transport.hpp"
+
+#include <simpleble/SimpleBLE.h>
+
+/**
+ * @brief Transport over a SimpleBLE peripheral, using the fff4 notify and fff5 write characteristics of service fff0
+ *        基于 SimpleBLE 外设的传输层，使用 fff0 服务下的 fff4 通知特征与 fff5 写入特征
+ */
+class BleTransport : public Transport {
+public:
+    explicit BleTransport(SimpleBLE::Peripheral peripheral) : peripheral_(std::move(peripheral)) {}
+
+    void connect() override {
+        peripheral_.connect();
+        ESP_LOGI("BLE", "Device mtu is %zu", (size_t)peripheral_.mtu());
+
+        // 找到所有的 UUID
+        std::vector<std::pair<SimpleBLE::BluetoothUUID, SimpleBLE::BluetoothUUID>> uuids;
+        for (auto service : peripheral_.services()) {
+            for (auto characteristic : service.characteristics()) {
+                uuids.push_back(std::make_pair(service.uuid(), characteristic.uuid()));
+            }
+        }
+
+        // 打印所有的 UUID
+        ESP_LOGD("BLE", "The following services and characteristics were found:");
+        for (size_t i = 0; i < uuids.size(); i++) {
+            ESP_LOGD("BLE", "[%zu] %s %s", i, uuids[i].first.c_str(), uuids[i].second.c_str());
+        }
+
+        for (auto uuid : uuids) {
+            if (uuid.first.find("fff0") != std::string::npos && uuid.second.find("fff4") != std::string::npos) {
+                service_uuid_ = uuid.first;
+                notify_uuid_ = uuid.second;
+                ESP_LOGI("BLE", "Found notify characteristic %s of service %s", notify_uuid_.c_str(),
+                         service_uuid_.c_str());
+            }
+            if (uuid.first.find("fff0") != std::string::npos && uuid.second.find("fff5") != std::string::npos) {
+                service_uuid_ = uuid.first;
+                write_uuid_ = uuid.second;
+                ESP_LOGI("BLE", "Found write characteristic %s of service %s", write_uuid_.c_str(),
+                         service_uuid_.c_str());
+            }
+        }
+        if (notify_uuid_.empty() || write_uuid_.empty()) {
+            throw std::runtime_error("Osmo notify or write characteristic not found");
+        }
+    }
+
+    void disconnect() override {
+        if (peripheral_.is_connected()) {
+            peripheral_.disconnect();
+        }
+    }
+
+    bool is_connected() override { return peripheral_.is_connected(); }
+
+    std::string address() override { return peripheral_.address(); }
+
+    // SimpleBLE 报告的 mtu 已扣除 ATT 头，即单次写操作可携带的字节数
+    size_t mtu() override { return peripheral_.mtu(); }
+
+    void subscribe(NotifyCallback callback) override {
+        peripheral_.notify(service_uuid_, notify_uuid_,
+                           [callback = std::move(callback)](SimpleBLE::ByteArray data) {
+                               callback(data.data(), data.size());
+                           });
+    }
+
+    void write(const uint8_t *data, size_t length) override {
+        peripheral_.write_command(service_uuid_, write_uuid_, SimpleBLE::ByteArray(data, length));
+    }
+
+private:
+    SimpleBLE::Peripheral peripheral_;
+    std::string service_uuid_;
+    std::string notify_uuid_;
+    std::string write_uuid_;
+};
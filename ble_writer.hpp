@@ -0,0 +1,662 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dji/dji_protocol_parser.h"
+#include "link_pacer.hpp"
+#include "mpsc_queue.hpp"
+#include "trace.hpp"
+
+/**
+ * @brief Dedicated thread that owns the write characteristic and schedules frames by priority class
+ *        独占写特征值、按优先级类别调度帧的专用线程
+ *
+ * Any thread may submit() an encoded frame: the bytes are copied into a preallocated submission slot, which is
+ * linked onto the lock-free MPSC queue of its priority class, so callers never block on BLE or on each other and
+ * do not touch the heap while slots are free. The writer wakes once per burst, moves everything queued into
+ * per-class FIFOs and picks one frame at a time:
+ * - Control frames (shutter, key reports) have strict priority and are checked again before every packet, so a
+ *   control frame waits for at most the packet already in progress. That is one write, except for a frame larger
+ *   than the MTU: its fragments must reach the peripheral back to back or its byte stream breaks, so a 1023 byte
+ *   frame at a 20 byte MTU holds a control frame back for all of its 52 writes.
+ * - The other classes share the link by weighted round robin, and each may be rate limited by a token bucket and
+ *   capped in depth, dropping its oldest frames first. A capped class is only for periodic pushes where the latest
+ *   value supersedes the older ones; one-shot commands belong in Normal.
+ * Frames of one class go out in submission order. Queue delay (submission to start of write) is recorded per
+ * class.
+ * 任意线程都可以 submit() 已编码的帧：帧字节被拷贝到预先分配的提交槽位，再链入其优先级类别的无锁 MPSC 队列，
+ * 调用方不会阻塞在 BLE 或彼此之上，有空闲槽位时也不经过堆分配。写线程每次突发只被唤醒一次，将排队的帧移入各类别的先进先出队列，然后逐帧挑选：
+ * - 控制类帧（拍录控制、按键上报）严格优先，每组写出前都会重新检查，因此控制帧最多等待正在写出的那一组。通常
+ *   只是一次写操作；但超过 MTU 的帧的各个分片必须连续到达外设，否则其字节流会错乱，因此 MTU 为 20 字节时一个
+ *   1023 字节的帧会让控制帧等待全部 52 次写操作。
+ * - 其他类别按权重轮转共享链路，并可分别用令牌桶限速、限制排队深度，超出时先丢弃最旧的帧。限制深度的类别
+ *   只用于新值取代旧值的周期推送，一次性命令应放在 Normal。
+ * 同一类别的帧按提交顺序发出。每个类别分别记录排队延迟（从提交到开始写出）。
+ *
+ * Once set_mtu() has been called, frames that fit are packed back to back into one write up to the MTU payload
+ * (the peripheral reassembles the byte stream by SOF and length, just like protocol_stream does here), larger
+ * frames are split into MTU-sized writes, and every write takes a credit from a LinkPacer window.
+ * 调用 set_mtu() 之后，可容纳的帧被首尾相接地打包进一次写操作，直到 MTU 有效载荷（外设按 SOF 与长度重组字节流，
+ * 与本端的 protocol_stream 相同）；超过 MTU 的帧拆分为多次写操作；每次写操作都从 LinkPacer 的窗口中占用一个信用。
+ *
+ * The write function throws on failure, like SimpleBLE::Peripheral::write_command. Frames still queued when the
+ * writer stops are failed without being written. A Ticket keeps its slot until it is destroyed and must not
+ * outlive the writer.
+ * 写函数失败时抛出异常（与 SimpleBLE::Peripheral::write_command 一致）。写线程停止时仍在排队的帧不会写出，
+ * 直接标记为失败。Ticket 在析构之前一直占用其槽位，不能比写线程对象活得更久。
+ */
+class BleWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+    using WriteFunction = std::function<void(const uint8_t *frame, size_t frame_length)>;
+    // 写出后以 true、失败或被丢弃时以 false 调用；通常在写线程上，提交被立即拒绝时在提交线程上
+    using DoneCallback = std::function<void(bool written)>;
+
+    enum class Priority : uint8_t {
+        Control,   // 严格优先，例如拍录控制与按键上报
+        Normal,    // 一般命令
+        Telemetry, // 周期推送，限速，排队过多时丢弃最旧的帧
+    };
+    static constexpr size_t priority_count = 3;
+
+    struct LaneConfig {
+        uint32_t weight = 1;  // 非控制类别之间按权重轮转，每轮最多连续写出 weight 帧
+        double rate = 0;      // 每秒最多写出的帧数，0 表示不限速
+        double burst = 1;     // 令牌桶容量，允许的突发帧数
+        size_t max_depth = 0; // 排队上限，超出时丢弃最旧的帧，0 表示不限
+    };
+
+    struct Config {
+        std::array<LaneConfig, priority_count> lanes;
+        bool coalesce = true;                                          // 是否将多个小帧打包进一次写操作
+        size_t slots = 32;                                             // 预先分配的提交槽位数，用尽时退回堆分配
+        // 连接参数，决定 LinkPacer 的信用窗口：每个连接间隔最多写出 packets_per_event 次，0 表示不限。主机协议栈
+        // 不报告协商结果，默认值对应常见的 15 ms 连接间隔、每个连接事件 6 个包；已知实际参数时应按其设置
+        Clock::duration connection_interval = std::chrono::milliseconds(15);
+        size_t packets_per_event = 6;
+    };
+
+    static Config default_config() {
+        Config config;
+        config.lanes[(size_t)Priority::Normal] = LaneConfig{4, 0, 1, 0};
+        config.lanes[(size_t)Priority::Telemetry] = LaneConfig{1, 20, 5, 8};
+        return config;
+    }
+
+    enum class Status : uint8_t {
+        Queued,
+        Written,
+        Failed,
+    };
+
+    struct LaneStats {
+        uint64_t written = 0;
+        uint64_t failed = 0;
+        uint64_t dropped = 0;          // 因超出排队上限被丢弃的帧，也计入 failed
+        Clock::duration total_delay{}; // 已写出帧的排队延迟之和
+        Clock::duration max_delay{};   // 单帧最大排队延迟
+    };
+
+    struct Stats {
+        uint64_t written = 0;
+        uint64_t failed = 0;
+        uint64_t batches = 0;            // 写线程被唤醒并写出帧的次数
+        size_t max_batch = 0;            // 单次唤醒最多写出的帧数
+        Clock::duration total_latency{}; // 所有已写出帧的提交到写出完成耗时之和
+        Clock::duration max_latency{};   // 单帧最大提交到写出完成耗时
+        uint64_t slot_overflows = 0;     // 槽位用尽、退回堆分配的提交数
+        std::array<LaneStats, priority_count> lanes;
+        LinkPacer::Stats link;           // 写操作层面的统计：每次写入的帧数、字节吞吐、分片与信用等待
+    };
+
+private:
+    class SubmissionPool;
+
+    struct Submission : MpscNode {
+        std::array<uint8_t, PROTOCOL_MAX_FRAME_LENGTH> bytes;
+        size_t length = 0;
+        Clock::time_point enqueued;
+        Clock::duration latency{};
+        DoneCallback done;
+        std::atomic<Status> status = Status::Queued;
+        // 写线程与每个 Ticket 各持有一个引用，最后一个引用释放时归还到池中
+        std::atomic<uint32_t> refs = 0;
+        // 在空闲栈中时，下一个空闲槽位的下标
+        std::atomic<uint32_t> next_free = 0;
+        // 在写线程的类别队列中时，下一个提交
+        Submission *next_ready = nullptr;
+        // 槽位用尽时从堆上分配的提交，释放时直接删除
+        bool pooled = true;
+        SubmissionPool *pool = nullptr;
+    };
+
+    /**
+     * @brief Fixed set of submission slots recycled through a lock-free stack
+     *        固定数量的提交槽位，通过无锁栈循环使用
+     *
+     * The stack head packs a slot index with a counter bumped by every change, so a slot that is taken and put back
+     * between a thread's read and its compare-exchange cannot be mistaken for an unchanged head.
+     * 栈顶把槽位下标与每次修改都加一的计数打包在一起，因此某个槽位在线程读取与比较交换之间被取走又放回时，
+     * 不会被误认为栈顶未变。
+     */
+    class SubmissionPool {
+    public:
+        explicit SubmissionPool(size_t capacity)
+            : capacity_(std::min<size_t>(capacity, empty)), slots_(std::make_unique<Submission[]>(capacity_)) {
+            for (size_t i = 0; i < capacity_; i++) {
+                slots_[i].pool = this;
+                slots_[i].next_free.store(i + 1 < capacity_ ? (uint32_t)(i + 1) : empty, std::memory_order_relaxed);
+            }
+            free_.store(capacity_ != 0 ? 0 : empty, std::memory_order_relaxed);
+        }
+
+        SubmissionPool(const SubmissionPool &) = delete;
+        SubmissionPool &operator=(const SubmissionPool &) = delete;
+
+        // 任意线程调用，槽位用尽时从堆上分配并计数
+        Submission *acquire() {
+            uint64_t head = free_.load(std::memory_order_acquire);
+            while ((uint32_t)head != empty) {
+                Submission &slot = slots_[(uint32_t)head];
+                uint64_t next = (((head >> 32) + 1) << 32) | slot.next_free.load(std::memory_order_relaxed);
+                if (free_.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+                    return &slot;
+                }
+            }
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+            Submission *submission = new Submission();
+            submission->pooled = false;
+            submission->pool = this;
+            return submission;
+        }
+
+        // 释放最后一个引用的线程调用
+        void release(Submission *submission) {
+            submission->done = nullptr;
+            if (!submission->pooled) {
+                delete submission;
+                return;
+            }
+            uint32_t index = (uint32_t)(submission - slots_.get());
+            uint64_t head = free_.load(std::memory_order_relaxed);
+            do {
+                submission->next_free.store((uint32_t)head, std::memory_order_relaxed);
+            } while (!free_.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | index, std::memory_order_release,
+                                                  std::memory_order_relaxed));
+        }
+
+        uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr uint32_t empty = 0xFFFFFFFF;
+
+        const size_t capacity_;
+        std::unique_ptr<Submission[]> slots_;
+        // 低 32 位为栈顶槽位下标（empty 表示栈空），高 32 位为修改计数
+        alignas(64) std::atomic<uint64_t> free_;
+        std::atomic<uint64_t> overflows_ = 0;
+    };
+
+    // 写线程的类别队列，经由 next_ready 链接，出入队都不分配内存
+    class SubmissionFifo {
+    public:
+        bool empty() const { return head_ == nullptr; }
+        size_t size() const { return size_; }
+        Submission *front() const { return head_; }
+
+        void push_back(Submission *submission) {
+            submission->next_ready = nullptr;
+            (tail_ != nullptr ? tail_->next_ready : head_) = submission;
+            tail_ = submission;
+            size_++;
+        }
+
+        void pop_front() {
+            head_ = head_->next_ready;
+            if (head_ == nullptr) {
+                tail_ = nullptr;
+            }
+            size_--;
+        }
+
+    private:
+        Submission *head_ = nullptr;
+        Submission *tail_ = nullptr;
+        size_t size_ = 0;
+    };
+
+    static void unref(Submission *submission) {
+        if (submission->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            submission->pool->release(submission);
+        }
+    }
+
+public:
+    /**
+     * @brief Handle to one submitted frame
+     *        单个已提交帧的句柄
+     */
+    class Ticket {
+    public:
+        Ticket() = default;
+        Ticket(const Ticket &other) : submission_(other.submission_) {
+            if (submission_ != nullptr) {
+                submission_->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        Ticket(Ticket &&other) noexcept : submission_(std::exchange(other.submission_, nullptr)) {}
+        Ticket &operator=(Ticket other) noexcept {
+            std::swap(submission_, other.submission_);
+            return *this;
+        }
+        ~Ticket() {
+            if (submission_ != nullptr) {
+                unref(submission_);
+            }
+        }
+
+        explicit operator bool() const { return submission_ != nullptr; }
+
+        Status status() const { return submission_->status.load(std::memory_order_acquire); }
+
+        // 阻塞到帧被写出或失败，写出时返回 true
+        bool wait() const {
+            submission_->status.wait(Status::Queued, std::memory_order_acquire);
+            return status() == Status::Written;
+        }
+
+        // 从提交到写出完成的耗时，尚未写出时为 0
+        Clock::duration latency() const {
+            return status() == Status::Written ? submission_->latency : Clock::duration{};
+        }
+
+    private:
+        friend class BleWriter;
+        // 接管 submission 已为本句柄计入的引用
+        explicit Ticket(Submission *submission) : submission_(submission) {}
+
+        Submission *submission_ = nullptr;
+    };
+
+    explicit BleWriter(WriteFunction write, Config config = default_config())
+        : write_(std::move(write)), config_(config), pool_(config.slots),
+          pacer_(config.packets_per_event, config.connection_interval),
+          worker_([this] { run(); }) {}
+    ~BleWriter() { stop(); }
+
+    BleWriter(const BleWriter &) = delete;
+    BleWriter &operator=(const BleWriter &) = delete;
+
+    // 拷贝一帧并排队，任意线程调用；长度超过最大帧长或写线程已停止时立即以失败完成
+    Ticket submit(const uint8_t *frame, size_t frame_length, Priority priority = Priority::Normal,
+                  DoneCallback done = nullptr) {
+        Submission *submission = pool_.acquire();
+        submission->done = std::move(done);
+        submission->status.store(Status::Queued, std::memory_order_relaxed);
+        submission->latency = Clock::duration{};
+        // 一个归返回的 Ticket，一个归写线程
+        submission->refs.store(2, std::memory_order_relaxed);
+        Ticket ticket(submission);
+
+        // 与 stop() 中对 stopping_ 的写入配对：要么这里看到停止标记，要么 stop() 等到本次入队完成后再清理队列
+        submitting_.fetch_add(1, std::memory_order_seq_cst);
+        if (frame_length > PROTOCOL_MAX_FRAME_LENGTH || stopping_.load(std::memory_order_seq_cst)) {
+            submitting_.fetch_sub(1, std::memory_order_release);
+            finish(*submission, false);
+            unref(submission);
+            return ticket;
+        }
+
+        std::memcpy(submission->bytes.data(), frame, frame_length);
+        submission->length = frame_length;
+        submission->enqueued = Clock::now();
+        incoming_[(size_t)priority].push(submission);
+        submitting_.fetch_sub(1, std::memory_order_release);
+
+        wake();
+        return ticket;
+    }
+
+    /**
+     * @brief Set the largest payload one write may carry, as reported by the BLE stack after connecting
+     *        设置单次写操作可携带的最大有效载荷，取连接后 BLE 协议栈报告的值
+     *
+     * 0 (the default) means unknown: every frame is written whole, unpacked and unpaced, one write per frame.
+     * 0（默认值）表示未知：每帧整体写出，不打包也不限制在途写操作，每帧一次写操作。
+     */
+    void set_mtu(size_t payload) {
+        payload_.store(std::min<size_t>(payload, PROTOCOL_MAX_FRAME_LENGTH), std::memory_order_relaxed);
+    }
+
+    // 写线程记录的 enqueue 与 write 区间所属的设备，取自 OSMO_TRACE_DEVICE
+    void set_trace_device(uint32_t device) { trace_device_.store(device, std::memory_order_relaxed); }
+
+    // 停止写线程，排队中的帧以失败完成；可重复调用，但不能与自身并发
+    void stop() {
+        stopping_.store(true, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+
+        // 写线程退出后由本线程接替消费者，清理写线程最后一次取空之后才完成入队的帧
+        while (submitting_.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+        collect();
+        for (size_t lane = 0; lane < priority_count; lane++) {
+            fail_all(lane);
+        }
+    }
+
+    Stats stats() const {
+        Stats stats;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats = stats_;
+        }
+        stats.slot_overflows = pool_.overflows();
+        stats.link = pacer_.stats();
+        return stats;
+    }
+
+private:
+    void wake() {
+        // seq_cst 与 run() 中对 sleeping_ 的写入构成 Dekker 式同步，写线程忙碌时调用方不会碰到锁
+        signal_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+    }
+
+    static uint16_t seq_of(const Submission &submission) {
+        return (uint16_t)((submission.bytes[8] << 8) | submission.bytes[9]);
+    }
+
+    static void finish(Submission &submission, bool written) {
+        submission.status.store(written ? Status::Written : Status::Failed, std::memory_order_release);
+        submission.status.notify_all();
+        if (submission.done) {
+            submission.done(written);
+        }
+    }
+
+    // 以下函数只在写线程（或 stop() 接替后的线程）上调用
+
+    // 将各类别无锁队列中的帧移入本地队列，并按排队上限丢弃最旧的帧
+    void collect() {
+        for (size_t lane = 0; lane < priority_count; lane++) {
+            while (Submission *submission = incoming_[lane].try_pop()) {
+                ready_[lane].push_back(submission);
+            }
+            size_t max_depth = config_.lanes[lane].max_depth;
+            while (max_depth != 0 && ready_[lane].size() > max_depth) {
+                Submission *oldest = ready_[lane].front();
+                ready_[lane].pop_front();
+                {
+                    std::lock_guard<std::mutex> lock(stats_mutex_);
+                    stats_.failed++;
+                    stats_.lanes[lane].failed++;
+                    stats_.lanes[lane].dropped++;
+                }
+                finish(*oldest, false);
+                unref(oldest);
+            }
+        }
+    }
+
+    void fail_all(size_t lane) {
+        while (!ready_[lane].empty()) {
+            Submission *submission = ready_[lane].front();
+            ready_[lane].pop_front();
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                stats_.failed++;
+                stats_.lanes[lane].failed++;
+            }
+            finish(*submission, false);
+            unref(submission);
+        }
+    }
+
+    // 补充令牌并判断该类别现在能否写出
+    bool has_token(size_t lane, Clock::time_point now) {
+        const LaneConfig &config = config_.lanes[lane];
+        if (config.rate <= 0) {
+            return true;
+        }
+        double elapsed = std::chrono::duration<double>(now - refilled_[lane]).count();
+        tokens_[lane] = std::min(config.burst, tokens_[lane] + elapsed * config.rate);
+        refilled_[lane] = now;
+        return tokens_[lane] >= 1;
+    }
+
+    // 选出下一帧所属的类别但不取出，没有可写出的帧时返回 priority_count
+    size_t choose(Clock::time_point now) {
+        if (!ready_[(size_t)Priority::Control].empty()) {
+            return (size_t)Priority::Control;
+        }
+        // 非控制类别加权轮转：当前类别用完权重、为空或被限速时轮到下一个类别
+        constexpr size_t weighted = priority_count - 1;
+        for (size_t attempt = 0; attempt <= weighted; attempt++) {
+            size_t lane = turn_;
+            if (weight_left_ > 0 && !ready_[lane].empty() && has_token(lane, now)) {
+                return lane;
+            }
+            turn_ = turn_ == priority_count - 1 ? 1 : turn_ + 1;
+            weight_left_ = config_.lanes[turn_].weight;
+        }
+        return priority_count;
+    }
+
+    // 取出 choose() 选中类别的队首帧，扣除轮转权重与令牌
+    Submission *take(size_t lane) {
+        if (lane != (size_t)Priority::Control) {
+            weight_left_--;
+        }
+        if (config_.lanes[lane].rate > 0) {
+            tokens_[lane] -= 1;
+        }
+        Submission *submission = ready_[lane].front();
+        ready_[lane].pop_front();
+        return submission;
+    }
+
+    // 仍有排队但被限速的帧时，最早能拿到令牌的时间；否则返回 max()
+    Clock::time_point next_token_time() const {
+        Clock::time_point next = Clock::time_point::max();
+        for (size_t lane = 0; lane < priority_count; lane++) {
+            const LaneConfig &config = config_.lanes[lane];
+            if (ready_[lane].empty() || config.rate <= 0) {
+                continue;
+            }
+            auto wait = std::chrono::duration<double>((1 - tokens_[lane]) / config.rate);
+            next = std::min(next, refilled_[lane] + std::chrono::ceil<Clock::duration>(wait));
+        }
+        return next;
+    }
+
+    void run() {
+        for (size_t lane = 0; lane < priority_count; lane++) {
+            tokens_[lane] = config_.lanes[lane].burst;
+            refilled_[lane] = Clock::now();
+        }
+
+        while (!stopping_.load(std::memory_order_acquire)) {
+            uint32_t seen = signal_.load(std::memory_order_seq_cst);
+            size_t batch = 0;
+            Clock::time_point deadline = Clock::time_point::max();
+            while (!stopping_.load(std::memory_order_acquire)) {
+                // 每次写操作前都重新收集，让写出期间到达的控制帧排在下一个
+                collect();
+                Clock::time_point now = Clock::now();
+                size_t lane = choose(now);
+                if (lane == priority_count) {
+                    deadline = next_token_time();
+                    break;
+                }
+                if (payload_.load(std::memory_order_relaxed) != 0 && !pacer_.has_credit(now)) {
+                    deadline = pacer_.next_credit_time();
+                    break;
+                }
+                batch += write_packet(lane, now);
+            }
+            if (batch != 0) {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                stats_.batches++;
+                stats_.max_batch = std::max(stats_.max_batch, batch);
+            }
+
+            // 没有可写出的帧：休眠到有新提交、被限速的类别拿到令牌或归还了信用
+            sleep(seen, deadline);
+        }
+    }
+
+    // 休眠到 deadline，或 signal_ 不再等于 seen（有新提交）或停止
+    void sleep(uint32_t seen, Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true, std::memory_order_seq_cst);
+        auto woken = [this, seen] {
+            return signal_.load(std::memory_order_seq_cst) != seen || stopping_.load(std::memory_order_acquire);
+        };
+        if (deadline == Clock::time_point::max()) {
+            cv_.wait(lock, woken);
+        } else {
+            cv_.wait_until(lock, deadline, woken);
+        }
+        sleeping_.store(false, std::memory_order_relaxed);
+    }
+
+    // 从 lane 开始组成一次写操作：后续可容纳的帧按调度顺序打包在一起，超过 MTU 的帧分片写出；返回写出的帧数
+    size_t write_packet(size_t lane, Clock::time_point now) {
+        size_t payload = payload_.load(std::memory_order_relaxed);
+        packet_.clear();
+        packet_.push_back({lane, take(lane)});
+        size_t length = packet_.back().second->length;
+        std::memcpy(buffer_.data(), packet_.back().second->bytes.data(), length);
+
+        while (config_.coalesce && payload != 0 && length < payload) {
+            collect();
+            size_t next = choose(now);
+            if (next == priority_count || length + ready_[next].front()->length > payload) {
+                break;
+            }
+            packet_.push_back({next, take(next)});
+            const Submission &submission = *packet_.back().second;
+            std::memcpy(buffer_.data() + length, submission.bytes.data(), submission.length);
+            length += submission.length;
+        }
+
+        Clock::time_point start = Clock::now();
+        bool ok = write_bytes(length, payload, packet_.size());
+        Clock::time_point end = Clock::now();
+
+        for (auto &[frame_lane, submission] : packet_) {
+            OSMO_TRACE_RECORD("enqueue", trace_device_.load(std::memory_order_relaxed), seq_of(*submission),
+                              submission->enqueued, start);
+            OSMO_TRACE_RECORD("write", trace_device_.load(std::memory_order_relaxed), seq_of(*submission), start,
+                              end);
+            Clock::duration delay = start - submission->enqueued;
+            if (ok) {
+                submission->latency = end - submission->enqueued;
+            }
+            {
+                std::lock_guard<std::mutex> lock(stats_mutex_);
+                LaneStats &lane_stats = stats_.lanes[frame_lane];
+                if (ok) {
+                    stats_.written++;
+                    stats_.total_latency += submission->latency;
+                    stats_.max_latency = std::max(stats_.max_latency, submission->latency);
+                    lane_stats.written++;
+                    lane_stats.total_delay += delay;
+                    lane_stats.max_delay = std::max(lane_stats.max_delay, delay);
+                } else {
+                    stats_.failed++;
+                    lane_stats.failed++;
+                }
+            }
+            finish(*submission, ok);
+            unref(submission);
+        }
+        size_t frames = packet_.size();
+        packet_.clear();
+        return frames;
+    }
+
+    // 写出 buffer_ 的前 length 字节，超过 payload 时按 payload 分片，每片等待一个信用
+    bool write_bytes(size_t length, size_t payload, size_t frames) {
+        size_t chunk = (payload == 0 || length <= payload) ? length : payload;
+        for (size_t offset = 0; offset < length; offset += chunk) {
+            size_t size = std::min(chunk, length - offset);
+            bool last = offset + size == length;
+            Clock::time_point now = Clock::now();
+            // 第一片的信用已在 run() 中检查过；后续分片不能让其他帧插入，只能原地等待信用
+            while (offset != 0) {
+                uint32_t seen = signal_.load(std::memory_order_seq_cst);
+                if (pacer_.has_credit(now)) {
+                    break;
+                }
+                if (stopping_.load(std::memory_order_acquire)) {
+                    return false;
+                }
+                sleep(seen, pacer_.next_credit_time());
+                now = Clock::now();
+            }
+            try {
+                write_(buffer_.data() + offset, size);
+            } catch (const std::exception &) {
+                // 调用方通过 Ticket 或 DoneCallback 得知失败
+                return false;
+            }
+            pacer_.on_write(now, size, last ? frames : 0, chunk != length);
+        }
+        return true;
+    }
+
+    WriteFunction write_;
+    const Config config_;
+
+    // 需先于队列与写线程构造、晚于其析构
+    SubmissionPool pool_;
+    std::array<MpscQueue<Submission>, priority_count> incoming_;
+    std::atomic<uint32_t> signal_ = 0;
+    std::atomic<bool> stopping_ = false;
+    // 已通过停止检查、尚未完成入队的提交数
+    std::atomic<uint32_t> submitting_ = 0;
+    std::atomic<bool> sleeping_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // 仅写线程访问的调度状态
+    std::array<SubmissionFifo, priority_count> ready_;
+    std::array<double, priority_count> tokens_{};
+    std::array<Clock::time_point, priority_count> refilled_{};
+    size_t turn_ = (size_t)Priority::Normal;
+    uint32_t weight_left_ = 0;
+    std::vector<std::pair<size_t, Submission *>> packet_;
+    // 打包后的总长度不超过 MTU 有效载荷，单帧不超过最大帧长
+    std::array<uint8_t, PROTOCOL_MAX_FRAME_LENGTH> buffer_;
+    LinkPacer pacer_;
+    std::atomic<size_t> payload_ = 0;
+    std::atomic<uint32_t> trace_device_ = 0;
+
+    mutable std::mutex stats_mutex_;
+    Stats stats_;
+
+    std::thread worker_;
+};
@@ -0,0 +1,323 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dji/dji_protocol_data_structures.h"
+#include "dji/dji_protocol_parser.h"
+#include "dji/dji_protocol_stream.h"
+#include "dji/enums_logic.h"
+#include "timed_scheduler.hpp"
+#include "transport.hpp"
+
+/**
+ * @brief In-process simulated Osmo cameras for running the host stack without hardware
+ *        进程内的模拟 Osmo 相机，用于在没有硬件的情况下运行主机协议栈
+ *
+ * Every camera from create_camera() is a Transport that OsmoDevice runs on. The camera reassembles the host's
+ * writes with the stream decoder and answers like the real device: the 0x00/0x19 connection request gets a response
+ * followed by the camera's own verify_mode 2 request, record control (0x1D/0x03), mode switch (0x1D/0x04) and GPS
+ * pushes (0x00/0x17) are acknowledged, and once the host acknowledges the camera's request the camera emits 0x1D/0x02
+ * status pushes every status_interval.
+ * create_camera() 返回的每台相机都是可供 OsmoDevice 使用的 Transport。相机用流式解码器重组主机写入的数据，
+ * 并像真实设备一样应答：0x00/0x19 连接请求得到应答，随后相机发出自己的 verify_mode 为 2 的连接请求；拍录控制
+ * （0x1D/0x03）、模式切换（0x1D/0x04）与 GPS 推送（0x00/0x17）得到确认；主机确认相机的连接请求后，相机每隔
+ * status_interval 发出一次 0x1D/0x02 状态推送。
+ *
+ * All cameras share one scheduler thread that sends their frames in due time order, ties in scheduling order,
+ * split into notifications of at most mtu bytes. Thousands of cameras therefore cost one thread, and what each
+ * camera sends depends only on the configuration and on what the host wrote. The simulator must outlive the
+ * cameras it created.
+ * 所有相机共用一个调度线程，按到期时间（相同时按排定顺序）发出各相机的帧，并拆分为不超过 mtu 字节的通知。
+ * 因此上千台相机只占用一个线程，每台相机发出的内容只取决于配置与主机写入的数据。模拟器必须比它创建的相机活得更久。
+ */
+class CameraSimulator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        size_t mtu = 244;                                                   // 单次通知与写入的最大字节数
+        Clock::duration response_delay = std::chrono::milliseconds(2);     // 收到命令到发出应答
+        Clock::duration status_interval = std::chrono::milliseconds(500);  // 状态推送间隔，0 表示不推送
+        uint32_t device_id = 0xFF44;                                        // 连接应答中的设备 ID
+    };
+
+    struct Stats {
+        uint64_t frames_received = 0; // 通过校验的主机帧
+        uint64_t frames_sent = 0;     // 应答与相机主动发出的连接请求
+        uint64_t status_pushes = 0;
+        uint64_t handshakes = 0;      // 完成的连接握手
+        uint64_t unhandled = 0;       // 未模拟的命令与无法对应的应答
+        uint64_t notifications = 0;   // 通知回调次数
+        uint64_t bytes_notified = 0;
+    };
+
+    static Config default_config() { return Config(); }
+
+    explicit CameraSimulator(Config config = default_config()) : config_(config) {}
+
+    CameraSimulator(const CameraSimulator &) = delete;
+    CameraSimulator &operator=(const CameraSimulator &) = delete;
+
+    // 创建一台未连接的相机，地址按创建顺序编号
+    std::unique_ptr<Transport> create_camera() {
+        uint64_t index = next_camera_.fetch_add(1, std::memory_order_relaxed) + 1;
+        char address[32];
+        std::snprintf(address, sizeof(address), "02:00:%02X:%02X:%02X:%02X", (unsigned)(index >> 24) & 0xFF,
+                      (unsigned)(index >> 16) & 0xFF, (unsigned)(index >> 8) & 0xFF, (unsigned)index & 0xFF);
+        return std::make_unique<Camera>(*this, std::make_shared<State>(address));
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.frames_received = counters_.frames_received.load(std::memory_order_relaxed);
+        stats.frames_sent = counters_.frames_sent.load(std::memory_order_relaxed);
+        stats.status_pushes = counters_.status_pushes.load(std::memory_order_relaxed);
+        stats.handshakes = counters_.handshakes.load(std::memory_order_relaxed);
+        stats.unhandled = counters_.unhandled.load(std::memory_order_relaxed);
+        stats.notifications = counters_.notifications.load(std::memory_order_relaxed);
+        stats.bytes_notified = counters_.bytes_notified.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    struct State : SimulatedEndpoint {
+        explicit State(std::string address) : address(std::move(address)) { protocol_stream_init(&stream); }
+
+        const std::string address;
+        // 以下成员同样由 mutex 保护
+        protocol_stream_t stream;
+        uint16_t seq = 0; // 相机主动发出的帧使用的 SEQ
+        bool handshake_pending = false;
+        uint16_t handshake_seq = 0;
+        uint8_t camera_mode = CAMERA_MODE_NORMAL;
+        bool recording = false;
+        Clock::time_point record_start;
+    };
+
+    struct Delivery {
+        std::shared_ptr<State> camera;
+        uint64_t generation = 0;
+        std::vector<uint8_t> frame; // 为空表示一次状态推送
+    };
+    using Scheduler = TimedScheduler<Delivery>;
+    using Event = Scheduler::Event;
+
+    class Camera : public Transport {
+    public:
+        Camera(CameraSimulator &simulator, std::shared_ptr<State> state)
+            : simulator_(simulator), state_(std::move(state)) {}
+        ~Camera() override { disconnect(); }
+
+        void connect() override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (!state_->connected) {
+                state_->connect_locked();
+                protocol_stream_reset(&state_->stream);
+                state_->handshake_pending = false;
+                state_->recording = false;
+            }
+        }
+
+        void disconnect() override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->disconnect_locked();
+        }
+
+        bool is_connected() override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            return state_->connected;
+        }
+
+        std::string address() override { return state_->address; }
+        size_t mtu() override { return simulator_.config_.mtu; }
+
+        void subscribe(NotifyCallback callback) override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->callback = std::move(callback);
+        }
+
+        void write(const uint8_t *data, size_t length) override { simulator_.receive(state_, data, length); }
+
+    private:
+        CameraSimulator &simulator_;
+        std::shared_ptr<State> state_;
+    };
+
+    // 写线程调用：重组主机写入的帧，排定应答
+    void receive(const std::shared_ptr<State> &camera, const uint8_t *data, size_t length) {
+        if (length > config_.mtu) {
+            throw std::runtime_error("write of " + std::to_string(length) + " bytes exceeds the mtu");
+        }
+
+        struct Context {
+            CameraSimulator *simulator;
+            const std::shared_ptr<State> *camera;
+            Clock::time_point now;
+            std::vector<Event> events;
+        } context{this, &camera, Clock::now(), {}};
+        {
+            std::lock_guard<std::mutex> lock(camera->mutex);
+            if (!camera->connected) {
+                throw std::runtime_error("camera " + camera->address + " is not connected");
+            }
+            protocol_stream_push(
+                &camera->stream, data, length,
+                [](const protocol_frame_t *frame, const uint8_t *, void *user_data) {
+                    Context *context = static_cast<Context *>(user_data);
+                    context->simulator->handle(*context->camera, *frame, context->now, context->events);
+                },
+                &context);
+        }
+        scheduler_.schedule(std::move(context.events));
+    }
+
+    // 在持有相机锁时调用，为一帧主机命令生成应答
+    void handle(const std::shared_ptr<State> &camera, const protocol_frame_t &frame, Clock::time_point now,
+                std::vector<Event> &events) {
+        counters_.frames_received.fetch_add(1, std::memory_order_relaxed);
+        State &state = *camera;
+        uint8_t cmd_set = frame.data[0];
+        uint8_t cmd_id = frame.data[1];
+        const uint8_t *payload = frame.data + 2;
+        size_t payload_length = frame.data_length - 2;
+        bool is_response = (frame.cmd_type & 0x20) != 0;
+        bool wants_response = (frame.cmd_type & 0x03) != 0;
+        Clock::time_point due = now + config_.response_delay;
+
+        auto reply = [&](uint8_t cmd_type, uint16_t seq, const auto &structure) {
+            std::vector<uint8_t> bytes = encode(cmd_set, cmd_id, cmd_type, seq, structure);
+            events.push_back(Event{due, Delivery{camera, state.generation, std::move(bytes)}});
+        };
+
+        if (cmd_set == 0x00 && cmd_id == 0x19) {
+            if (!is_response) {
+                // 先应答主机的连接请求，再发出相机自己的连接请求，等待主机用同一 SEQ 确认
+                connection_request_response_frame response = {};
+                response.device_id = config_.device_id;
+                reply(ACK_NO_RESPONSE, frame.seq, response);
+
+                connection_request_command_frame request = {};
+                request.device_id = config_.device_id;
+                request.verify_mode = 2;
+                state.handshake_pending = true;
+                state.handshake_seq = state.seq++;
+                reply(CMD_WAIT_RESULT, state.handshake_seq, request);
+            } else if (state.handshake_pending && frame.seq == state.handshake_seq) {
+                state.handshake_pending = false;
+                counters_.handshakes.fetch_add(1, std::memory_order_relaxed);
+                if (config_.status_interval > Clock::duration::zero()) {
+                    events.push_back(Event{now + config_.status_interval, Delivery{camera, state.generation, {}}});
+                }
+            } else {
+                counters_.unhandled.fetch_add(1, std::memory_order_relaxed);
+            }
+            return;
+        }
+        if (is_response) {
+            counters_.unhandled.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        if (cmd_set == 0x1D && cmd_id == 0x03) {
+            record_control_command_frame_t command = {};
+            std::memcpy(&command, payload, std::min(payload_length, sizeof(command)));
+            // 0 开始录制，1 停止录制
+            if (command.record_ctrl == 0 && !state.recording) {
+                state.record_start = now;
+            }
+            state.recording = command.record_ctrl == 0;
+            if (wants_response) {
+                reply(ACK_NO_RESPONSE, frame.seq, record_control_response_frame_t{0});
+            }
+        } else if (cmd_set == 0x1D && cmd_id == 0x04) {
+            camera_mode_switch_command_frame_t command = {};
+            std::memcpy(&command, payload, std::min(payload_length, sizeof(command)));
+            state.camera_mode = command.mode;
+            if (wants_response) {
+                reply(ACK_NO_RESPONSE, frame.seq, camera_mode_switch_response_frame_t{});
+            }
+        } else if (cmd_set == 0x00 && cmd_id == 0x17) {
+            if (wants_response) {
+                reply(ACK_NO_RESPONSE, frame.seq, gps_data_push_response_frame{0});
+            }
+        } else {
+            counters_.unhandled.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    static std::vector<uint8_t> encode(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, uint16_t seq,
+                                       const T &structure) {
+        std::vector<uint8_t> frame(PROTOCOL_FULL_FRAME_LENGTH(sizeof(T)));
+        std::memcpy(&frame[PROTOCOL_HEADER_LENGTH], &structure, sizeof(T));
+        protocol_write_envelope(frame.data(), cmd_set, cmd_id, cmd_type, seq, sizeof(T));
+        return frame;
+    }
+
+    // 在持有相机锁时调用，由相机当前状态生成一次状态推送
+    static std::vector<uint8_t> status_push(State &state, Clock::time_point now) {
+        camera_status_push_command_frame status = {};
+        status.camera_mode = state.camera_mode;
+        status.camera_status = state.recording ? CAMERA_STATUS_PHOTO_OR_RECORDING : CAMERA_STATUS_LIVE_STREAMING;
+        status.record_time =
+            state.recording
+                ? (uint16_t)std::chrono::duration_cast<std::chrono::seconds>(now - state.record_start).count()
+                : 0;
+        status.camera_bat_percentage = 100;
+        return encode(0x1D, 0x02, CMD_NO_RESPONSE, state.seq++, status);
+    }
+
+    // 调度线程调用：发出一帧，或生成状态推送并排定下一次
+    void deliver(Event &event) {
+        Delivery &delivery = event.item;
+        State &state = *delivery.camera;
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.current_locked(delivery.generation)) {
+            return;
+        }
+        if (delivery.frame.empty()) {
+            delivery.frame = status_push(state, event.due);
+            counters_.status_pushes.fetch_add(1, std::memory_order_relaxed);
+            // 固定节拍：下一次推送从本次的到期时间起算，与调度线程的延迟无关
+            scheduler_.schedule(
+                Event{event.due + config_.status_interval, Delivery{delivery.camera, delivery.generation, {}}});
+        } else {
+            counters_.frames_sent.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (!state.callback) {
+            return;
+        }
+        for (size_t offset = 0; offset < delivery.frame.size(); offset += config_.mtu) {
+            size_t size = std::min(config_.mtu, delivery.frame.size() - offset);
+            state.callback(delivery.frame.data() + offset, size);
+            counters_.notifications.fetch_add(1, std::memory_order_relaxed);
+        }
+        counters_.bytes_notified.fetch_add(delivery.frame.size(), std::memory_order_relaxed);
+    }
+
+    struct Counters {
+        std::atomic<uint64_t> frames_received = 0;
+        std::atomic<uint64_t> frames_sent = 0;
+        std::atomic<uint64_t> status_pushes = 0;
+        std::atomic<uint64_t> handshakes = 0;
+        std::atomic<uint64_t> unhandled = 0;
+        std::atomic<uint64_t> notifications = 0;
+        std::atomic<uint64_t> bytes_notified = 0;
+    };
+
+    const Config config_;
+    std::atomic<uint64_t> next_camera_ = 0;
+    Counters counters_;
+    Scheduler scheduler_{[this](Event &event) { deliver(event); }};
+};
@@ -0,0 +1,350 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "thread_rings.hpp"
+
+/**
+ * Capture file layout. The file starts with a CaptureFileHeader followed by records until the end of the file. Each
+ * record is a CaptureRecordHeader, `length` data bytes and zero padding up to `size`, a multiple of 8, so every
+ * record header is 8-byte aligned in a mapping of the file and the file can be walked by size alone. Fields use the
+ * host byte order. A writer that stopped abruptly leaves at most one incomplete record at the end.
+ * 抓包文件布局：文件以 CaptureFileHeader 开头，之后直到文件末尾都是记录。每条记录由 CaptureRecordHeader、length
+ * 字节数据以及补齐到 size（8 的倍数）的 0 组成，因此映射文件后每个记录头都按 8 字节对齐，只凭 size 即可遍历整个
+ * 文件。字段使用主机字节序。写入方异常退出时，文件末尾最多留下一条不完整的记录。
+ */
+constexpr char capture_magic[8] = {'O', 'S', 'M', 'O', 'C', 'A', 'P', '1'};
+constexpr uint32_t capture_version = 1;
+constexpr size_t capture_alignment = 8;
+
+enum class CaptureType : uint8_t {
+    Notify = 0, // 相机发给主机的原始通知，可能只包含半帧，也可能包含多帧
+    Write = 1,  // 主机写给相机的原始数据，即一次写操作
+    Device = 2, // 设备登记，数据为设备地址，之后的记录用 device 字段引用它
+};
+
+struct CaptureFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;  // sizeof(CaptureFileHeader)，第一条记录的偏移
+    int64_t wall_clock_ns; // 开始记录时的系统时间，自 Unix 纪元起的纳秒数
+    int64_t monotonic_ns;  // 同一时刻的单调时钟，用于把记录的时间戳换算为系统时间
+};
+static_assert(sizeof(CaptureFileHeader) == 32);
+
+struct CaptureRecordHeader {
+    uint32_t size;     // 整条记录的字节数，包含记录头与填充
+    uint32_t device;   // CaptureWriter::device() 分配的编号，从 1 开始
+    int64_t timestamp; // 单调时钟纳秒数
+    uint16_t length;   // 数据字节数
+    uint8_t type;      // CaptureType
+    uint8_t reserved[5];
+};
+static_assert(sizeof(CaptureRecordHeader) == 24);
+
+inline size_t capture_record_size(size_t length) {
+    return (sizeof(CaptureRecordHeader) + length + capture_alignment - 1) & ~(capture_alignment - 1);
+}
+
+/**
+ * @brief Appends raw notifications and writes of any number of devices to a capture file from a background thread
+ *        在后台线程把任意多台设备的原始通知与写入追加到抓包文件
+ *
+ * record() copies the bytes into a ring owned by the calling thread, already laid out as a file record: a clock
+ * read, two memcpy calls and a release store, with no lock, allocation or system call, so it can sit on the BLE
+ * notify callback. The background thread polls the rings, and is only woken early once a ring is half full, merges
+ * them by timestamp and appends each batch with one fwrite.
+ * A full ring drops the record and counts it rather than waiting. Records of one thread are in order; records of
+ * different threads are ordered by timestamp within a batch, so across batches the file is only nearly sorted.
+ * record() 把数据拷贝到调用线程自己的环形缓冲区中，并且已经按文件记录排好：一次读时钟、两次 memcpy 和一次 release
+ * 写入，不加锁、不分配内存、没有系统调用，因此可以放在 BLE 通知回调中。后台线程定期轮询（缓冲区过半时才被提前
+ * 唤醒），按时间戳合并各线程的缓冲区，每批记录只调用一次 fwrite 追加到文件。缓冲区满时丢弃记录并计数而不等待。同一线程的记录保持顺序；不同线程的记录在
+ * 同一批内按时间戳排序，因此跨批次时文件只是基本有序。
+ *
+ * Construct the writer before the devices that record into it and destroy it after they stop.
+ * 需在向它记录的设备之前构造，在这些设备停止之后析构。
+ */
+class CaptureWriter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        size_t ring_bytes = 64 * 1024;               // 每个线程的缓冲区字节数，向上取整为 2 的幂
+        std::chrono::milliseconds poll_interval{20}; // 后台线程的轮询间隔，缓冲区过半时提前唤醒
+    };
+
+    struct Stats {
+        uint64_t records = 0; // 已写入文件的记录数，含设备登记
+        uint64_t bytes = 0;   // 已写入文件的字节数，含文件头
+        uint64_t dropped = 0; // 因线程缓冲区已满或数据过长而丢弃的记录数
+        bool failed = false;  // 写文件出错，之后的记录都被丢弃
+        size_t threads = 0;   // 当前登记的线程缓冲区数
+    };
+
+    static Config default_config() { return Config(); }
+
+    // 创建（或截断）path 并写入文件头，无法写入时抛出异常
+    explicit CaptureWriter(const std::string &path, Config config = default_config())
+        : config_(config), capacity_(std::bit_ceil(std::max<size_t>(config.ring_bytes, 4096))), buffers_(capacity_),
+          file_(open(path)), worker_(config.poll_interval, [this] { drain(); }) {}
+    ~CaptureWriter() {
+        worker_.stop();
+        std::fclose(file_);
+    }
+
+    CaptureWriter(const CaptureWriter &) = delete;
+    CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+    // 返回地址对应的设备编号，第一次出现时分配并写入一条设备登记记录
+    uint32_t device(const std::string &address) {
+        std::lock_guard<std::mutex> lock(devices_mutex_);
+        auto [it, inserted] = devices_.try_emplace(address, (uint32_t)devices_.size() + 1);
+        if (inserted) {
+            pending_devices_.push_back({it->second, timestamp(), address});
+        }
+        return it->second;
+    }
+
+    void record(CaptureType type, uint32_t device, const uint8_t *data, size_t length) {
+        ThreadBuffer &buffer = buffers_.local();
+        size_t size = capture_record_size(length);
+        if (length > UINT16_MAX || size > capacity_ / 2) {
+            buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        // 记录不跨越缓冲区末尾，放不下时跳过末尾剩余的字节
+        size_t tail = buffer.tail.load(std::memory_order_relaxed);
+        size_t skip = capacity_ - (tail & buffer.mask) < size ? capacity_ - (tail & buffer.mask) : 0;
+        if (tail + skip + size - buffer.cached_head > capacity_) {
+            buffer.cached_head = buffer.head.load(std::memory_order_acquire);
+            if (tail + skip + size - buffer.cached_head > capacity_) {
+                buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        if (skip != 0) {
+            buffer.write_skip(tail, skip);
+            tail += skip;
+        }
+
+        CaptureRecordHeader header = {};
+        header.size = (uint32_t)size;
+        header.device = device;
+        header.timestamp = timestamp();
+        header.length = (uint16_t)length;
+        header.type = (uint8_t)type;
+        uint8_t *slot = &buffer.bytes[tail & buffer.mask];
+        std::memcpy(slot, &header, sizeof(header));
+        std::memcpy(slot + sizeof(header), data, length);
+        std::memset(slot + sizeof(header) + length, 0, size - sizeof(header) - length);
+        buffer.tail.store(tail + size, std::memory_order_release);
+
+        // 平时由后台线程轮询取走，不在回调路径上唤醒它；缓冲区过半时才在其休眠时通知，错过的通知由轮询兜底
+        if (tail + size - buffer.cached_head > capacity_ / 2 &&
+            tail + size - (buffer.cached_head = buffer.head.load(std::memory_order_acquire)) > capacity_ / 2) {
+            worker_.wake();
+        }
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.records = records_.load(std::memory_order_relaxed);
+        stats.bytes = bytes_.load(std::memory_order_relaxed);
+        stats.dropped = failed_dropped_.load(std::memory_order_relaxed);
+        stats.threads = buffers_.visit(
+            [&](const ThreadBuffer &buffer) { stats.dropped += buffer.dropped.load(std::memory_order_relaxed); },
+            [&] { stats.dropped += retired_dropped_; });
+        stats.failed = failed_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    static int64_t timestamp() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+private:
+    static constexpr size_t cache_line = 64;
+    // 记录头中 type 的取值，标记缓冲区末尾被跳过的字节，不会写入文件
+    static constexpr uint8_t skip_type = 0xFF;
+
+    // 单生产者（所属线程）/单消费者（后台线程）的字节环，内容为连续排列的文件记录
+    struct ThreadBuffer {
+        explicit ThreadBuffer(size_t capacity) : bytes(capacity), mask(capacity - 1) {}
+
+        std::vector<uint8_t> bytes;
+        const size_t mask;
+        alignas(cache_line) std::atomic<size_t> tail = 0;
+        size_t cached_head = 0;
+        std::atomic<uint64_t> dropped = 0;
+        alignas(cache_line) std::atomic<size_t> head = 0;
+
+        // 末尾剩余的字节不足一个记录头时，读端按剩余长度判断即可，无需标记
+        void write_skip(size_t tail, size_t skip) {
+            if (skip < sizeof(CaptureRecordHeader)) {
+                return;
+            }
+            uint8_t *slot = &bytes[tail & mask];
+            uint32_t size = (uint32_t)skip;
+            std::memcpy(slot + offsetof(CaptureRecordHeader, size), &size, sizeof(size));
+            slot[offsetof(CaptureRecordHeader, type)] = skip_type;
+        }
+
+        // 下一条记录，跳过缓冲区末尾的空隙；没有时返回 nullptr
+        const uint8_t *front(CaptureRecordHeader &header) {
+            size_t position = head.load(std::memory_order_relaxed);
+            size_t end = tail.load(std::memory_order_acquire);
+            while (position != end) {
+                const uint8_t *slot = &bytes[position & mask];
+                size_t remaining = bytes.size() - (position & mask);
+                if (remaining < sizeof(CaptureRecordHeader)) {
+                    position += remaining;
+                } else {
+                    std::memcpy(&header, slot, sizeof(header));
+                    if (header.type != skip_type) {
+                        head.store(position, std::memory_order_release);
+                        return slot;
+                    }
+                    position += header.size;
+                }
+            }
+            head.store(position, std::memory_order_release);
+            return nullptr;
+        }
+
+        void pop(const CaptureRecordHeader &header) {
+            head.store(head.load(std::memory_order_relaxed) + header.size, std::memory_order_release);
+        }
+    };
+
+    struct PendingDevice {
+        uint32_t device;
+        int64_t timestamp;
+        std::string address;
+    };
+
+    FILE *open(const std::string &path) {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            throw std::runtime_error("Failed to open capture file " + path);
+        }
+        CaptureFileHeader header = {};
+        std::memcpy(header.magic, capture_magic, sizeof(header.magic));
+        header.version = capture_version;
+        header.header_size = sizeof(CaptureFileHeader);
+        header.wall_clock_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+                .count();
+        header.monotonic_ns = timestamp();
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1 || std::fflush(file) != 0) {
+            std::fclose(file);
+            throw std::runtime_error("Failed to write capture file " + path);
+        }
+        bytes_.store(sizeof(header), std::memory_order_relaxed);
+        return file;
+    }
+
+    // 先写新登记的设备，再按时间戳合并各线程的记录，整批一次写入文件；只在后台线程上调用
+    void drain() {
+        std::vector<std::shared_ptr<ThreadBuffer>> &buffers = drain_buffers_;
+        std::vector<PendingDevice> &devices = drain_devices_;
+        std::vector<uint8_t> &batch = batch_;
+        buffers_.snapshot(
+            buffers,
+            [](ThreadBuffer &buffer) {
+                CaptureRecordHeader header;
+                return buffer.front(header) == nullptr;
+            },
+            [this](const ThreadBuffer &buffer) { retired_dropped_ += buffer.dropped.load(std::memory_order_relaxed); });
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex_);
+            devices.swap(pending_devices_);
+        }
+
+        uint64_t count = 0;
+        for (const PendingDevice &device : devices) {
+            CaptureRecordHeader header = {};
+            header.size = (uint32_t)capture_record_size(device.address.size());
+            header.device = device.device;
+            header.timestamp = device.timestamp;
+            header.length = (uint16_t)device.address.size();
+            header.type = (uint8_t)CaptureType::Device;
+            size_t offset = batch.size();
+            batch.resize(offset + header.size);
+            std::memcpy(&batch[offset], &header, sizeof(header));
+            std::memcpy(&batch[offset + sizeof(header)], device.address.data(), device.address.size());
+            count++;
+        }
+
+        for (;;) {
+            ThreadBuffer *earliest = nullptr;
+            const uint8_t *first = nullptr;
+            CaptureRecordHeader first_header;
+            for (const auto &buffer : buffers) {
+                CaptureRecordHeader header;
+                const uint8_t *record = buffer->front(header);
+                if (record != nullptr && (first == nullptr || header.timestamp < first_header.timestamp)) {
+                    earliest = buffer.get();
+                    first = record;
+                    first_header = header;
+                }
+            }
+            if (first == nullptr) {
+                break;
+            }
+            batch.insert(batch.end(), first, first + first_header.size);
+            earliest->pop(first_header);
+            count++;
+        }
+        devices.clear();
+        if (count == 0) {
+            return;
+        }
+
+        if (failed_.load(std::memory_order_relaxed)) {
+            failed_dropped_.fetch_add(count, std::memory_order_relaxed);
+        } else if (std::fwrite(batch.data(), 1, batch.size(), file_) != batch.size() || std::fflush(file_) != 0) {
+            failed_.store(true, std::memory_order_relaxed);
+            failed_dropped_.fetch_add(count, std::memory_order_relaxed);
+        } else {
+            records_.fetch_add(count, std::memory_order_relaxed);
+            bytes_.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+        batch.clear();
+    }
+
+    const Config config_;
+    const size_t capacity_;
+    ThreadRingRegistry<ThreadBuffer> buffers_;
+    // 由 buffers_ 的锁保护
+    uint64_t retired_dropped_ = 0;
+
+    std::mutex devices_mutex_;
+    std::map<std::string, uint32_t> devices_;
+    std::vector<PendingDevice> pending_devices_;
+
+    std::atomic<uint64_t> records_ = 0;
+    std::atomic<uint64_t> bytes_ = 0;
+    std::atomic<uint64_t> failed_dropped_ = 0;
+    std::atomic<bool> failed_ = false;
+    FILE *const file_;
+
+    // 仅由后台线程使用，跨批次复用
+    std::vector<std::shared_ptr<ThreadBuffer>> drain_buffers_;
+    std::vector<PendingDevice> drain_devices_;
+    std::vector<uint8_t> batch_;
+
+    PollingWorker worker_;
+};
@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "capture.hpp"
+#include "mapped_file.hpp"
+
+/**
+ * @brief Read-only memory mapping of a capture file written by CaptureWriter
+ *        CaptureWriter 写出的抓包文件的只读内存映射
+ *
+ * Records are read in place from the mapping and every access is bounds checked, so a capture cut short by a crash
+ * simply ends at its last complete record. Offsets are byte offsets into the file and stay valid as long as the
+ * file does, which is what an index can store to reach a record without reading the ones before it.
+ * 记录直接从映射中读取，每次访问都检查边界，因此因崩溃而截断的抓包文件只是在最后一条完整记录处结束。偏移量是文件内
+ * 的字节偏移，只要文件不变就一直有效，索引可以保存它来直接访问某条记录而无需读取之前的记录。
+ */
+class CaptureFile {
+public:
+    struct Record {
+        size_t offset = 0;
+        const CaptureRecordHeader *header = nullptr;
+        const uint8_t *data = nullptr;
+
+        CaptureType type() const { return (CaptureType)header->type; }
+        size_t length() const { return header->length; }
+        size_t next() const { return offset + header->size; }
+    };
+
+    // 映射 path，不是抓包文件或版本不符时抛出异常
+    explicit CaptureFile(const std::string &path)
+        : file_(path, "capture file"), data_(file_.data()), size_(file_.size()) {
+        if (size_ < sizeof(CaptureFileHeader)) {
+            throw std::runtime_error(path + " is not a capture file");
+        }
+        const CaptureFileHeader &file_header = header();
+        if (std::memcmp(file_header.magic, capture_magic, sizeof(capture_magic)) != 0 ||
+            file_header.version != capture_version || file_header.header_size < sizeof(CaptureFileHeader) ||
+            file_header.header_size % capture_alignment != 0 || file_header.header_size > size_) {
+            throw std::runtime_error(path + " is not a capture file of version " + std::to_string(capture_version));
+        }
+    }
+    CaptureFile(const CaptureFile &) = delete;
+    CaptureFile &operator=(const CaptureFile &) = delete;
+
+    const CaptureFileHeader &header() const { return *reinterpret_cast<const CaptureFileHeader *>(data_); }
+    size_t size() const { return size_; }
+    // 第一条记录的偏移
+    size_t begin() const { return header().header_size; }
+
+    // offset 处的记录；越界、未对齐或不完整时返回 false
+    bool read(size_t offset, Record &record) const {
+        if (offset % capture_alignment != 0 || offset >= size_ || size_ - offset < sizeof(CaptureRecordHeader)) {
+            return false;
+        }
+        const CaptureRecordHeader *header = reinterpret_cast<const CaptureRecordHeader *>(data_ + offset);
+        if (header->size < capture_record_size(header->length) || header->size % capture_alignment != 0 ||
+            header->size > size_ - offset) {
+            return false;
+        }
+        record.offset = offset;
+        record.header = header;
+        record.data = data_ + offset + sizeof(CaptureRecordHeader);
+        return true;
+    }
+
+    // 依次以 Record 调用 f 直到 f 返回 false 或没有完整的记录，返回停止处的偏移
+    template <typename F> size_t for_each(F f, size_t offset = 0) const {
+        Record record;
+        for (offset = offset == 0 ? begin() : offset; read(offset, record); offset = record.next()) {
+            if (!f(record)) {
+                break;
+            }
+        }
+        return offset;
+    }
+
+    // 记录的单调时钟时间戳换算为自 Unix 纪元起的系统时间纳秒数
+    int64_t wall_clock_ns(int64_t timestamp) const {
+        return header().wall_clock_ns + (timestamp - header().monotonic_ns);
+    }
+
+    // 文件中登记的设备编号与地址
+    std::map<uint32_t, std::string> devices() const {
+        std::map<uint32_t, std::string> devices;
+        for_each([&devices](const Record &record) {
+            if (record.type() == CaptureType::Device) {
+                devices[record.header->device].assign((const char *)record.data, record.length());
+            }
+            return true;
+        });
+        return devices;
+    }
+
+private:
+    const MappedFile file_;
+    const uint8_t *const data_;
+    const size_t size_;
+};
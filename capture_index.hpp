@@ -0,0 +1,516 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+#include "capture_file.hpp"
+#include "dji/dji_protocol_parser.h"
+#include "dji/dji_protocol_stream.h"
+#include "mapped_file.hpp"
+
+/**
+ * Capture index layout. The sidecar file, by convention the capture path plus ".idx", starts with a
+ * CaptureIndexHeader whose sections are arrays of fixed-size entries at 8-byte aligned offsets, so a mapping of the
+ * file is used as is. The frames section holds every frame decoded from the capture sorted by (CmdSet, CmdID,
+ * timestamp): the frames of one command are a contiguous posting list found through the keys section and searched by
+ * time. The blocks section maps time to record offsets, the pairs section maps (device, SEQ) to a request and its
+ * response and the devices section points at the Device records. Fields use the host byte order.
+ * 抓包索引布局：旁路文件（约定为抓包路径加 ".idx"）以 CaptureIndexHeader 开头，各段是位于 8 字节对齐偏移处的定长
+ * 条目数组，映射文件后即可直接使用。frames 段保存从抓包中解出的所有帧，按 (CmdSet, CmdID, 时间戳) 排序：同一命令的
+ * 帧是一段连续的倒排表，通过 keys 段找到并按时间二分查找。blocks 段把时间映射到记录偏移，pairs 段把 (设备, SEQ)
+ * 映射到请求及其应答，devices 段指向 Device 记录。字段使用主机字节序。
+ */
+constexpr char capture_index_magic[8] = {'O', 'S', 'M', 'O', 'I', 'D', 'X', '1'};
+constexpr uint32_t capture_index_version = 1;
+constexpr uint32_t capture_index_none = UINT32_MAX;
+
+struct CaptureIndexSection {
+    uint64_t offset; // 段在索引文件中的偏移
+    uint64_t count;  // 条目数
+};
+
+struct CaptureIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    // 建立索引时抓包文件的大小与文件头时间，任何一项不同都说明索引已过期
+    uint64_t capture_size;
+    int64_t capture_wall_clock_ns;
+    int64_t capture_monotonic_ns;
+    CaptureIndexSection frames;  // CaptureIndexFrame
+    CaptureIndexSection keys;    // CaptureIndexKey
+    CaptureIndexSection blocks;  // CaptureIndexBlock
+    CaptureIndexSection pairs;   // CaptureIndexPair
+    CaptureIndexSection devices; // CaptureIndexDevice
+};
+static_assert(sizeof(CaptureIndexHeader) == 120);
+
+struct CaptureIndexFrame {
+    int64_t timestamp;     // 帧最后一个字节所在记录的时间戳，即帧完整到达或写出的时刻
+    uint64_t offset;       // 帧第一个字节所在记录的偏移
+    uint32_t device;
+    uint32_t peer;         // 配对的请求或应答在 frames 段中的下标，没有时为 capture_index_none
+    uint16_t position;     // 帧在该记录数据中的起始位置
+    uint16_t frame_length; // 帧可能跨越同一设备、同一方向的后续记录
+    uint16_t seq;
+    uint8_t cmd_set;
+    uint8_t cmd_id;
+    uint8_t cmd_type;
+    uint8_t direction; // CaptureType::Notify 或 CaptureType::Write
+    uint8_t reserved[6];
+
+    bool is_response() const { return (cmd_type & 0x20) != 0; }
+};
+static_assert(sizeof(CaptureIndexFrame) == 40);
+
+struct CaptureIndexKey {
+    uint8_t cmd_set;
+    uint8_t cmd_id;
+    uint8_t reserved[2];
+    uint32_t count;
+    uint64_t first; // 该命令的第一帧在 frames 段中的下标
+};
+static_assert(sizeof(CaptureIndexKey) == 16);
+
+struct CaptureIndexBlock {
+    int64_t first_timestamp; // 块内记录时间戳的最小值与最大值，文件只是基本有序，因此块之间可能重叠
+    int64_t last_timestamp;
+    uint64_t offset; // 块内第一条记录的偏移
+    uint64_t end;    // 下一块第一条记录的偏移
+};
+static_assert(sizeof(CaptureIndexBlock) == 32);
+
+// 按 (device, seq, 请求时间) 排序；除已配对的应答外每帧各有一项，没有应答或没有请求的一侧为 capture_index_none
+struct CaptureIndexPair {
+    uint32_t device;
+    uint16_t seq;
+    uint8_t reserved[2];
+    uint32_t request;
+    uint32_t response;
+};
+static_assert(sizeof(CaptureIndexPair) == 16);
+
+struct CaptureIndexDevice {
+    uint32_t device;
+    uint8_t reserved[4];
+    uint64_t offset; // Device 记录的偏移，记录数据为设备地址
+};
+static_assert(sizeof(CaptureIndexDevice) == 16);
+
+/**
+ * @brief Read-only memory mapping of the sidecar index of a capture file, and the builder that writes it
+ *        抓包文件旁路索引的只读内存映射，以及写出索引的构建函数
+ *
+ * build() reads the capture once, feeds the Notify and Write records of every device and direction through their
+ * own protocol stream decoder and remembers where each decoded frame starts, so a query only maps the index, finds
+ * the matching entries by binary search and reads the few records that hold those frames. A response is paired
+ * with the latest request of the other direction on the same device that has the same SEQ, CmdSet and CmdID and
+ * asked for a response. Frames are located but not parsed while indexing; read_frame() returns the bytes of one
+ * frame for protocol_parse_notification() and the descriptor parsers.
+ * build() 只读一遍抓包文件，把每台设备每个方向的 Notify 与 Write 记录送入各自的协议流解码器，并记下解出的每一帧的
+ * 起始位置，因此查询只需映射索引、二分查找匹配的条目，再读取包含这些帧的少量记录。应答与同一设备另一方向上 SEQ、
+ * CmdSet、CmdID 都相同且要求应答的最近一个请求配对。建立索引时只定位帧而不解析；read_frame() 返回单帧的字节，交给
+ * protocol_parse_notification() 与描述符解析函数。
+ */
+class CaptureIndex {
+public:
+    struct BuildStats {
+        uint64_t records = 0;
+        uint64_t frames = 0;
+        uint64_t pairs = 0;               // 找到应答的请求
+        uint64_t unanswered = 0;          // 要求应答但没有找到应答的请求
+        uint64_t orphan_responses = 0;    // 没有找到请求的应答
+        uint64_t bytes_discarded = 0;     // 解码器搜索帧头时丢弃的字节
+        uint64_t crc_errors = 0;
+    };
+
+    // 旁路索引文件的默认路径
+    static std::string default_path(const std::string &capture_path) { return capture_path + ".idx"; }
+
+    // 为 capture 建立索引并写到 path（先写临时文件再改名），写入失败时抛出异常
+    static BuildStats build(const CaptureFile &capture, const std::string &path, size_t block_records = 256) {
+        Builder builder(capture, block_records);
+        capture.for_each([&builder](const CaptureFile::Record &record) {
+            builder.add(record);
+            return true;
+        });
+        return builder.write(path);
+    }
+
+    // 映射 path，不是索引文件、版本不符或段越界时抛出异常
+    explicit CaptureIndex(const std::string &path)
+        : file_(path, "capture index"), data_(file_.data()), size_(file_.size()) {
+        if (size_ < sizeof(CaptureIndexHeader)) {
+            throw std::runtime_error(path + " is not a capture index");
+        }
+        const CaptureIndexHeader &index_header = header();
+        bool valid = std::memcmp(index_header.magic, capture_index_magic, sizeof(capture_index_magic)) == 0 &&
+                     index_header.version == capture_index_version &&
+                     index_header.header_size >= sizeof(CaptureIndexHeader) &&
+                     section_valid(index_header.frames, sizeof(CaptureIndexFrame)) &&
+                     section_valid(index_header.keys, sizeof(CaptureIndexKey)) &&
+                     section_valid(index_header.blocks, sizeof(CaptureIndexBlock)) &&
+                     section_valid(index_header.pairs, sizeof(CaptureIndexPair)) &&
+                     section_valid(index_header.devices, sizeof(CaptureIndexDevice)) &&
+                     index_header.frames.count < capture_index_none;
+        for (size_t i = 0; valid && i < keys().size(); i++) {
+            valid = keys()[i].first <= frames().size() && keys()[i].count <= frames().size() - keys()[i].first;
+        }
+        if (!valid) {
+            throw std::runtime_error(path + " is not a capture index of version " +
+                                     std::to_string(capture_index_version));
+        }
+    }
+    CaptureIndex(const CaptureIndex &) = delete;
+    CaptureIndex &operator=(const CaptureIndex &) = delete;
+
+    const CaptureIndexHeader &header() const { return *reinterpret_cast<const CaptureIndexHeader *>(data_); }
+
+    // 索引是否是为 capture 的当前内容建立的；正在写入的抓包文件会不断变大，索引随之过期
+    bool matches(const CaptureFile &capture) const {
+        return header().capture_size == capture.size() &&
+               header().capture_wall_clock_ns == capture.header().wall_clock_ns &&
+               header().capture_monotonic_ns == capture.header().monotonic_ns;
+    }
+
+    std::span<const CaptureIndexFrame> frames() const { return section<CaptureIndexFrame>(header().frames); }
+    std::span<const CaptureIndexKey> keys() const { return section<CaptureIndexKey>(header().keys); }
+    std::span<const CaptureIndexBlock> blocks() const { return section<CaptureIndexBlock>(header().blocks); }
+    std::span<const CaptureIndexPair> pairs() const { return section<CaptureIndexPair>(header().pairs); }
+    std::span<const CaptureIndexDevice> devices() const { return section<CaptureIndexDevice>(header().devices); }
+
+    // 某个命令时间戳在 [from, to] 内的帧，按时间排序
+    std::span<const CaptureIndexFrame> frames(uint8_t cmd_set, uint8_t cmd_id, int64_t from = INT64_MIN,
+                                              int64_t to = INT64_MAX) const {
+        std::span<const CaptureIndexKey> all = keys();
+        auto key = std::lower_bound(all.begin(), all.end(), std::make_pair(cmd_set, cmd_id),
+                                    [](const CaptureIndexKey &key, const std::pair<uint8_t, uint8_t> &value) {
+                                        return std::make_pair(key.cmd_set, key.cmd_id) < value;
+                                    });
+        if (key == all.end() || key->cmd_set != cmd_set || key->cmd_id != cmd_id || from > to) {
+            return {};
+        }
+        std::span<const CaptureIndexFrame> postings = frames().subspan(key->first, key->count);
+        auto first = std::lower_bound(postings.begin(), postings.end(), from,
+                                      [](const CaptureIndexFrame &frame, int64_t t) { return frame.timestamp < t; });
+        auto last = std::upper_bound(first, postings.end(), to,
+                                     [](int64_t t, const CaptureIndexFrame &frame) { return t < frame.timestamp; });
+        return postings.subspan(first - postings.begin(), last - first);
+    }
+
+    // 某台设备上 SEQ 为 seq 的请求与应答，按请求时间排序
+    std::span<const CaptureIndexPair> pairs(uint32_t device, uint16_t seq) const {
+        std::span<const CaptureIndexPair> all = pairs();
+        auto range = std::equal_range(all.begin(), all.end(), std::make_pair(device, seq),
+                                      [](const auto &a, const auto &b) { return pair_key(a) < pair_key(b); });
+        return all.subspan(range.first - all.begin(), range.second - range.first);
+    }
+
+    // frames 段中下标为 index 的帧，越界时返回 nullptr
+    const CaptureIndexFrame *frame(uint32_t index) const {
+        return index < frames().size() ? &frames()[index] : nullptr;
+    }
+
+    const CaptureIndexFrame *peer(const CaptureIndexFrame &frame) const { return this->frame(frame.peer); }
+
+    /**
+     * Copies the bytes of frame into out, which holds PROTOCOL_MAX_FRAME_LENGTH bytes, following it into later
+     * records of the same device and direction when it was fragmented. Returns the frame length, or 0 when the
+     * capture does not hold the frame where the index says it does.
+     * 把 frame 的字节拷贝到 out（容纳 PROTOCOL_MAX_FRAME_LENGTH 字节），帧被分片时继续读取同一设备、同一方向的后续
+     * 记录。返回帧长度，抓包文件中对应位置没有该帧时返回 0。
+     */
+    static size_t read_frame(const CaptureFile &capture, const CaptureIndexFrame &frame, uint8_t *out) {
+        // 分片之间夹杂的其他设备记录通常很少，限制扫描的记录数以免索引损坏时遍历整个文件
+        constexpr size_t max_records = 65536;
+        if (frame.frame_length > PROTOCOL_MAX_FRAME_LENGTH) {
+            return 0;
+        }
+        CaptureFile::Record record;
+        size_t offset = frame.offset;
+        size_t position = frame.position;
+        size_t copied = 0;
+        for (size_t scanned = 0; copied < frame.frame_length && scanned < max_records; scanned++) {
+            if (!capture.read(offset, record)) {
+                return 0;
+            }
+            if (record.header->device == frame.device && record.header->type == frame.direction) {
+                if (position > record.length()) {
+                    return 0;
+                }
+                size_t n = std::min(record.length() - position, (size_t)frame.frame_length - copied);
+                std::memcpy(out + copied, record.data + position, n);
+                copied += n;
+                position = 0;
+            } else if (copied == 0) {
+                return 0;
+            }
+            offset = record.next();
+        }
+        return copied == frame.frame_length ? copied : 0;
+    }
+
+private:
+    class Builder {
+    public:
+        Builder(const CaptureFile &capture, size_t block_records)
+            : capture_(capture), block_records_(std::max<size_t>(block_records, 1)) {}
+
+        void add(const CaptureFile::Record &record) {
+            stats_.records++;
+            if (blocks_.empty() || block_count_ == block_records_) {
+                blocks_.push_back({record.header->timestamp, record.header->timestamp, record.offset, 0});
+                block_count_ = 0;
+            }
+            CaptureIndexBlock &block = blocks_.back();
+            block.first_timestamp = std::min(block.first_timestamp, record.header->timestamp);
+            block.last_timestamp = std::max(block.last_timestamp, record.header->timestamp);
+            block.end = record.next();
+            block_count_++;
+
+            if (record.type() == CaptureType::Device) {
+                devices_.push_back({record.header->device, {}, record.offset});
+                return;
+            }
+            if (record.type() != CaptureType::Notify && record.type() != CaptureType::Write) {
+                return;
+            }
+
+            std::unique_ptr<Stream> &slot = streams_[{record.header->device, record.header->type}];
+            if (!slot) {
+                slot = std::make_unique<Stream>();
+                protocol_stream_init(&slot->decoder);
+            }
+            Stream &stream = *slot;
+            stream.pieces.push_back({stream.decoder.tail, record.offset, record.length()});
+
+            const uint8_t *data = record.data;
+            size_t remaining = record.length();
+            while (remaining > 0) {
+                size_t accepted = protocol_stream_write(&stream.decoder, data, remaining);
+                data += accepted;
+                remaining -= accepted;
+                if (drain(stream, record) == 0 && accepted == 0) {
+                    // 解码器既不接收也不出帧，理论上不会发生；放弃该记录余下的字节
+                    stats_.bytes_discarded += remaining;
+                    break;
+                }
+            }
+        }
+
+        BuildStats write(const std::string &path) {
+            for (const auto &[key, stream] : streams_) {
+                stats_.bytes_discarded += stream->decoder.stats.bytes_discarded;
+                stats_.crc_errors += stream->decoder.stats.crc16_errors + stream->decoder.stats.crc32_errors;
+            }
+            stats_.frames = frames_.size();
+            for (const CaptureIndexFrame &frame : frames_) {
+                if (!frame.is_response() && (frame.cmd_type & 0x03) != 0 && frame.peer == capture_index_none) {
+                    stats_.unanswered++;
+                }
+            }
+
+            // 按 (CmdSet, CmdID, 时间戳) 排序得到倒排表，再把配对下标换成排序后的下标
+            std::vector<uint32_t> order(frames_.size());
+            for (uint32_t i = 0; i < order.size(); i++) {
+                order[i] = i;
+            }
+            std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+                return frame_key(frames_[a]) < frame_key(frames_[b]);
+            });
+            std::vector<uint32_t> position(frames_.size());
+            for (uint32_t i = 0; i < order.size(); i++) {
+                position[order[i]] = i;
+            }
+            std::vector<CaptureIndexFrame> frames(frames_.size());
+            std::vector<CaptureIndexKey> keys;
+            for (uint32_t i = 0; i < order.size(); i++) {
+                CaptureIndexFrame &frame = frames[i];
+                frame = frames_[order[i]];
+                if (frame.peer != capture_index_none) {
+                    frame.peer = position[frame.peer];
+                }
+                if (keys.empty() || keys.back().cmd_set != frame.cmd_set || keys.back().cmd_id != frame.cmd_id) {
+                    keys.push_back({frame.cmd_set, frame.cmd_id, {}, 0, i});
+                }
+                keys.back().count++;
+            }
+
+            std::vector<CaptureIndexPair> pairs;
+            pairs.reserve(frames.size());
+            for (uint32_t i = 0; i < frames.size(); i++) {
+                const CaptureIndexFrame &frame = frames[i];
+                if (!frame.is_response()) {
+                    pairs.push_back({frame.device, frame.seq, {}, i, frame.peer});
+                } else if (frame.peer == capture_index_none) {
+                    pairs.push_back({frame.device, frame.seq, {}, capture_index_none, i});
+                }
+            }
+            std::sort(pairs.begin(), pairs.end(), [&frames](const CaptureIndexPair &a, const CaptureIndexPair &b) {
+                auto time = [&frames](const CaptureIndexPair &pair) {
+                    return frames[pair.request != capture_index_none ? pair.request : pair.response].timestamp;
+                };
+                return std::make_tuple(a.device, a.seq, time(a)) < std::make_tuple(b.device, b.seq, time(b));
+            });
+
+            CaptureIndexHeader header = {};
+            std::memcpy(header.magic, capture_index_magic, sizeof(capture_index_magic));
+            header.version = capture_index_version;
+            header.header_size = sizeof(CaptureIndexHeader);
+            header.capture_size = capture_.size();
+            header.capture_wall_clock_ns = capture_.header().wall_clock_ns;
+            header.capture_monotonic_ns = capture_.header().monotonic_ns;
+            uint64_t offset = sizeof(CaptureIndexHeader);
+            auto place = [&offset](CaptureIndexSection &section, size_t count, size_t entry_size) {
+                section = {offset, count};
+                offset += count * entry_size;
+            };
+            place(header.frames, frames.size(), sizeof(CaptureIndexFrame));
+            place(header.keys, keys.size(), sizeof(CaptureIndexKey));
+            place(header.blocks, blocks_.size(), sizeof(CaptureIndexBlock));
+            place(header.pairs, pairs.size(), sizeof(CaptureIndexPair));
+            place(header.devices, devices_.size(), sizeof(CaptureIndexDevice));
+
+            std::string temporary = path + ".tmp";
+            FILE *file = std::fopen(temporary.c_str(), "wb");
+            if (file == nullptr) {
+                throw std::runtime_error("Failed to create capture index " + temporary);
+            }
+            bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1 && write_all(file, frames) &&
+                      write_all(file, keys) && write_all(file, blocks_) && write_all(file, pairs) &&
+                      write_all(file, devices_);
+            ok = std::fclose(file) == 0 && ok;
+            if (!ok || !replace_file(temporary, path)) {
+                std::remove(temporary.c_str());
+                throw std::runtime_error("Failed to write capture index " + path);
+            }
+            return stats_;
+        }
+
+    private:
+        // 一台设备一个方向的解码器，pieces 记录尚在解码器中的字节来自哪条记录
+        struct Piece {
+            size_t position; // 记录第一个字节在解码流中的位置
+            uint64_t offset;
+            size_t length;
+        };
+        struct Stream {
+            protocol_stream_t decoder;
+            std::deque<Piece> pieces;
+        };
+
+        static std::tuple<uint8_t, uint8_t, int64_t> frame_key(const CaptureIndexFrame &frame) {
+            return {frame.cmd_set, frame.cmd_id, frame.timestamp};
+        }
+
+        template <typename T> static bool write_all(FILE *file, const std::vector<T> &entries) {
+            return entries.empty() || std::fwrite(entries.data(), sizeof(T), entries.size(), file) == entries.size();
+        }
+
+        size_t drain(Stream &stream, const CaptureFile::Record &record) {
+            size_t decoded = 0;
+            protocol_frame_t frame;
+            const uint8_t *bytes = nullptr;
+            while (protocol_stream_next(&stream.decoder, &frame, &bytes) == 1) {
+                decoded++;
+                // next() 返回时 head 已越过该帧，帧在解码流中从 head - frame_length 开始
+                size_t start = stream.decoder.head - frame.frame_length;
+                discard_pieces(stream, start);
+                const Piece &piece = stream.pieces.front();
+                if (frame.data_length < 2 || start < piece.position || frames_.size() >= capture_index_none) {
+                    continue;
+                }
+
+                CaptureIndexFrame entry = {};
+                entry.timestamp = record.header->timestamp;
+                entry.offset = piece.offset;
+                entry.device = record.header->device;
+                entry.peer = capture_index_none;
+                entry.position = (uint16_t)(start - piece.position);
+                entry.frame_length = frame.frame_length;
+                entry.seq = frame.seq;
+                entry.cmd_set = frame.data[0];
+                entry.cmd_id = frame.data[1];
+                entry.cmd_type = frame.cmd_type;
+                entry.direction = record.header->type;
+                pair(entry, (uint32_t)frames_.size());
+                frames_.push_back(entry);
+            }
+            // 解码器丢弃的字节不会再被引用
+            discard_pieces(stream, stream.decoder.head);
+            return decoded;
+        }
+
+        // 丢弃在解码流位置 position 之前就已结束的记录，最后一条保留以便定位正在写入的字节
+        static void discard_pieces(Stream &stream, size_t position) {
+            while (stream.pieces.size() > 1 &&
+                   stream.pieces.front().position + stream.pieces.front().length <= position) {
+                stream.pieces.pop_front();
+            }
+        }
+
+        // 要求应答的请求登记为待配对；应答与另一方向上最近一个相同 SEQ、CmdSet、CmdID 的待配对请求配对
+        void pair(CaptureIndexFrame &entry, uint32_t index) {
+            if (!entry.is_response()) {
+                if ((entry.cmd_type & 0x03) != 0) {
+                    pending_[pending_key(entry, entry.direction)] = index;
+                }
+                return;
+            }
+            uint8_t request_direction = entry.direction == (uint8_t)CaptureType::Notify ? (uint8_t)CaptureType::Write
+                                                                                         : (uint8_t)CaptureType::Notify;
+            auto it = pending_.find(pending_key(entry, request_direction));
+            if (it == pending_.end()) {
+                stats_.orphan_responses++;
+                return;
+            }
+            entry.peer = it->second;
+            frames_[it->second].peer = index;
+            pending_.erase(it);
+            stats_.pairs++;
+        }
+
+        static std::tuple<uint32_t, uint8_t, uint16_t, uint8_t, uint8_t> pending_key(const CaptureIndexFrame &frame,
+                                                                                     uint8_t direction) {
+            return {frame.device, direction, frame.seq, frame.cmd_set, frame.cmd_id};
+        }
+
+        const CaptureFile &capture_;
+        const size_t block_records_;
+        size_t block_count_ = 0;
+        BuildStats stats_;
+        std::map<std::pair<uint32_t, uint8_t>, std::unique_ptr<Stream>> streams_;
+        std::map<std::tuple<uint32_t, uint8_t, uint16_t, uint8_t, uint8_t>, uint32_t> pending_;
+        std::vector<CaptureIndexFrame> frames_;
+        std::vector<CaptureIndexBlock> blocks_;
+        std::vector<CaptureIndexDevice> devices_;
+    };
+
+    static std::pair<uint32_t, uint16_t> pair_key(const CaptureIndexPair &pair) { return {pair.device, pair.seq}; }
+    static std::pair<uint32_t, uint16_t> pair_key(const std::pair<uint32_t, uint16_t> &key) { return key; }
+
+    bool section_valid(const CaptureIndexSection &section, size_t entry_size) const {
+        return section.offset % alignof(uint64_t) == 0 && section.offset >= header().header_size &&
+               section.offset <= size_ && section.count <= (size_ - section.offset) / entry_size;
+    }
+
+    template <typename T> std::span<const T> section(const CaptureIndexSection &section) const {
+        return {reinterpret_cast<const T *>(data_ + section.offset), (size_t)section.count};
+    }
+
+    const MappedFile file_;
+    const uint8_t *const data_;
+    const size_t size_;
+};
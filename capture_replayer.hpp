@@ -0,0 +1,166 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "capture_file.hpp"
+#include "transport.hpp"
+
+/**
+ * @brief Feeds the notifications of a capture file back through OsmoDevice
+ *        将抓包文件中的通知重新送入 OsmoDevice
+ *
+ * create_transport() returns a Transport standing in for one captured device; an OsmoDevice built on it decodes,
+ * matches and dispatches the replayed notifications exactly as it did the live ones. run() delivers every Notify
+ * record of those devices in file order on the calling thread, spacing them by the captured intervals divided by
+ * speed, or back to back when speed is 0. Writes from the host are accepted and discarded, so commands issued
+ * during a replay time out unless the capture happens to contain a matching response.
+ * create_transport() 返回代表一台被记录设备的 Transport；基于它构造的 OsmoDevice 会像处理实时数据一样解码、匹配
+ * 并分发回放的通知。run() 在调用线程上按文件顺序投递这些设备的所有 Notify 记录，间隔为记录时的间隔除以 speed，
+ * speed 为 0 时不等待。主机的写入被接受后丢弃，因此回放期间发出的命令除非抓包中恰好有对应的应答，否则会超时。
+ */
+class CaptureReplayer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t notifications = 0;                     // 投递给订阅者的通知
+        uint64_t bytes = 0;
+        uint64_t skipped = 0;                           // 设备没有传输层或未连接、未订阅的通知
+        uint64_t writes = 0;                            // 回放期间主机的写入，已丢弃
+        Clock::duration elapsed = Clock::duration::zero();
+        Clock::duration captured = Clock::duration::zero(); // 第一条与最后一条通知之间的记录时长
+        Clock::duration max_lag = Clock::duration::zero();  // 投递晚于计划时间的最大值
+    };
+
+    explicit CaptureReplayer(const CaptureFile &file) : file_(file), devices_(file.devices()) {}
+
+    CaptureReplayer(const CaptureReplayer &) = delete;
+    CaptureReplayer &operator=(const CaptureReplayer &) = delete;
+
+    // 文件中登记的设备编号与地址
+    const std::map<uint32_t, std::string> &devices() const { return devices_; }
+
+    std::unique_ptr<Transport> create_transport(uint32_t device) {
+        auto it = devices_.find(device);
+        if (it == devices_.end()) {
+            throw std::runtime_error("device " + std::to_string(device) + " is not in the capture");
+        }
+        auto state = std::make_shared<State>(it->second);
+        states_[device] = state;
+        return std::make_unique<ReplayTransport>(std::move(state));
+    }
+
+    // 阻塞到所有通知投递完毕
+    Stats run(double speed) {
+        Stats stats;
+        Clock::time_point start = Clock::now();
+        int64_t first = 0;
+        int64_t last = 0;
+        bool started = false;
+        file_.for_each([&](const CaptureFile::Record &record) {
+            if (record.type() != CaptureType::Notify) {
+                return true;
+            }
+            int64_t timestamp = record.header->timestamp;
+            if (!started) {
+                first = timestamp;
+                started = true;
+            }
+            last = std::max(last, timestamp);
+
+            auto it = states_.find(record.header->device);
+            if (it == states_.end()) {
+                stats.skipped++;
+                return true;
+            }
+            if (speed > 0) {
+                Clock::time_point due =
+                    start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double, std::nano>((double)(timestamp - first) / speed));
+                std::this_thread::sleep_until(due);
+                stats.max_lag = std::max(stats.max_lag, Clock::now() - due);
+            }
+
+            State &state = *it->second;
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.connected || !state.callback) {
+                stats.skipped++;
+                return true;
+            }
+            state.callback(record.data, record.length());
+            stats.notifications++;
+            stats.bytes += record.length();
+            return true;
+        });
+        stats.elapsed = Clock::now() - start;
+        stats.captured = std::chrono::nanoseconds(last - first);
+        for (auto &[device, state] : states_) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            stats.writes += state->writes;
+        }
+        return stats;
+    }
+
+private:
+    struct State {
+        explicit State(std::string address) : address(std::move(address)) {}
+
+        const std::string address;
+        // 回放线程持有它调用通知回调，因此 disconnect() 返回后不会再有回调
+        std::mutex mutex;
+        Transport::NotifyCallback callback;
+        bool connected = false;
+        uint64_t writes = 0;
+    };
+
+    class ReplayTransport : public Transport {
+    public:
+        explicit ReplayTransport(std::shared_ptr<State> state) : state_(std::move(state)) {}
+        ~ReplayTransport() override { disconnect(); }
+
+        void connect() override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->connected = true;
+        }
+
+        void disconnect() override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->connected = false;
+            state_->callback = nullptr;
+        }
+
+        bool is_connected() override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            return state_->connected;
+        }
+
+        std::string address() override { return state_->address; }
+        // 回放不限制写入长度
+        size_t mtu() override { return 0; }
+
+        void subscribe(NotifyCallback callback) override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->callback = std::move(callback);
+        }
+
+        void write(const uint8_t *, size_t) override {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->writes++;
+        }
+
+    private:
+        std::shared_ptr<State> state_;
+    };
+
+    const CaptureFile &file_;
+    const std::map<uint32_t, std::string> devices_;
+    std::map<uint32_t, std::shared_ptr<State>> states_;
+};
@@ -0,0 +1,191 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "frame_view.hpp"
+#include "thread_safe_queue.hpp"
+
+/**
+ * @brief Fans frames out to handlers subscribed by (CmdSet, CmdId, direction) on a dedicated thread
+ *        在独立线程上将帧分发给按 (CmdSet, CmdId, 方向) 订阅的处理函数
+ *
+ * The reader thread posts every frame that answers no request, so a slow telemetry handler never delays command
+ * replies. Frames are decoded once into a FrameView and every handler subscribed to the key sees the same view;
+ * typed handlers receive a MessageView of the registered payload structure. Subscribing and unsubscribing are
+ * thread-safe and may happen from inside a handler. The table is copied on write, so dispatching never holds a
+ * lock while handlers run.
+ * 读取线程将不属于任何请求的帧投递到这里，较慢的遥测处理函数不会拖慢命令应答。每帧只解码一次为 FrameView，
+ * 订阅同一键的处理函数看到的是同一个视图；类型化处理函数收到已注册有效载荷结构体的 MessageView。
+ * 订阅与取消订阅是线程安全的，也可以在处理函数中进行。订阅表写时复制，分发时执行处理函数不持有锁。
+ *
+ * Up to max_queued frames wait for the dispatcher thread, beyond that the oldest is dropped and counted.
+ * 最多 max_queued 帧等待分发线程处理，超出时丢弃最旧的帧并计数。
+ */
+class Dispatcher {
+public:
+    enum class Direction : uint8_t {
+        Command,  // 对端发起的命令或推送
+        Response, // 应答帧（response bit 置位），例如超时后才到达的应答
+    };
+
+    using Handler = std::function<void(const FrameView &)>;
+    using Token = uint64_t;
+
+    struct Stats {
+        uint64_t delivered = 0; // 至少交给一个处理函数的帧
+        uint64_t unhandled = 0; // 没有订阅者的帧
+        uint64_t dropped = 0;   // 队列已满时丢弃的帧
+    };
+
+    explicit Dispatcher(size_t max_queued = 64) : queue_(max_queued), worker_([this] { run(); }) {}
+    ~Dispatcher() { stop(); }
+
+    Dispatcher(const Dispatcher &) = delete;
+    Dispatcher &operator=(const Dispatcher &) = delete;
+
+    // 订阅原始帧，返回用于取消订阅的令牌
+    Token subscribe(uint8_t cmd_set, uint8_t cmd_id, Direction direction, Handler handler) {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        auto table = std::make_shared<Table>(*table_);
+        Token token = next_token_++;
+        (*table)[key(cmd_set, cmd_id, direction)].push_back(
+            Entry{token, std::make_shared<const Handler>(std::move(handler))});
+        table_ = std::move(table);
+        return token;
+    }
+
+    // 订阅已在 OsmoMessages 中注册的有效载荷结构体，CmdSet、CmdId 与方向由类型确定，长度不足的帧不会交给 handler
+    template <typename T, typename F> Token subscribe(F handler) {
+        using Owner = message_detail::payload_owner<T, OsmoMessages>;
+        static_assert(Owner::found, "payload structure is not registered in OsmoMessages");
+
+        return subscribe(Owner::cmd_set, Owner::cmd_id, Owner::response ? Direction::Response : Direction::Command,
+                         [handler = std::move(handler)](const FrameView &frame) {
+                             if (auto view = view_as<T>(frame)) {
+                                 handler(*view);
+                             }
+                         });
+    }
+
+    // 取消订阅；返回后处理函数不会再被调用（在处理函数内部调用时，当前这次调用仍会执行完）
+    bool unsubscribe(Token token) {
+        bool found = false;
+        {
+            std::lock_guard<std::mutex> lock(table_mutex_);
+            auto table = std::make_shared<Table>(*table_);
+            for (auto it = table->begin(); it != table->end(); ++it) {
+                auto &entries = it->second;
+                auto entry = std::find_if(entries.begin(), entries.end(),
+                                          [token](const Entry &candidate) { return candidate.token == token; });
+                if (entry != entries.end()) {
+                    entries.erase(entry);
+                    if (entries.empty()) {
+                        table->erase(it);
+                    }
+                    found = true;
+                    break;
+                }
+            }
+            if (found) {
+                table_ = std::move(table);
+            }
+        }
+        // 等待正在使用旧订阅表的分发完成
+        if (found && std::this_thread::get_id() != worker_.get_id()) {
+            std::lock_guard<std::mutex> lock(dispatch_mutex_);
+        }
+        return found;
+    }
+
+    // 投递一帧，由读取线程调用
+    void post(FrameView frame) {
+        bool evicted = false;
+        if (queue_.push_evicting(std::move(frame), evicted) && evicted) {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.dropped++;
+        }
+    }
+
+    // 处理完已排队的帧后停止分发线程，可重复调用
+    void stop() {
+        queue_.close();
+        if (worker_.joinable() && std::this_thread::get_id() != worker_.get_id()) {
+            worker_.join();
+        }
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        Token token;
+        std::shared_ptr<const Handler> handler;
+    };
+    using Table = std::unordered_map<uint32_t, std::vector<Entry>>;
+
+    static uint32_t key(uint8_t cmd_set, uint8_t cmd_id, Direction direction) {
+        return ((uint32_t)cmd_set << 16) | ((uint32_t)cmd_id << 8) | (uint32_t)direction;
+    }
+
+    void run() {
+        std::vector<FrameView> batch;
+        // 突发时一次取走所有排队的帧，每批只交接一次锁；队列关闭且取空后返回 0
+        while (queue_.drain_wait(batch) > 0) {
+            uint64_t delivered = 0;
+            for (const FrameView &frame : batch) {
+                delivered += dispatch(frame) ? 1 : 0;
+            }
+            uint64_t unhandled = batch.size() - delivered;
+            // 先释放帧，避免停止时缓冲区被本线程持有
+            batch.clear();
+
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            stats_.delivered += delivered;
+            stats_.unhandled += unhandled;
+        }
+    }
+
+    bool dispatch(const FrameView &frame) {
+        std::lock_guard<std::mutex> dispatching(dispatch_mutex_);
+        std::shared_ptr<const Table> table;
+        {
+            std::lock_guard<std::mutex> lock(table_mutex_);
+            table = table_;
+        }
+
+        Direction direction =
+            (frame.cmd_type() & message_detail::response_bit) != 0 ? Direction::Response : Direction::Command;
+        auto it = table->find(key(frame.cmd_set(), frame.cmd_id(), direction));
+        if (it == table->end()) {
+            return false;
+        }
+        for (const Entry &entry : it->second) {
+            (*entry.handler)(frame);
+        }
+        return true;
+    }
+
+    mutable std::mutex table_mutex_;
+    std::shared_ptr<const Table> table_ = std::make_shared<Table>();
+    Token next_token_ = 1;
+
+    // 分发一帧期间持有，unsubscribe 借此等待使用旧订阅表的分发结束
+    std::mutex dispatch_mutex_;
+
+    ThreadSafeQueue<FrameView> queue_;
+
+    mutable std::mutex stats_mutex_;
+    Stats stats_;
+
+    std::thread worker_;
+};
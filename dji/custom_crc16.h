@@ -60,6 +60,26 @@ static inline crc16_t crc_init(void) { return 0x3aa3; }
  */
 crc16_t crc16_update(crc16_t crc, const void *data, size_t data_len);
 
+/**
+ * Byte-at-a-time reference kernel, bit-exact with every other crc16 kernel.
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] data     Pointer to a buffer of \a data_len bytes.
+ * \param[in] data_len Number of bytes in the \a data buffer.
+ * \return             The updated crc value.
+ */
+crc16_t crc16_update_table(crc16_t crc, const void *data, size_t data_len);
+
+/**
+ * Slice-by-8 kernel, folds eight bytes per table round. crc16_update uses it.
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] data     Pointer to a buffer of \a data_len bytes.
+ * \param[in] data_len Number of bytes in the \a data buffer.
+ * \return             The updated crc value.
+ */
+crc16_t crc16_update_slice8(crc16_t crc, const void *data, size_t data_len);
+
 /**
  * Calculate the final crc value.
  *
@@ -68,6 +88,41 @@ crc16_t crc16_update(crc16_t crc, const void *data, size_t data_len);
  */
 static inline crc16_t crc16_finalize(crc16_t crc) { return crc; }
 
+/**
+ * Advance a crc value over a run of zero bytes in O(log n).
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] zero_len Number of zero bytes to append.
+ * \return             The crc value after the zero bytes.
+ */
+crc16_t crc16_shift(crc16_t crc, size_t zero_len);
+
+/**
+ * Combine the crcs of two adjacent buffers without touching their data.
+ *
+ * Both crcs must have been computed from the regular init value.
+ *
+ * \param[in] crc1 The crc of the first buffer.
+ * \param[in] crc2 The crc of the second buffer.
+ * \param[in] len2 Length of the second buffer in bytes.
+ * \return         The crc of both buffers concatenated.
+ */
+crc16_t crc16_combine(crc16_t crc1, crc16_t crc2, size_t len2);
+
+/**
+ * Update a crc after \a len bytes changed from \a old_data to \a new_data.
+ *
+ * Costs O(len + log tail_len) regardless of the total buffer size.
+ *
+ * \param[in] crc      The crc over the original buffer.
+ * \param[in] old_data The bytes that were replaced.
+ * \param[in] new_data The replacement bytes.
+ * \param[in] len      Number of replaced bytes.
+ * \param[in] tail_len Number of covered bytes after the replaced range.
+ * \return             The crc over the modified buffer.
+ */
+crc16_t crc16_patch(crc16_t crc, const void *old_data, const void *new_data, size_t len, size_t tail_len);
+
 uint16_t calculate_crc16(const uint8_t *data, size_t length);
 
 #ifdef __cplusplus
@@ -60,6 +60,57 @@ static inline crc32_t crc32_init(void) { return 0x00003aa3; }
  */
 crc32_t crc32_update(crc32_t crc, const void *data, size_t data_len);
 
+/**
+ * Byte-at-a-time reference kernel, bit-exact with every other crc32 kernel.
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] data     Pointer to a buffer of \a data_len bytes.
+ * \param[in] data_len Number of bytes in the \a data buffer.
+ * \return             The updated crc value.
+ */
+crc32_t crc32_update_table(crc32_t crc, const void *data, size_t data_len);
+
+/**
+ * Slice-by-8 kernel, folds eight bytes per table round. Used when no carry-less multiply is available.
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] data     Pointer to a buffer of \a data_len bytes.
+ * \param[in] data_len Number of bytes in the \a data buffer.
+ * \return             The updated crc value.
+ */
+crc32_t crc32_update_slice8(crc32_t crc, const void *data, size_t data_len);
+
+/**
+ * Buffers shorter than this are not worth the carry-less multiply setup and go through slice-by-8.
+ */
+#define CRC32_CLMUL_MIN_LENGTH 64
+
+/**
+ * Carry-less multiply folding kernel (PCLMULQDQ on x86, PMULL on AArch64).
+ *
+ * Only call it when crc32_clmul_supported() returns non-zero.
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] data     Pointer to a buffer of \a data_len bytes.
+ * \param[in] data_len Number of bytes in the \a data buffer.
+ * \return             The updated crc value.
+ */
+crc32_t crc32_update_clmul(crc32_t crc, const void *data, size_t data_len);
+
+/**
+ * Check whether this build and CPU support crc32_update_clmul.
+ *
+ * \return     Non-zero when the carry-less multiply kernel can run.
+ */
+int crc32_clmul_supported(void);
+
+/**
+ * Name of the kernel crc32_update dispatches to on this CPU.
+ *
+ * \return     "pclmulqdq", "pmull" or "slice-by-8".
+ */
+const char *crc32_kernel_name(void);
+
 /**
  * Calculate the final crc value.
  *
@@ -68,6 +119,47 @@ crc32_t crc32_update(crc32_t crc, const void *data, size_t data_len);
  */
 static inline crc32_t crc32_finalize(crc32_t crc) { return crc; }
 
+/**
+ * Shifts over fewer zero bytes than this read their factor from a table, which covers every protocol frame.
+ */
+#define CRC32_SHIFT_TABLE_LENGTH 1024
+
+/**
+ * Advance a crc value over a run of zero bytes, one table lookup and one multiply below CRC32_SHIFT_TABLE_LENGTH
+ * bytes and O(log n) beyond.
+ *
+ * \param[in] crc      The current crc value.
+ * \param[in] zero_len Number of zero bytes to append.
+ * \return             The crc value after the zero bytes.
+ */
+crc32_t crc32_shift(crc32_t crc, size_t zero_len);
+
+/**
+ * Combine the crcs of two adjacent buffers without touching their data.
+ *
+ * Both crcs must have been computed from the regular init value.
+ *
+ * \param[in] crc1 The crc of the first buffer.
+ * \param[in] crc2 The crc of the second buffer.
+ * \param[in] len2 Length of the second buffer in bytes.
+ * \return         The crc of both buffers concatenated.
+ */
+crc32_t crc32_combine(crc32_t crc1, crc32_t crc2, size_t len2);
+
+/**
+ * Update a crc after \a len bytes changed from \a old_data to \a new_data.
+ *
+ * Costs O(len) plus one crc32_shift over \a tail_len, regardless of the total buffer size.
+ *
+ * \param[in] crc      The crc over the original buffer.
+ * \param[in] old_data The bytes that were replaced.
+ * \param[in] new_data The replacement bytes.
+ * \param[in] len      Number of replaced bytes.
+ * \param[in] tail_len Number of covered bytes after the replaced range.
+ * \return             The crc over the modified buffer.
+ */
+crc32_t crc32_patch(crc32_t crc, const void *old_data, const void *new_data, size_t len, size_t tail_len);
+
 uint32_t calculate_crc32(const uint8_t *data, size_t length);
 
 #ifdef __cplusplus
@@ -0,0 +1,318 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+/*
+ * Carry-less multiply folding for the crc32 variant used by the protocol (reflected 0xEDB88320, no final xor).
+ * The fold and Barrett constants are the bit-reflected ones from Intel's "Fast CRC Computation for Generic
+ * Polynomials Using PCLMULQDQ Instruction". They operate on the raw register, so the protocol's 0x3aa3 init
+ * passes straight through.
+ */
+
+#include "custom_crc32.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define CRC32_CLMUL_X86 1
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#define CRC32_TARGET_CLMUL __attribute__((target("sse2,pclmul")))
+#endif
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32_CLMUL_ARM 1
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+#ifdef __clang__
+#define CRC32_TARGET_CLMUL __attribute__((target("crypto")))
+#else
+#define CRC32_TARGET_CLMUL __attribute__((target("+crypto")))
+#endif
+#endif
+
+#if defined(CRC32_CLMUL_X86) || defined(CRC32_CLMUL_ARM)
+
+static const uint64_t k1k2[2] = {0x0154442bd4, 0x01c6e41596};
+static const uint64_t k3k4[2] = {0x01751997d0, 0x00ccaa009e};
+static const uint64_t k5k0[2] = {0x0163cd6124, 0x0000000000};
+static const uint64_t poly[2] = {0x01db710641, 0x01f7011641};
+
+#endif
+
+#if defined(CRC32_CLMUL_X86)
+
+/**
+ * Fold len bytes, len must be a multiple of 16 and at least 64.
+ */
+CRC32_TARGET_CLMUL static uint32_t crc32_fold(uint32_t crc, const unsigned char *buf, size_t len) {
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+
+    x0 = _mm_loadu_si128((const __m128i *)k1k2);
+
+    buf += 64;
+    len -= 64;
+
+    // Fold four 128-bit lanes in parallel
+    while (len >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128((const __m128i *)(buf + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *)(buf + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *)(buf + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *)(buf + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        buf += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = _mm_loadu_si128((const __m128i *)k3k4);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Fold remaining 16-byte blocks
+    while (len >= 16) {
+        x2 = _mm_loadu_si128((const __m128i *)buf);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        buf += 16;
+        len -= 16;
+    }
+
+    // Fold 128 bits down to 64
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_loadu_si128((const __m128i *)poly);
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+int crc32_clmul_supported(void) {
+    unsigned int ecx;
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 1);
+    ecx = (unsigned int)regs[2];
+#else
+    unsigned int eax, ebx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+#endif
+    // CPUID.01H:ECX.PCLMULQDQ[bit 1]
+    return (ecx >> 1) & 1;
+}
+
+#elif defined(CRC32_CLMUL_ARM)
+
+/* _mm_clmulepi64_si128 equivalents, lo/hi select the 64-bit lane of each operand */
+CRC32_TARGET_CLMUL static inline uint64x2_t clmul_lo_lo(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(a, 0), (poly64_t)vgetq_lane_u64(b, 0)));
+}
+
+CRC32_TARGET_CLMUL static inline uint64x2_t clmul_hi_hi(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(a, 1), (poly64_t)vgetq_lane_u64(b, 1)));
+}
+
+CRC32_TARGET_CLMUL static inline uint64x2_t clmul_lo_hi(uint64x2_t a, uint64x2_t b) {
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(a, 0), (poly64_t)vgetq_lane_u64(b, 1)));
+}
+
+/* _mm_srli_si128 equivalent */
+#define SHIFT_RIGHT_BYTES(x, n) vreinterpretq_u64_u8(vextq_u8(vreinterpretq_u8_u64(x), vdupq_n_u8(0), (n)))
+
+static inline uint64x2_t load_u64x2(const unsigned char *p) { return vreinterpretq_u64_u8(vld1q_u8(p)); }
+
+/**
+ * Fold len bytes, len must be a multiple of 16 and at least 64. Mirrors the x86 kernel step by step.
+ */
+CRC32_TARGET_CLMUL static uint32_t crc32_fold(uint32_t crc, const unsigned char *buf, size_t len) {
+    uint64x2_t x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = load_u64x2(buf + 0x00);
+    x2 = load_u64x2(buf + 0x10);
+    x3 = load_u64x2(buf + 0x20);
+    x4 = load_u64x2(buf + 0x30);
+
+    x1 = veorq_u64(x1, vreinterpretq_u64_u32(vsetq_lane_u32(crc, vdupq_n_u32(0), 0)));
+
+    x0 = vld1q_u64(k1k2);
+
+    buf += 64;
+    len -= 64;
+
+    // Fold four 128-bit lanes in parallel
+    while (len >= 64) {
+        x5 = clmul_lo_lo(x1, x0);
+        x6 = clmul_lo_lo(x2, x0);
+        x7 = clmul_lo_lo(x3, x0);
+        x8 = clmul_lo_lo(x4, x0);
+
+        x1 = clmul_hi_hi(x1, x0);
+        x2 = clmul_hi_hi(x2, x0);
+        x3 = clmul_hi_hi(x3, x0);
+        x4 = clmul_hi_hi(x4, x0);
+
+        x1 = veorq_u64(veorq_u64(x1, x5), load_u64x2(buf + 0x00));
+        x2 = veorq_u64(veorq_u64(x2, x6), load_u64x2(buf + 0x10));
+        x3 = veorq_u64(veorq_u64(x3, x7), load_u64x2(buf + 0x20));
+        x4 = veorq_u64(veorq_u64(x4, x8), load_u64x2(buf + 0x30));
+
+        buf += 64;
+        len -= 64;
+    }
+
+    // Fold the four lanes into one
+    x0 = vld1q_u64(k3k4);
+
+    x5 = clmul_lo_lo(x1, x0);
+    x1 = clmul_hi_hi(x1, x0);
+    x1 = veorq_u64(veorq_u64(x1, x2), x5);
+
+    x5 = clmul_lo_lo(x1, x0);
+    x1 = clmul_hi_hi(x1, x0);
+    x1 = veorq_u64(veorq_u64(x1, x3), x5);
+
+    x5 = clmul_lo_lo(x1, x0);
+    x1 = clmul_hi_hi(x1, x0);
+    x1 = veorq_u64(veorq_u64(x1, x4), x5);
+
+    // Fold remaining 16-byte blocks
+    while (len >= 16) {
+        x2 = load_u64x2(buf);
+
+        x5 = clmul_lo_lo(x1, x0);
+        x1 = clmul_hi_hi(x1, x0);
+        x1 = veorq_u64(veorq_u64(x1, x2), x5);
+
+        buf += 16;
+        len -= 16;
+    }
+
+    // Fold 128 bits down to 64
+    x2 = clmul_lo_hi(x1, x0);
+    x3 = vreinterpretq_u64_u32(vcombine_u32(vcreate_u32(0x00000000ffffffffULL), vcreate_u32(0x00000000ffffffffULL)));
+    x1 = SHIFT_RIGHT_BYTES(x1, 8);
+    x1 = veorq_u64(x1, x2);
+
+    x0 = vld1q_u64(k5k0);
+
+    x2 = SHIFT_RIGHT_BYTES(x1, 4);
+    x1 = vandq_u64(x1, x3);
+    x1 = clmul_lo_lo(x1, x0);
+    x1 = veorq_u64(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = vld1q_u64(poly);
+
+    x2 = vandq_u64(x1, x3);
+    x2 = clmul_lo_hi(x2, x0);
+    x2 = vandq_u64(x2, x3);
+    x2 = clmul_lo_lo(x2, x0);
+    x1 = veorq_u64(x1, x2);
+
+    return vgetq_lane_u32(vreinterpretq_u32_u64(x1), 1);
+}
+
+int crc32_clmul_supported(void) {
+#if defined(__APPLE__)
+    return 1;
+#elif defined(__linux__) && defined(HWCAP_PMULL)
+    return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+#else
+    return 0;
+#endif
+}
+
+#else
+
+int crc32_clmul_supported(void) { return 0; }
+
+#endif
+
+crc32_t crc32_update_clmul(crc32_t crc, const void *data, size_t data_len) {
+    const unsigned char *d = (const unsigned char *)data;
+
+#if defined(CRC32_CLMUL_X86) || defined(CRC32_CLMUL_ARM)
+    if (data_len >= CRC32_CLMUL_MIN_LENGTH) {
+        size_t bulk = data_len & ~(size_t)15;
+        crc = crc32_fold((uint32_t)crc, d, bulk);
+        d += bulk;
+        data_len -= bulk;
+    }
+#endif
+    return crc32_update_slice8(crc, d, data_len);
+}
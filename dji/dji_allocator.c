@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+#include <stdlib.h>
+
+#include "dji_allocator.h"
+
+static void *default_malloc(size_t size, void *user_data) {
+    (void)user_data;
+    return malloc(size);
+}
+
+static void default_free(void *ptr, void *user_data) {
+    (void)user_data;
+    free(ptr);
+}
+
+static dji_malloc_func_t s_malloc = default_malloc;
+static dji_free_func_t s_free = default_free;
+static void *s_user_data = NULL;
+
+/**
+ * @brief Replace the allocation hooks, NULL restores the C runtime heap
+ *        替换分配钩子，传入 NULL 时恢复使用 C 运行时堆
+ *
+ * @param malloc_func Allocation function
+ *                    分配函数
+ * @param free_func Release function
+ *                  释放函数
+ * @param user_data Passed to both hooks
+ *                  传递给两个钩子的用户数据
+ */
+void dji_set_allocator(dji_malloc_func_t malloc_func, dji_free_func_t free_func, void *user_data) {
+    if (malloc_func == NULL || free_func == NULL) {
+        s_malloc = default_malloc;
+        s_free = default_free;
+        s_user_data = NULL;
+        return;
+    }
+
+    s_malloc = malloc_func;
+    s_free = free_func;
+    s_user_data = user_data;
+}
+
+void *dji_malloc(size_t size) {
+    return s_malloc(size, s_user_data);
+}
+
+void dji_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+    s_free(ptr, s_user_data);
+}
@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Allocation hooks used for every buffer the library hands back to the caller
+ *        库返回给调用方的所有缓冲区都通过此分配钩子分配
+ *
+ * Buffers returned by protocol_parse_data, protocol_create_frame and the data creators must be released with
+ * dji_free. Install the hooks before the first allocation; memory obtained through one pair of hooks must not
+ * be released through another.
+ * protocol_parse_data、protocol_create_frame 及各 creator 返回的缓冲区必须使用 dji_free 释放。
+ * 需在第一次分配前设置钩子；通过一组钩子分配的内存不能通过另一组钩子释放。
+ */
+typedef void *(*dji_malloc_func_t)(size_t size, void *user_data);
+typedef void (*dji_free_func_t)(void *ptr, void *user_data);
+
+void dji_set_allocator(dji_malloc_func_t malloc_func, dji_free_func_t free_func, void *user_data);
+
+void *dji_malloc(size_t size);
+
+void dji_free(void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
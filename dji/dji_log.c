@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+#include <stdio.h>
+
+#include "dji_log.h"
+
+/**
+ * Line buffer of the default sink, longer records are truncated
+ * 默认输出的行缓冲区，更长的记录被截断
+ */
+#define DJI_LOG_LINE_SIZE 512
+
+static const char *const level_names[] = {"NONE", "ERROR", "WARN", "INFO", "DEBUG"};
+
+/**
+ * @brief Format one record into a line and print it to stream
+ *        将一条记录格式化为一行并输出到 stream
+ *
+ * The line is written with a single call so that records from different threads do not interleave
+ * 整行通过一次调用写出，不同线程的记录不会相互穿插
+ */
+static void write_line(FILE *stream, int level, const char *tag, const char *format, va_list args) {
+    char line[DJI_LOG_LINE_SIZE];
+    int prefix = snprintf(line, sizeof(line), "[%s][%s] ", dji_log_level_name(level), tag);
+    if (prefix < 0) {
+        return;
+    }
+    size_t used = (size_t)prefix < sizeof(line) ? (size_t)prefix : sizeof(line) - 1;
+    int body = vsnprintf(line + used, sizeof(line) - used, format, args);
+    if (body > 0) {
+        used += (size_t)body < sizeof(line) - used ? (size_t)body : sizeof(line) - used - 1;
+    }
+    // Keep room for the newline even when the message was truncated
+    // 消息被截断时也保留换行符的位置
+    if (used > sizeof(line) - 2) {
+        used = sizeof(line) - 2;
+    }
+    line[used++] = '\n';
+    line[used] = '\0';
+    fputs(line, stream);
+}
+
+/**
+ * @brief Default sink, formats on the calling thread and prints errors and warnings to stderr, the rest to stdout
+ *        默认输出，在调用线程上格式化，错误与警告输出到 stderr，其余输出到 stdout
+ */
+static void default_sink(int level, const char *tag, const char *format, va_list args, void *user_data) {
+    (void)user_data;
+    write_line(level <= DJI_LOG_LEVEL_WARN ? stderr : stdout, level, tag, format, args);
+}
+
+/**
+ * @brief Sink that prints every level to stderr, for tools whose stdout carries their results
+ *        将所有级别输出到 stderr 的日志输出，用于 stdout 承载结果的工具
+ */
+void dji_log_stderr_sink(int level, const char *tag, const char *format, va_list args, void *user_data) {
+    (void)user_data;
+    write_line(stderr, level, tag, format, args);
+}
+
+static dji_log_sink_t s_sink = default_sink;
+static void *s_user_data = NULL;
+
+/**
+ * @brief Replace the log sink, NULL restores printing on the calling thread
+ *        替换日志输出，传入 NULL 时恢复在调用线程上直接打印
+ *
+ * Like dji_set_allocator this is not synchronized with logging threads: set it before they start and restore it
+ * after they have stopped.
+ * 与 dji_set_allocator 一样，此函数不与记录日志的线程同步：需在这些线程启动前设置，在其停止后恢复。
+ *
+ * @param sink Sink function
+ *             输出函数
+ * @param user_data Passed to the sink
+ *                  传递给输出函数的用户数据
+ */
+void dji_set_log_sink(dji_log_sink_t sink, void *user_data) {
+    if (sink == NULL) {
+        s_sink = default_sink;
+        s_user_data = NULL;
+        return;
+    }
+
+    s_sink = sink;
+    s_user_data = user_data;
+}
+
+void dji_log_write(int level, const char *tag, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    s_sink(level, tag, format, args, s_user_data);
+    va_end(args);
+}
+
+const char *dji_log_level_name(int level) {
+    if (level < DJI_LOG_LEVEL_NONE || level > DJI_LOG_LEVEL_DEBUG) {
+        return "?";
+    }
+    return level_names[level];
+}
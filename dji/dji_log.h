@@ -0,0 +1,97 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+#pragma once
+
+#include <stdarg.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Log levels, a record is kept when its level is less than or equal to the threshold
+ * 日志级别，记录的级别小于等于阈值时才会输出
+ */
+#define DJI_LOG_LEVEL_NONE 0
+#define DJI_LOG_LEVEL_ERROR 1
+#define DJI_LOG_LEVEL_WARN 2
+#define DJI_LOG_LEVEL_INFO 3
+#define DJI_LOG_LEVEL_DEBUG 4
+
+/**
+ * Compile-time threshold, calls above it are removed by the preprocessor and their arguments are never evaluated
+ * 编译期阈值，高于该级别的调用由预处理器移除，其参数不会被求值
+ */
+#ifndef DJI_LOG_LEVEL
+#define DJI_LOG_LEVEL DJI_LOG_LEVEL_INFO
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DJI_LOG_PRINTF_FORMAT __attribute__((format(printf, 3, 4)))
+#else
+#define DJI_LOG_PRINTF_FORMAT
+#endif
+
+/**
+ * @brief Receives every enabled log record
+ *        接收每一条已启用的日志记录
+ *
+ * tag and format come from the ESP_LOG* macros and are string literals, so a sink may keep the pointers instead of
+ * copying them. The sink is called on the logging thread and must not block it.
+ * tag 与 format 来自 ESP_LOG* 宏，均为字符串字面量，日志接收端可以直接保存指针而无需拷贝。接收端在记录日志的
+ * 线程上被调用，不应阻塞该线程。
+ */
+typedef void (*dji_log_sink_t)(int level, const char *tag, const char *format, va_list args, void *user_data);
+
+void dji_set_log_sink(dji_log_sink_t sink, void *user_data);
+
+/**
+ * Sink that formats on the calling thread like the default one but prints every level to stderr
+ * 与默认输出一样在调用线程上格式化，但所有级别都输出到 stderr
+ */
+void dji_log_stderr_sink(int level, const char *tag, const char *format, va_list args, void *user_data);
+
+void dji_log_write(int level, const char *tag, const char *format, ...) DJI_LOG_PRINTF_FORMAT;
+
+const char *dji_log_level_name(int level);
+
+/**
+ * Disabled levels still type-check their arguments but generate no code
+ * 被禁用的级别仍会检查参数类型，但不生成任何代码
+ */
+#define DJI_LOG_IF(enabled, level, tag, format, ...)                                                                   \
+    do {                                                                                                               \
+        if (enabled) {                                                                                                 \
+            dji_log_write(level, tag, "" format, ##__VA_ARGS__);                                                       \
+        }                                                                                                              \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...)                                                                                     \
+    DJI_LOG_IF(DJI_LOG_LEVEL >= DJI_LOG_LEVEL_ERROR, DJI_LOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)                                                                                     \
+    DJI_LOG_IF(DJI_LOG_LEVEL >= DJI_LOG_LEVEL_WARN, DJI_LOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)                                                                                     \
+    DJI_LOG_IF(DJI_LOG_LEVEL >= DJI_LOG_LEVEL_INFO, DJI_LOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)                                                                                     \
+    DJI_LOG_IF(DJI_LOG_LEVEL >= DJI_LOG_LEVEL_DEBUG, DJI_LOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,6 +20,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dji_allocator.h"
 #include "dji_protocol_data_descriptors.h"
 #include "dji_protocol_data_structures.h"
 
@@ -30,67 +31,106 @@
 const data_descriptor_t data_descriptors[] = {
     // Camera mode switch
     // 拍摄模式切换
-    {0x1D, 0x04, (data_creator_func_t)camera_mode_switch_creator, (data_parser_func_t)camera_mode_switch_parser},
+    {0x1D, 0x04, (data_creator_func_t)camera_mode_switch_creator, (data_parser_func_t)camera_mode_switch_parser,
+     (data_encoder_func_t)camera_mode_switch_encoder},
     // Version query
     // 版本号查询
-    {0x00, 0x00, NULL, (data_parser_func_t)version_query_parser},
+    {0x00, 0x00, NULL, (data_parser_func_t)version_query_parser, NULL},
     // Record control
     // 拍录控制
-    {0x1D, 0x03, (data_creator_func_t)record_control_creator, (data_parser_func_t)record_control_parser},
+    {0x1D, 0x03, (data_creator_func_t)record_control_creator, (data_parser_func_t)record_control_parser,
+     (data_encoder_func_t)record_control_encoder},
     // GPS data push
     // GPS 数据推送
-    {0x00, 0x17, (data_creator_func_t)gps_data_creator, (data_parser_func_t)gps_data_parser},
+    {0x00, 0x17, (data_creator_func_t)gps_data_creator, (data_parser_func_t)gps_data_parser,
+     (data_encoder_func_t)gps_data_encoder},
     // Connection request
     // 连接请求
-    {0x00, 0x19, (data_creator_func_t)connection_data_creator, (data_parser_func_t)connection_data_parser},
+    {0x00, 0x19, (data_creator_func_t)connection_data_creator, (data_parser_func_t)connection_data_parser,
+     (data_encoder_func_t)connection_data_encoder},
     // Camera status subscription
     // 相机状态订阅
-    {0x1D, 0x05, (data_creator_func_t)camera_status_subscription_creator, NULL},
+    {0x1D, 0x05, (data_creator_func_t)camera_status_subscription_creator, NULL,
+     (data_encoder_func_t)camera_status_subscription_encoder},
     // Camera status push
     // 相机状态推送
-    {0x1D, 0x02, NULL, (data_parser_func_t)camera_status_push_data_parser},
+    {0x1D, 0x02, NULL, (data_parser_func_t)camera_status_push_data_parser, NULL},
     // Key report
     // 按键上报
-    {0x00, 0x11, (data_creator_func_t)key_report_creator, (data_parser_func_t)key_report_parser},
+    {0x00, 0x11, (data_creator_func_t)key_report_creator, (data_parser_func_t)key_report_parser,
+     (data_encoder_func_t)key_report_encoder},
 };
 const size_t DATA_DESCRIPTORS_COUNT = sizeof(data_descriptors) / sizeof(data_descriptors[0]);
 
-/* Structure support creators and parsers
- * 结构体支持的 creator 和 parser */
-uint8_t *camera_mode_switch_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
-    if (structure == NULL || data_length == NULL) {
-        ESP_LOGE(TAG, "Invalid input: structure or data_length is NULL");
+/**
+ * Copy a packed structure into the output buffer; out may be NULL to query the length only
+ * 将紧凑结构体拷贝到输出缓冲区；out 为 NULL 时仅查询长度
+ */
+static int encode_structure(const void *structure, size_t size, uint8_t *out, size_t capacity, size_t *data_length) {
+    *data_length = size;
+    if (out == NULL) {
+        return 0;
+    }
+    if (capacity < size) {
+        ESP_LOGE(TAG, "Output buffer too small: need %zu, have %zu", size, capacity);
+        return -2;
+    }
+    memcpy(out, structure, size);
+    return 0;
+}
+
+/**
+ * Heap-allocating creator built on top of an encoder, kept for callers of data_creator_func_t
+ * 基于编码函数实现的堆分配 creator，供 data_creator_func_t 的调用方继续使用
+ */
+static uint8_t *create_with_encoder(data_encoder_func_t encoder, const void *structure, size_t *data_length,
+                                    uint8_t cmd_type) {
+    if (data_length == NULL) {
+        ESP_LOGE(TAG, "Invalid input: data_length is NULL");
         return NULL;
     }
 
-    uint8_t *data = NULL;
+    size_t length = 0;
+    if (encoder(structure, NULL, 0, &length, cmd_type) != 0) {
+        return NULL;
+    }
 
-    // Check if it's a command frame
-    // 判断是否为命令帧
-    if ((cmd_type & 0x20) == 0) {
-        const camera_mode_switch_command_frame_t *command_frame = (const camera_mode_switch_command_frame_t *)structure;
+    uint8_t *data = (uint8_t *)dji_malloc(length);
+    if (data == NULL) {
+        ESP_LOGE(TAG, "Memory allocation failed for %zu byte payload", length);
+        return NULL;
+    }
 
-        *data_length = sizeof(camera_mode_switch_command_frame_t);
+    if (encoder(structure, data, length, &length, cmd_type) != 0) {
+        dji_free(data);
+        return NULL;
+    }
 
-        ESP_LOGI(TAG, "Data length calculated for camera_mode_switch_command_frame: %zu", *data_length);
+    *data_length = length;
+    return data;
+}
 
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in camera_mode_switch_creator");
-            return NULL;
-        }
+/* Structure support creators and parsers
+ * 结构体支持的 creator 和 parser */
+uint8_t *camera_mode_switch_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
+    return create_with_encoder(camera_mode_switch_encoder, structure, data_length, cmd_type);
+}
 
-        ESP_LOGI(TAG, "Memory allocation succeeded for command frame, copying data...");
+int camera_mode_switch_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                               uint8_t cmd_type) {
+    if (structure == NULL || data_length == NULL) {
+        ESP_LOGE(TAG, "camera_mode_switch_encoder: NULL input detected");
+        return -1;
+    }
 
-        memcpy(data, command_frame, *data_length);
-    } else {
-        // 暂不支持此功能的应答帧创建
-        // Response frame creation for this functionality is not yet supported.
-        ESP_LOGE(TAG, "Response frames are not supported in camera_mode_switch_creator");
-        return NULL;
+    if ((cmd_type & 0x20) == 0) {
+        return encode_structure(structure, sizeof(camera_mode_switch_command_frame_t), out, capacity, data_length);
     }
 
-    return data;
+    // 暂不支持此功能的应答帧创建
+    // Response frame creation for this functionality is not yet supported.
+    ESP_LOGE(TAG, "Response frames are not supported in camera_mode_switch_encoder");
+    return -1;
 }
 
 int camera_mode_switch_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type) {
@@ -173,35 +213,24 @@ int version_query_parser(const uint8_t *data, size_t data_length, void *structur
 }
 
 uint8_t *record_control_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
+    return create_with_encoder(record_control_encoder, structure, data_length, cmd_type);
+}
+
+int record_control_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                           uint8_t cmd_type) {
     if (structure == NULL || data_length == NULL) {
-        ESP_LOGE(TAG, "Invalid input: structure or data_length is NULL");
-        return NULL;
+        ESP_LOGE(TAG, "record_control_encoder: NULL input detected");
+        return -1;
     }
 
-    uint8_t *data = NULL;
-
     if ((cmd_type & 0x20) == 0) {
-        const record_control_command_frame_t *command_frame = (const record_control_command_frame_t *)structure;
-
-        *data_length = sizeof(record_control_command_frame_t);
-
-        ESP_LOGI(TAG, "Data length calculated for record_control_command_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in record_control_creator");
-            return NULL;
-        }
-
-        ESP_LOGI(TAG, "Memory allocation succeeded for command frame, copying data...");
-
-        memcpy(data, command_frame, *data_length);
-    } else {
-        ESP_LOGE(TAG, "Response frames are not supported in record_control_creator");
-        return NULL;
+        return encode_structure(structure, sizeof(record_control_command_frame_t), out, capacity, data_length);
     }
 
-    return data;
+    // 暂不支持此功能的应答帧创建
+    // Response frame creation for this functionality is not yet supported.
+    ESP_LOGE(TAG, "Response frames are not supported in record_control_encoder");
+    return -1;
 }
 
 int record_control_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type) {
@@ -234,47 +263,19 @@ int record_control_parser(const uint8_t *data, size_t data_length, void *structu
 }
 
 uint8_t *gps_data_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
+    return create_with_encoder(gps_data_encoder, structure, data_length, cmd_type);
+}
+
+int gps_data_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length, uint8_t cmd_type) {
     if (structure == NULL || data_length == NULL) {
-        ESP_LOGE(TAG, "Invalid input: structure or data_length is NULL");
-        return NULL;
+        ESP_LOGE(TAG, "gps_data_encoder: NULL input detected");
+        return -1;
     }
 
-    uint8_t *data = NULL;
-
     if ((cmd_type & 0x20) == 0) {
-        const gps_data_push_command_frame *gps_command_frame = (const gps_data_push_command_frame *)structure;
-
-        *data_length = sizeof(gps_data_push_command_frame);
-
-        ESP_LOGI(TAG, "Data length calculated for gps_data_push_command_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in gps_data_creator (command frame)");
-            return NULL;
-        }
-
-        ESP_LOGI(TAG, "Memory allocation succeeded for command frame, copying data...");
-
-        memcpy(data, gps_command_frame, *data_length);
-    } else {
-        const gps_data_push_response_frame *gps_response_frame = (const gps_data_push_response_frame *)structure;
-
-        *data_length = sizeof(gps_data_push_response_frame);
-
-        ESP_LOGI(TAG, "Data length calculated for gps_data_push_response_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in gps_data_creator (response frame)");
-            return NULL;
-        }
-
-        ESP_LOGI(TAG, "Memory allocation succeeded for response frame, copying data...");
-
-        memcpy(data, gps_response_frame, *data_length);
+        return encode_structure(structure, sizeof(gps_data_push_command_frame), out, capacity, data_length);
     }
-    return data;
+    return encode_structure(structure, sizeof(gps_data_push_response_frame), out, capacity, data_length);
 }
 
 int gps_data_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type) {
@@ -304,44 +305,20 @@ int gps_data_parser(const uint8_t *data, size_t data_length, void *structure_out
 }
 
 uint8_t *connection_data_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
+    return create_with_encoder(connection_data_encoder, structure, data_length, cmd_type);
+}
+
+int connection_data_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                            uint8_t cmd_type) {
     if (structure == NULL || data_length == NULL) {
-        ESP_LOGE(TAG, "connection_request_data_creator: NULL input detected");
-        return NULL;
+        ESP_LOGE(TAG, "connection_data_encoder: NULL input detected");
+        return -1;
     }
 
-    uint8_t *data = NULL;
-
     if ((cmd_type & 0x20) == 0) {
-        const connection_request_command_frame *command_frame = (const connection_request_command_frame *)structure;
-
-        *data_length = sizeof(connection_request_command_frame);
-
-        ESP_LOGI(TAG, "Data length calculated for connection_request_command_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in connection_request_data_creator (command frame)");
-            return NULL;
-        }
-
-        memcpy(data, command_frame, *data_length);
-    } else {
-        const connection_request_response_frame *response_frame = (const connection_request_response_frame *)structure;
-
-        *data_length = sizeof(connection_request_response_frame);
-
-        ESP_LOGI(TAG, "Data length calculated for connection_request_response_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in connection_request_data_creator (response frame)");
-            return NULL;
-        }
-
-        memcpy(data, response_frame, *data_length);
+        return encode_structure(structure, sizeof(connection_request_command_frame), out, capacity, data_length);
     }
-
-    return data;
+    return encode_structure(structure, sizeof(connection_request_response_frame), out, capacity, data_length);
 }
 
 int connection_data_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type) {
@@ -398,35 +375,25 @@ int connection_data_parser(const uint8_t *data, size_t data_length, void *struct
 }
 
 uint8_t *camera_status_subscription_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
+    return create_with_encoder(camera_status_subscription_encoder, structure, data_length, cmd_type);
+}
+
+int camera_status_subscription_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                                       uint8_t cmd_type) {
     if (structure == NULL || data_length == NULL) {
-        ESP_LOGE(TAG, "Invalid input: structure or data_length is NULL");
-        return NULL;
+        ESP_LOGE(TAG, "camera_status_subscription_encoder: NULL input detected");
+        return -1;
     }
 
-    uint8_t *data = NULL;
-
     if ((cmd_type & 0x20) == 0) {
-        const camera_status_subscription_command_frame *camera_command_frame =
-            (const camera_status_subscription_command_frame *)structure;
-
-        *data_length = sizeof(camera_status_subscription_command_frame);
-
-        ESP_LOGI(TAG, "Data length calculated for camera_status_subscription_command_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in camera_status_subscription_creator");
-            return NULL;
-        }
-
-        ESP_LOGI(TAG, "Memory allocation succeeded for command frame, copying data...");
-
-        memcpy(data, camera_command_frame, *data_length);
-    } else {
-        ESP_LOGE(TAG, "Response frames are not supported in camera_status_subscription_creator");
-        return NULL;
+        return encode_structure(structure, sizeof(camera_status_subscription_command_frame), out, capacity,
+                                data_length);
     }
-    return data;
+
+    // 暂不支持此功能的应答帧创建
+    // Response frame creation for this functionality is not yet supported.
+    ESP_LOGE(TAG, "Response frames are not supported in camera_status_subscription_encoder");
+    return -1;
 }
 
 int camera_status_push_data_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type) {
@@ -478,35 +445,23 @@ int camera_status_push_data_parser(const uint8_t *data, size_t data_length, void
 }
 
 uint8_t *key_report_creator(const void *structure, size_t *data_length, uint8_t cmd_type) {
+    return create_with_encoder(key_report_encoder, structure, data_length, cmd_type);
+}
+
+int key_report_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length, uint8_t cmd_type) {
     if (structure == NULL || data_length == NULL) {
-        ESP_LOGE(TAG, "Invalid input: structure or data_length is NULL");
-        return NULL;
+        ESP_LOGE(TAG, "key_report_encoder: NULL input detected");
+        return -1;
     }
 
-    uint8_t *data = NULL;
-
     if ((cmd_type & 0x20) == 0) {
-        const key_report_command_frame_t *command_frame = (const key_report_command_frame_t *)structure;
-
-        *data_length = sizeof(key_report_command_frame_t);
-
-        ESP_LOGI(TAG, "Data length calculated for key_report_command_frame: %zu", *data_length);
-
-        data = (uint8_t *)malloc(*data_length);
-        if (data == NULL) {
-            ESP_LOGE(TAG, "Memory allocation failed in key_report_creator");
-            return NULL;
-        }
-
-        ESP_LOGI(TAG, "Memory allocation succeeded for command frame, copying data...");
-
-        memcpy(data, command_frame, *data_length);
-    } else {
-        ESP_LOGE(TAG, "Response frames are not supported in key_report_creator");
-        return NULL;
+        return encode_structure(structure, sizeof(key_report_command_frame_t), out, capacity, data_length);
     }
 
-    return data;
+    // 暂不支持此功能的应答帧创建
+    // Response frame creation for this functionality is not yet supported.
+    ESP_LOGE(TAG, "Response frames are not supported in key_report_encoder");
+    return -1;
 }
 
 int key_report_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type) {
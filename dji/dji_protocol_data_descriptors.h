@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -29,6 +30,8 @@ extern "C" {
 /* 结构体支持 */
 typedef uint8_t *(*data_creator_func_t)(const void *structure, size_t *data_length, uint8_t cmd_type);
 typedef int (*data_parser_func_t)(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
+typedef int (*data_encoder_func_t)(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                                   uint8_t cmd_type);
 
 typedef struct {
     uint8_t cmd_set;             // Command set identifier (CmdSet)
@@ -39,29 +42,40 @@ typedef struct {
                                  // 数据创建函数指针
     data_parser_func_t parser;   // Data parsing function pointer
                                  // 数据解析函数指针
+    data_encoder_func_t encoder; // Allocation-free encoding function pointer
+                                 // 无内存分配的编码函数指针
 } data_descriptor_t;
 extern const data_descriptor_t data_descriptors[];
 extern const size_t DATA_DESCRIPTORS_COUNT;
 
 uint8_t *camera_mode_switch_creator(const void *structure, size_t *data_length, uint8_t cmd_type);
+int camera_mode_switch_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                               uint8_t cmd_type);
 int camera_mode_switch_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 int version_query_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 uint8_t *record_control_creator(const void *structure, size_t *data_length, uint8_t cmd_type);
+int record_control_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length, uint8_t cmd_type);
 int record_control_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 uint8_t *gps_data_creator(const void *structure, size_t *data_length, uint8_t cmd_type);
+int gps_data_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length, uint8_t cmd_type);
 int gps_data_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 uint8_t *connection_data_creator(const void *structure, size_t *data_length, uint8_t cmd_type);
+int connection_data_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                            uint8_t cmd_type);
 int connection_data_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 uint8_t *camera_status_subscription_creator(const void *structure, size_t *data_length, uint8_t cmd_type);
+int camera_status_subscription_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length,
+                                       uint8_t cmd_type);
 
 int camera_status_push_data_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 uint8_t *key_report_creator(const void *structure, size_t *data_length, uint8_t cmd_type);
+int key_report_encoder(const void *structure, uint8_t *out, size_t capacity, size_t *data_length, uint8_t cmd_type);
 int key_report_parser(const uint8_t *data, size_t data_length, void *structure_out, uint8_t cmd_type);
 
 #ifdef __cplusplus
@@ -17,18 +17,56 @@
  * failure to do so.
  */
 
-#include <stdio.h>
 #include <string.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 #include "dji_protocol_data_processor.h"
 #include "dji_protocol_data_structures.h"
 
 #define TAG "DJI_PROTOCOL_DATA_PROCESSOR"
 
+/**
+ * Direct-indexed dispatch table, (cmd_set << 8 | cmd_id) -> index + 1 into data_descriptors, 0 when unregistered.
+ * Built once from data_descriptors so the two can never disagree.
+ * 直接索引分发表，(cmd_set << 8 | cmd_id) -> data_descriptors 下标 + 1，未注册为 0。
+ * 由 data_descriptors 一次性生成，二者始终一致。
+ */
+static uint16_t descriptor_index[0x10000];
+
+static void build_descriptor_index(void) {
+    // Walk backwards so that the first entry wins on duplicates, like the linear scan did
+    // 倒序遍历，重复项以第一个为准，与原线性查找一致
+    for (size_t i = DATA_DESCRIPTORS_COUNT; i-- > 0;) {
+        descriptor_index[(data_descriptors[i].cmd_set << 8) | data_descriptors[i].cmd_id] = (uint16_t)(i + 1);
+    }
+}
+
+#ifdef _WIN32
+static INIT_ONCE descriptor_index_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK build_descriptor_index_once(PINIT_ONCE once, PVOID parameter, PVOID *context) {
+    (void)once;
+    (void)parameter;
+    (void)context;
+    build_descriptor_index();
+    return TRUE;
+}
+#else
+static pthread_once_t descriptor_index_once = PTHREAD_ONCE_INIT;
+#endif
+
 /**
  * @brief Find data descriptor by command set and command ID
  *        根据命令集和命令ID查找对应的数据描述符
  *
+ * O(1) regardless of the number of registered descriptors
+ * 查找开销与已注册描述符数量无关，为 O(1)
+ *
  * @param cmd_set Command set
  *                命令集
  * @param cmd_id Command ID
@@ -37,12 +75,14 @@
  *         返回找到的数据描述符指针，如果未找到则返回NULL
  */
 const data_descriptor_t *find_data_descriptor(uint8_t cmd_set, uint8_t cmd_id) {
-    for (size_t i = 0; i < DATA_DESCRIPTORS_COUNT; ++i) {
-        if (data_descriptors[i].cmd_set == cmd_set && data_descriptors[i].cmd_id == cmd_id) {
-            return &data_descriptors[i];
-        }
-    }
-    return NULL;
+#ifdef _WIN32
+    InitOnceExecuteOnce(&descriptor_index_once, build_descriptor_index_once, NULL, NULL);
+#else
+    pthread_once(&descriptor_index_once, build_descriptor_index);
+#endif
+
+    uint16_t index = descriptor_index[(cmd_set << 8) | cmd_id];
+    return index != 0 ? &data_descriptors[index - 1] : NULL;
 }
 
 /**
@@ -72,14 +112,37 @@ int data_parser_by_structure(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type,
     // 查找对应的命令描述符
     const data_descriptor_t *descriptor = find_data_descriptor(cmd_set, cmd_id);
     if (descriptor == NULL) {
-        fprintf(stderr, "Descriptor not found for CmdSet: 0x%02X, CmdID: 0x%02X\n", cmd_set, cmd_id);
+        ESP_LOGE(TAG, "Descriptor not found for CmdSet: 0x%02X, CmdID: 0x%02X", cmd_set, cmd_id);
         return -1;
     }
 
+    return data_parser_by_descriptor(descriptor, cmd_type, data, data_length, structure_out);
+}
+
+/**
+ * @brief Parse data with an already resolved descriptor
+ *        使用已查找到的描述符解析数据
+ *
+ * @param descriptor Data descriptor
+ *                   数据描述符
+ * @param cmd_type Command type
+ *                 命令类型
+ * @param data Input data
+ *             输入数据
+ * @param data_length Data length
+ *                    数据长度
+ * @param structure_out Output structure
+ *                      输出结构体
+ * @return Return 0 on success, -1 on failure
+ *         成功返回0，失败返回-1
+ */
+int data_parser_by_descriptor(const data_descriptor_t *descriptor, uint8_t cmd_type, const uint8_t *data,
+                              size_t data_length, void *structure_out) {
     // Check if parser function exists
     // 检查解析函数是否存在
     if (descriptor->parser == NULL) {
-        fprintf(stderr, "Parser function is NULL for CmdSet: 0x%02X, CmdID: 0x%02X\n", cmd_set, cmd_id);
+        ESP_LOGE(TAG, "Parser function is NULL for CmdSet: 0x%02X, CmdID: 0x%02X", descriptor->cmd_set,
+                 descriptor->cmd_id);
         return -1;
     }
 
@@ -109,16 +172,61 @@ uint8_t *data_creator_by_structure(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_
     // 查找对应的命令描述符
     const data_descriptor_t *descriptor = find_data_descriptor(cmd_set, cmd_id);
     if (descriptor == NULL) {
-        fprintf(stderr, "Descriptor not found for CmdSet: 0x%02X, CmdID: 0x%02X\n", cmd_set, cmd_id);
+        ESP_LOGE(TAG, "Descriptor not found for CmdSet: 0x%02X, CmdID: 0x%02X", cmd_set, cmd_id);
         return NULL;
     }
 
     // Check if creator function exists
     // 检查创建函数是否存在
     if (descriptor->creator == NULL) {
-        fprintf(stderr, "Creator function is NULL for CmdSet: 0x%02X, CmdID: 0x%02X\n", cmd_set, cmd_id);
+        ESP_LOGE(TAG, "Creator function is NULL for CmdSet: 0x%02X, CmdID: 0x%02X", cmd_set, cmd_id);
         return NULL;
     }
 
     return descriptor->creator(structure, data_length, cmd_type);
 }
+
+/**
+ * @brief Encode structure into caller-provided buffer
+ *        将结构体编码到调用方提供的缓冲区
+ *
+ * Same lookup as data_creator_by_structure, but writes the payload in place without heap allocation
+ * 与 data_creator_by_structure 查找方式相同，但直接就地写入有效载荷，不进行堆分配
+ *
+ * @param cmd_set Command set
+ *                命令集
+ * @param cmd_id Command ID
+ *               命令 ID
+ * @param cmd_type Command type
+ *                 命令类型
+ * @param structure Pointer to data structure
+ *                  数据结构指针
+ * @param out Output buffer, NULL to query the payload length only
+ *            输出缓冲区，为 NULL 时仅查询有效载荷长度
+ * @param capacity Size of output buffer
+ *                 输出缓冲区大小
+ * @param data_length Output parameter for payload length
+ *                    有效载荷长度输出参数
+ *
+ * @return int 0 on success, -1 on invalid input or unsupported command, -2 if the buffer is too small
+ *             成功返回 0，输入无效或命令不支持返回 -1，缓冲区不足返回 -2
+ */
+int data_encoder_by_structure(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint8_t *out,
+                              size_t capacity, size_t *data_length) {
+    // Find corresponding descriptor
+    // 查找对应的命令描述符
+    const data_descriptor_t *descriptor = find_data_descriptor(cmd_set, cmd_id);
+    if (descriptor == NULL) {
+        ESP_LOGE(TAG, "Descriptor not found for CmdSet: 0x%02X, CmdID: 0x%02X", cmd_set, cmd_id);
+        return -1;
+    }
+
+    // Check if encoder function exists
+    // 检查编码函数是否存在
+    if (descriptor->encoder == NULL) {
+        ESP_LOGE(TAG, "Encoder function is NULL for CmdSet: 0x%02X, CmdID: 0x%02X", cmd_set, cmd_id);
+        return -1;
+    }
+
+    return descriptor->encoder(structure, out, capacity, data_length, cmd_type);
+}
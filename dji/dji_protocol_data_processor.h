@@ -33,9 +33,15 @@ const data_descriptor_t *find_data_descriptor(uint8_t cmd_set, uint8_t cmd_id);
 int data_parser_by_structure(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const uint8_t *data, size_t data_length,
                              void *output);
 
+int data_parser_by_descriptor(const data_descriptor_t *descriptor, uint8_t cmd_type, const uint8_t *data,
+                              size_t data_length, void *structure_out);
+
 uint8_t *data_creator_by_structure(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure,
                                    size_t *data_length);
 
+int data_encoder_by_structure(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint8_t *out,
+                              size_t capacity, size_t *data_length);
+
 #ifdef __cplusplus
 }
 #endif
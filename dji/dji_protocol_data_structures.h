@@ -24,9 +24,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
-#define ESP_LOGE(tag, format, ...) fprintf(stderr, "[ERROR][%s] " format "\n", tag, ##__VA_ARGS__)
-#define ESP_LOGW(tag, format, ...) fprintf(stderr, "[WARN][%s] " format "\n", tag, ##__VA_ARGS__)
-#define ESP_LOGI(tag, format, ...) fprintf(stdout, "[INFO][%s] " format "\n", tag, ##__VA_ARGS__)
+#include "dji_log.h"
 
 #ifdef _MSC_VER
 #define PACKED_BEGIN __pragma(pack(push, 1))
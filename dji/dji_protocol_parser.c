@@ -20,9 +20,9 @@
 #include "custom_crc16.h"
 #include "custom_crc32.h"
 
-#include <stdio.h>
 #include <string.h>
 
+#include "dji_allocator.h"
 #include "dji_protocol_data_processor.h"
 #include "dji_protocol_data_structures.h"
 #include "dji_protocol_parser.h"
@@ -30,59 +30,50 @@
 
 #define TAG "DJI_PROTOCOL_PARSER"
 
-/* Protocol frame field length definitions */
-/* 协议帧部分长度定义 */
-
-// SOF start byte
-// SOF 起始字节
-#define PROTOCOL_SOF_LENGTH 1
-// Ver/Length field
-// Ver/Length 字段
-#define PROTOCOL_VER_LEN_LENGTH 2
-// CmdType
-#define PROTOCOL_CMD_TYPE_LENGTH 1
-// ENC encryption field
-// ENC 加密字段
-#define PROTOCOL_ENC_LENGTH 1
-// RES reserved bytes
-// RES 保留字节
-#define PROTOCOL_RES_LENGTH 3
-// SEQ sequence number
-// SEQ 序列号
-#define PROTOCOL_SEQ_LENGTH 2
-// CRC-16 checksum
-// CRC-16 校验
-#define PROTOCOL_CRC16_LENGTH 2
-// CmdSet field
-// CmdSet 字段
-#define PROTOCOL_CMD_SET_LENGTH 1
-// CmdID field
-// CmdID 字段
-#define PROTOCOL_CMD_ID_LENGTH 1
-// CRC-32 checksum
-// CRC-32 校验
-#define PROTOCOL_CRC32_LENGTH 4
-
 /**
- * Define header length (excluding CmdSet, CmdID and payload)
- * 定义帧头长度（不包含 CmdSet、CmdID 和有效载荷）
+ * @brief Fill frame fields from an already verified frame
+ *        从已校验的帧中填充帧字段
+ *
+ * Does not check SOF, length or CRCs; callers verify them first
+ * 不检查 SOF、长度和 CRC，调用方需事先校验
+ *
+ * @param frame_data Raw frame data
+ *                   帧原始数据
+ * @param frame_length Frame length
+ *                     帧长度
+ * @param frame_out Output structure for parsed result
+ *                  解析结果输出结构体
  */
-#define PROTOCOL_HEADER_LENGTH                                                                                         \
-    (PROTOCOL_SOF_LENGTH + PROTOCOL_VER_LEN_LENGTH + PROTOCOL_CMD_TYPE_LENGTH + PROTOCOL_ENC_LENGTH +                  \
-     PROTOCOL_RES_LENGTH + PROTOCOL_SEQ_LENGTH + PROTOCOL_CRC16_LENGTH + PROTOCOL_CMD_SET_LENGTH +                     \
-     PROTOCOL_CMD_ID_LENGTH)
+void protocol_fill_frame(const uint8_t *frame_data, size_t frame_length, protocol_frame_t *frame_out) {
+    uint16_t ver_length = (frame_data[2] << 8) | frame_data[1];
 
-/**
- * Define tail length (only includes CRC-32)
- * 定义帧尾长度（仅包含 CRC-32）
- */
-#define PROTOCOL_TAIL_LENGTH PROTOCOL_CRC32_LENGTH
+    // Fill parsing results into structure
+    // 填充解析结果到结构体
+    frame_out->sof = frame_data[0];
+    frame_out->version = ver_length >> 10;
+    frame_out->frame_length = ver_length & 0x03FF;
+    frame_out->cmd_type = frame_data[3];
+    frame_out->enc = frame_data[4];
+    memcpy(frame_out->res, &frame_data[5], 3);
+    frame_out->seq = (frame_data[8] << 8) | frame_data[9];
+    frame_out->crc16 = (frame_data[11] << 8) | frame_data[10];
 
-/**
- * Define total frame length macro (dynamic calculation, including DATA segment)
- * 定义帧总长度宏（动态计算，包含 DATA 段）
- */
-#define PROTOCOL_FULL_FRAME_LENGTH(data_length) (PROTOCOL_HEADER_LENGTH + (data_length) + PROTOCOL_TAIL_LENGTH)
+    // Process data segment (DATA)
+    // 处理数据段 (DATA)
+    if (frame_length > 16) { // DATA segment exists
+                             // DATA 段存在
+        frame_out->data = &frame_data[12];
+        frame_out->data_length = frame_length - 16; // DATA length
+                                                    // DATA 长度
+    } else {                                        // DATA segment is empty
+                                                    // DATA 段为空
+        frame_out->data = NULL;
+        frame_out->data_length = 0;
+    }
+
+    const uint8_t *tail = &frame_data[frame_length - PROTOCOL_TAIL_LENGTH];
+    frame_out->crc32 = ((uint32_t)tail[3] << 24) | ((uint32_t)tail[2] << 16) | ((uint32_t)tail[1] << 8) | tail[0];
+}
 
 /**
  * Parse notification frame
@@ -119,10 +110,8 @@ int protocol_parse_notification(const uint8_t *frame_data, size_t frame_length,
     // Parse Ver/Length
     // 解析 Ver/Length
     uint16_t ver_length = (frame_data[2] << 8) | frame_data[1];
-    uint16_t version = ver_length >> 10;            // High 6 bits for version
-                                                    // 高 6 位为版本号
-    uint16_t expected_length = ver_length & 0x03FF; // Low 10 bits for frame length
-                                                    // 低 10 位为帧长度
+    uint16_t expected_length = ver_length & 0x03FF; // Low 10 bits for frame length, high 6 bits are version
+                                                    // 低 10 位为帧长度，高 6 位为版本号
 
     if (expected_length != frame_length) {
         ESP_LOGE(TAG, "Frame length mismatch: expected %u, got %zu", expected_length, frame_length);
@@ -151,33 +140,11 @@ int protocol_parse_notification(const uint8_t *frame_data, size_t frame_length,
         return -5;
     }
 
-    // Fill parsing results into structure
-    // 填充解析结果到结构体
-    frame_out->sof = frame_data[0];
-    frame_out->version = version;
-    frame_out->frame_length = expected_length;
-    frame_out->cmd_type = frame_data[3];
-    frame_out->enc = frame_data[4];
-    memcpy(frame_out->res, &frame_data[5], 3);
-    frame_out->seq = (frame_data[8] << 8) | frame_data[9];
-    frame_out->crc16 = crc16_received;
-
-    // Process data segment (DATA)
-    // 处理数据段 (DATA)
-    if (frame_length > 16) { // DATA segment exists
-                             // DATA 段存在
-        frame_out->data = &frame_data[12];
-        frame_out->data_length = frame_length - 16; // DATA length
-                                                    // DATA 长度
-    } else {                                        // DATA segment is empty
-                                                    // DATA 段为空
-        frame_out->data = NULL;
-        frame_out->data_length = 0;
+    protocol_fill_frame(frame_data, frame_length, frame_out);
+    if (frame_out->data_length == 0) {
         ESP_LOGW(TAG, "DATA segment is empty");
     }
 
-    frame_out->crc32 = crc32_received;
-
     ESP_LOGI(TAG, "Frame parsed successfully");
     return 0;
 }
@@ -198,8 +165,8 @@ int protocol_parse_notification(const uint8_t *frame_data, size_t frame_length,
  * @param data_length_without_cmd_out Output parameter for data length without cmdSet&CmdID
  *                                    不包含 cmdSet&CmdID 的数据长度输出参数
  *
- * @return void* Pointer to parsed result structure, NULL on failure
- *               指向解析结果结构体的指针，失败时返回 NULL
+ * @return void* Pointer to parsed result structure allocated with dji_malloc, release with dji_free, NULL on failure
+ *               指向通过 dji_malloc 分配的解析结果结构体的指针，需使用 dji_free 释放，失败时返回 NULL
  */
 void *protocol_parse_data(const uint8_t *data, size_t data_length, uint8_t cmd_type,
                           size_t *data_length_without_cmd_out) {
@@ -228,16 +195,15 @@ void *protocol_parse_data(const uint8_t *data, size_t data_length, uint8_t cmd_t
 
     ESP_LOGI(TAG, "CmdSet: 0x%02X, CmdID: 0x%02X", cmd_set, cmd_id);
 
-    void *response_struct = malloc(response_length);
+    void *response_struct = dji_malloc(response_length);
     if (response_struct == NULL) {
         ESP_LOGE(TAG, "Memory allocation failed for parsed data");
         return NULL;
     }
 
-    int result = -1;
-    if (descriptor != NULL) {
-        result = data_parser_by_structure(cmd_set, cmd_id, cmd_type, response_data, response_length, response_struct);
-    }
+    // Descriptor is already resolved, parse without a second lookup
+    // 描述符已查找到，直接解析，不再重复查找
+    int result = data_parser_by_descriptor(descriptor, cmd_type, response_data, response_length, response_struct);
 
     if (result == 0) {
         ESP_LOGI(TAG, "Data parsed successfully for CmdSet 0x%02X and CmdID 0x%02X", cmd_set, cmd_id);
@@ -246,13 +212,158 @@ void *protocol_parse_data(const uint8_t *data, size_t data_length, uint8_t cmd_t
         }
     } else {
         ESP_LOGE(TAG, "Failed to parse data for CmdSet 0x%02X and CmdID 0x%02X", cmd_set, cmd_id);
-        free(response_struct);
+        dji_free(response_struct);
         return NULL;
     }
 
     return response_struct;
 }
 
+/**
+ * @brief Write header, CmdSet/CmdID and both CRCs around a payload already placed at PROTOCOL_HEADER_LENGTH
+ *        在已放置于 PROTOCOL_HEADER_LENGTH 处的有效载荷周围写入帧头、CmdSet/CmdID 和两个 CRC
+ *
+ * The caller guarantees out holds PROTOCOL_FULL_FRAME_LENGTH(data_length) bytes and that data_length does not
+ * exceed PROTOCOL_MAX_DATA_LENGTH.
+ * 调用方需保证 out 至少有 PROTOCOL_FULL_FRAME_LENGTH(data_length) 字节，且 data_length 不超过
+ * PROTOCOL_MAX_DATA_LENGTH。
+ *
+ * @param out Frame buffer
+ *            帧缓冲区
+ * @param cmd_set Command set
+ *                命令集
+ * @param cmd_id Command ID
+ *               命令 ID
+ * @param cmd_type Command type
+ *                 命令类型
+ * @param seq Sequence number
+ *            序列号
+ * @param data_length Payload length
+ *                    有效载荷长度
+ *
+ * @return Total frame length
+ *         帧总长度
+ */
+size_t protocol_write_envelope(uint8_t *out, uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, uint16_t seq,
+                               size_t data_length) {
+    size_t frame_length = PROTOCOL_FULL_FRAME_LENGTH(data_length);
+
+    // Fill protocol header
+    // 填充协议头部
+    size_t offset = 0;
+    out[offset++] = 0xAA; // SOF start byte
+                          // SOF 起始字节
+
+    // Ver/Length field, version is fixed to 0
+    // Ver/Length 字段，版本号固定为 0
+    uint16_t ver_length = frame_length & 0x03FF;
+    out[offset++] = ver_length & 0xFF;
+    out[offset++] = (ver_length >> 8) & 0xFF;
+
+    out[offset++] = cmd_type;
+
+    // ENC (no encryption) and RES (reserved) are fixed to 0
+    // ENC（不加密）和 RES（保留字节）固定为 0
+    out[offset++] = 0x00;
+    out[offset++] = 0x00;
+    out[offset++] = 0x00;
+    out[offset++] = 0x00;
+
+    // Sequence number, high byte first
+    // 序列号，高字节在前
+    out[offset++] = (seq >> 8) & 0xFF;
+    out[offset++] = seq & 0xFF;
+
+    // Calculate and fill CRC-16 (covers from SOF to SEQ)
+    // 计算并填充 CRC-16（覆盖从 SOF 到 SEQ）
+    uint16_t crc16 = calculate_crc16(out, offset);
+    out[offset++] = crc16 & 0xFF;
+    out[offset++] = (crc16 >> 8) & 0xFF;
+
+    out[offset++] = cmd_set;
+    out[offset++] = cmd_id;
+    offset += data_length;
+
+    // Calculate and fill CRC-32 (covers from SOF to DATA)
+    // 计算并填充 CRC-32（覆盖从 SOF 到 DATA）
+    uint32_t crc32 = calculate_crc32(out, offset);
+    out[offset++] = crc32 & 0xFF;
+    out[offset++] = (crc32 >> 8) & 0xFF;
+    out[offset++] = (crc32 >> 16) & 0xFF;
+    out[offset++] = (crc32 >> 24) & 0xFF;
+
+    return frame_length;
+}
+
+/**
+ * @brief Encode protocol frame into caller-provided buffer
+ *        将协议帧编码到调用方提供的缓冲区
+ *
+ * Serializes header, payload and both CRCs in place without any heap allocation. A buffer of
+ * PROTOCOL_MAX_FRAME_LENGTH bytes fits every frame. A NULL structure, or a command registered without an
+ * encoder, produces a frame that carries only CmdSet and CmdID.
+ * 就地序列化帧头、有效载荷和两个 CRC，不进行任何堆分配。PROTOCOL_MAX_FRAME_LENGTH 字节的缓冲区可容纳任意帧。
+ * structure 为 NULL 或命令未注册编码函数时，生成仅包含 CmdSet 和 CmdID 的帧。
+ *
+ * @param out Output buffer
+ *            输出缓冲区
+ * @param capacity Size of output buffer
+ *                 输出缓冲区大小
+ * @param cmd_set Command set
+ *                命令集
+ * @param cmd_id Command ID
+ *               命令 ID
+ * @param cmd_type Command type
+ *                 命令类型
+ * @param structure Pointer to data structure, may be NULL
+ *                  数据结构指针，可为 NULL
+ * @param seq Sequence number
+ *            序列号
+ * @param frame_length_out Output parameter for total frame length
+ *                         总帧长度输出参数
+ *
+ * @return 0 on success, -1 if the payload cannot be encoded, -2 if the buffer is too small
+ *         成功返回 0，有效载荷无法编码返回 -1，缓冲区不足返回 -2
+ */
+int protocol_encode_frame_into(uint8_t *out, size_t capacity, uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type,
+                               const void *structure, uint16_t seq, size_t *frame_length_out) {
+    if (out == NULL || frame_length_out == NULL) {
+        ESP_LOGE(TAG, "Invalid input: out or frame_length_out is NULL");
+        return -1;
+    }
+
+    if (capacity > PROTOCOL_MAX_FRAME_LENGTH) {
+        capacity = PROTOCOL_MAX_FRAME_LENGTH;
+    }
+    if (capacity < PROTOCOL_FULL_FRAME_LENGTH(0)) {
+        ESP_LOGE(TAG, "Output buffer too small for an empty frame: %zu", capacity);
+        return -2;
+    }
+
+    // Encode payload straight into its final position, commands registered without an encoder carry no payload
+    // 将有效载荷直接编码到最终位置，未注册编码函数的命令不携带有效载荷
+    size_t data_length = 0;
+    if (structure != NULL) {
+        const data_descriptor_t *descriptor = find_data_descriptor(cmd_set, cmd_id);
+        if (descriptor == NULL) {
+            ESP_LOGE(TAG, "No descriptor found for CmdSet 0x%02X and CmdID 0x%02X", cmd_set, cmd_id);
+            return -1;
+        }
+
+        if (descriptor->encoder != NULL) {
+            int ret = descriptor->encoder(structure, &out[PROTOCOL_HEADER_LENGTH],
+                                          capacity - PROTOCOL_FULL_FRAME_LENGTH(0), &data_length, cmd_type);
+            if (ret != 0) {
+                ESP_LOGE(TAG, "Failed to encode payload for CmdSet 0x%02X and CmdID 0x%02X", cmd_set, cmd_id);
+                return ret;
+            }
+        }
+    }
+
+    *frame_length_out = protocol_write_envelope(out, cmd_set, cmd_id, cmd_type, seq, data_length);
+    return 0;
+}
+
 /**
  * @brief Create protocol frame
  *        创建协议帧
@@ -260,6 +371,10 @@ void *protocol_parse_data(const uint8_t *data, size_t data_length, uint8_t cmd_t
  * Creates a complete protocol frame with given parameters and data structure
  * 根据给定的参数和数据结构创建完整的协议帧
  *
+ * Prefer protocol_encode_frame_into on hot paths, this wrapper allocates the returned buffer which the caller
+ * must release with dji_free
+ * 热路径上优先使用 protocol_encode_frame_into，本函数会分配返回的缓冲区，调用方需使用 dji_free 释放
+ *
  * @param cmd_set Command set
  *                命令集
  * @param cmd_id Command ID
@@ -278,108 +393,73 @@ void *protocol_parse_data(const uint8_t *data, size_t data_length, uint8_t cmd_t
  */
 uint8_t *protocol_create_frame(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint16_t seq,
                                size_t *frame_length_out) {
-    size_t data_length = 0;
-    uint8_t *payload_data = NULL;
+    uint8_t buffer[PROTOCOL_MAX_FRAME_LENGTH];
 
-    // Create payload data from structure
-    // 从结构体创建有效载荷数据
-    payload_data = data_creator_by_structure(cmd_set, cmd_id, cmd_type, structure, &data_length);
-
-    // Handle empty payload case
-    // 处理空数据段的情况
-    if (payload_data == NULL && data_length > 0) {
-        ESP_LOGE(TAG, "Failed to create payload data with non-zero length");
+    if (protocol_encode_frame_into(buffer, sizeof(buffer), cmd_set, cmd_id, cmd_type, structure, seq,
+                                   frame_length_out) != 0) {
         return NULL;
     }
+    ESP_LOGI(TAG, "Frame Length: %zu", *frame_length_out);
 
-    // Calculate total frame length
-    // 计算总帧长度
-    *frame_length_out = PROTOCOL_HEADER_LENGTH + data_length + PROTOCOL_TAIL_LENGTH;
-    printf("Frame Length: %zu\n", *frame_length_out);
-
-    // Allocate memory for complete frame
-    // 为完整帧分配内存
-    uint8_t *frame = (uint8_t *)malloc(*frame_length_out);
+    uint8_t *frame = (uint8_t *)dji_malloc(*frame_length_out);
     if (frame == NULL) {
         ESP_LOGE(TAG, "Memory allocation failed for protocol frame");
-        free(payload_data);
         return NULL;
     }
+    memcpy(frame, buffer, *frame_length_out);
 
-    // Initialize frame content
-    // 初始化帧内容
-    memset(frame, 0, *frame_length_out);
-
-    // Fill protocol header
-    // 填充协议头部
-    size_t offset = 0;
-    frame[offset++] = 0xAA; // SOF start byte
-                            // SOF 起始字节
-
-    // Ver/Length field
-    // Ver/Length 字段
-    uint16_t version = 0; // Fixed version number
-                          // 固定版本号
-    uint16_t ver_length = (version << 10) | (*frame_length_out & 0x03FF);
-    frame[offset++] = ver_length & 0xFF;        // Ver/Length low byte
-                                                // Ver/Length 低字节
-    frame[offset++] = (ver_length >> 8) & 0xFF; // Ver/Length high byte
-                                                // Ver/Length 高字节
-
-    // Fill command type
-    // 填充命令类型
-    frame[offset++] = cmd_type;
-
-    // ENC (no encryption, fixed 0)
-    // ENC（不加密，固定 0）
-    frame[offset++] = 0x00;
-
-    // RES (reserved bytes, fixed 0)
-    // RES（保留字节，固定 0）
-    frame[offset++] = 0x00;
-    frame[offset++] = 0x00;
-    frame[offset++] = 0x00;
-
-    // Sequence number
-    // 序列号
-    frame[offset++] = (seq >> 8) & 0xFF; // High byte of sequence number
-                                         // 序列号高字节
-    frame[offset++] = seq & 0xFF;        // Low byte of sequence number
-                                         // 序列号低字节
+    return frame;
+}
 
-    // Calculate and fill CRC-16 (covers from SOF to SEQ)
-    // 计算并填充 CRC-16（覆盖从 SOF 到 SEQ）
-    uint16_t crc16 = calculate_crc16(frame, offset);
-    frame[offset++] = crc16 & 0xFF;        // CRC-16 low byte
-                                           // CRC-16 低字节
-    frame[offset++] = (crc16 >> 8) & 0xFF; // CRC-16 high byte
-                                           // CRC-16 高字节
-
-    // Fill command set and ID
-    // 填充命令集和命令 ID
-    frame[offset++] = cmd_set;
-    frame[offset++] = cmd_id;
-
-    // Fill payload data
-    // 填充有效载荷数据
-    memcpy(&frame[offset], payload_data, data_length);
-    offset += data_length;
+/**
+ * @brief Rewrite the sequence number of an encoded frame
+ *        改写已编码帧的序列号
+ *
+ * Patches SEQ, CRC-16 and CRC-32 in place using CRC linearity, without reading the payload. The CRC-32 shift past
+ * the payload is one table lookup and one multiply, so the cost does not depend on the payload length and one encoded
+ * command can be stamped out for many devices or retries.
+ * 利用 CRC 的线性性质就地修改 SEQ、CRC-16 和 CRC-32，无需读取有效载荷。CRC-32 越过有效载荷的移位只需一次查表和
+ * 一次乘法，因此开销与有效载荷长度无关，同一条已编码命令可以复用于多个设备或重发。
+ *
+ * @param frame Encoded frame, modified in place
+ *              已编码帧，就地修改
+ * @param frame_length Frame length
+ *                     帧长度
+ * @param seq New sequence number
+ *            新序列号
+ *
+ * @return 0 on success, -1 if the buffer is not a frame of the given length
+ *         成功返回 0，缓冲区不是给定长度的帧时返回 -1
+ */
+int protocol_frame_set_seq(uint8_t *frame, size_t frame_length, uint16_t seq) {
+    if (frame == NULL || frame_length < PROTOCOL_MIN_FRAME_LENGTH || frame_length > PROTOCOL_MAX_FRAME_LENGTH ||
+        frame[0] != 0xAA || (((frame[2] << 8) | frame[1]) & 0x03FF) != frame_length) {
+        ESP_LOGE(TAG, "protocol_frame_set_seq: not a valid %zu byte frame", frame_length);
+        return -1;
+    }
 
-    // Calculate and fill CRC-32 (covers from SOF to DATA)
-    // 计算并填充 CRC-32（覆盖从 SOF 到 DATA）
-    uint32_t crc32 = calculate_crc32(frame, offset);
-    frame[offset++] = crc32 & 0xFF;         // CRC-32 byte 1
-                                            // CRC-32 第 1 字节
-    frame[offset++] = (crc32 >> 8) & 0xFF;  // CRC-32 byte 2
-                                            // CRC-32 第 2 字节
-    frame[offset++] = (crc32 >> 16) & 0xFF; // CRC-32 byte 3
-                                            // CRC-32 第 3 字节
-    frame[offset++] = (crc32 >> 24) & 0xFF; // CRC-32 byte 4
-                                            // CRC-32 第 4 字节
-
-    // Free payload data
-    // 释放有效载荷数据
-    free(payload_data);
+    // SEQ and CRC-16 are adjacent, both change and both are covered by CRC-32
+    // SEQ 与 CRC-16 相邻，二者都会改变且都在 CRC-32 覆盖范围内
+    const size_t seq_offset = PROTOCOL_CRC16_COVERED_LENGTH - PROTOCOL_SEQ_LENGTH;
+    uint8_t old_bytes[PROTOCOL_SEQ_LENGTH + PROTOCOL_CRC16_LENGTH];
+    memcpy(old_bytes, &frame[seq_offset], sizeof(old_bytes));
+
+    frame[seq_offset] = (seq >> 8) & 0xFF;
+    frame[seq_offset + 1] = seq & 0xFF;
+
+    uint16_t crc16 = (old_bytes[3] << 8) | old_bytes[2];
+    crc16 = (uint16_t)crc16_patch(crc16, old_bytes, &frame[seq_offset], PROTOCOL_SEQ_LENGTH, 0);
+    frame[seq_offset + 2] = crc16 & 0xFF;
+    frame[seq_offset + 3] = (crc16 >> 8) & 0xFF;
+
+    uint8_t *tail = &frame[frame_length - PROTOCOL_TAIL_LENGTH];
+    uint32_t crc32 = ((uint32_t)tail[3] << 24) | ((uint32_t)tail[2] << 16) | ((uint32_t)tail[1] << 8) | tail[0];
+    size_t covered_after = frame_length - PROTOCOL_TAIL_LENGTH - PROTOCOL_CRC16_COVERED_LENGTH - PROTOCOL_CRC16_LENGTH;
+    crc32 = (uint32_t)crc32_patch(crc32, old_bytes, &frame[seq_offset], sizeof(old_bytes), covered_after);
+    tail[0] = crc32 & 0xFF;
+    tail[1] = (crc32 >> 8) & 0xFF;
+    tail[2] = (crc32 >> 16) & 0xFF;
+    tail[3] = (crc32 >> 24) & 0xFF;
 
-    return frame;
+    return 0;
 }
@@ -22,6 +22,87 @@
 #include <stddef.h>
 #include <stdint.h>
 
+/* Protocol frame field length definitions */
+/* 协议帧部分长度定义 */
+
+// SOF start byte
+// SOF 起始字节
+#define PROTOCOL_SOF_LENGTH 1
+// Ver/Length field
+// Ver/Length 字段
+#define PROTOCOL_VER_LEN_LENGTH 2
+// CmdType
+#define PROTOCOL_CMD_TYPE_LENGTH 1
+// ENC encryption field
+// ENC 加密字段
+#define PROTOCOL_ENC_LENGTH 1
+// RES reserved bytes
+// RES 保留字节
+#define PROTOCOL_RES_LENGTH 3
+// SEQ sequence number
+// SEQ 序列号
+#define PROTOCOL_SEQ_LENGTH 2
+// CRC-16 checksum
+// CRC-16 校验
+#define PROTOCOL_CRC16_LENGTH 2
+// CmdSet field
+// CmdSet 字段
+#define PROTOCOL_CMD_SET_LENGTH 1
+// CmdID field
+// CmdID 字段
+#define PROTOCOL_CMD_ID_LENGTH 1
+// CRC-32 checksum
+// CRC-32 校验
+#define PROTOCOL_CRC32_LENGTH 4
+
+/**
+ * Define header length (excluding CmdSet, CmdID and payload)
+ * 定义帧头长度（不包含 CmdSet、CmdID 和有效载荷）
+ */
+#define PROTOCOL_HEADER_LENGTH                                                                                         \
+    (PROTOCOL_SOF_LENGTH + PROTOCOL_VER_LEN_LENGTH + PROTOCOL_CMD_TYPE_LENGTH + PROTOCOL_ENC_LENGTH +                  \
+     PROTOCOL_RES_LENGTH + PROTOCOL_SEQ_LENGTH + PROTOCOL_CRC16_LENGTH + PROTOCOL_CMD_SET_LENGTH +                     \
+     PROTOCOL_CMD_ID_LENGTH)
+
+/**
+ * Define tail length (only includes CRC-32)
+ * 定义帧尾长度（仅包含 CRC-32）
+ */
+#define PROTOCOL_TAIL_LENGTH PROTOCOL_CRC32_LENGTH
+
+/**
+ * Define total frame length macro (dynamic calculation, including DATA segment)
+ * 定义帧总长度宏（动态计算，包含 DATA 段）
+ */
+#define PROTOCOL_FULL_FRAME_LENGTH(data_length) (PROTOCOL_HEADER_LENGTH + (data_length) + PROTOCOL_TAIL_LENGTH)
+
+/**
+ * Largest frame the 10-bit length field can describe
+ * 10 位长度字段能表示的最大帧长度
+ */
+#define PROTOCOL_MAX_FRAME_LENGTH 0x03FF
+
+/**
+ * Largest payload following CmdSet and CmdID
+ * CmdSet 和 CmdID 之后的最大有效载荷长度
+ */
+#define PROTOCOL_MAX_DATA_LENGTH (PROTOCOL_MAX_FRAME_LENGTH - PROTOCOL_FULL_FRAME_LENGTH(0))
+
+/**
+ * Smallest valid frame (header and tail without CmdSet, CmdID and DATA)
+ * 最小有效帧长度（不含 CmdSet、CmdID 和 DATA 的帧头与帧尾）
+ */
+#define PROTOCOL_MIN_FRAME_LENGTH                                                                                      \
+    (PROTOCOL_HEADER_LENGTH - PROTOCOL_CMD_SET_LENGTH - PROTOCOL_CMD_ID_LENGTH + PROTOCOL_TAIL_LENGTH)
+
+/**
+ * Bytes covered by CRC-16 (SOF to SEQ) and offset of the CRC-16 field
+ * CRC-16 覆盖的字节数（SOF 到 SEQ），同时也是 CRC-16 字段的偏移
+ */
+#define PROTOCOL_CRC16_COVERED_LENGTH                                                                                  \
+    (PROTOCOL_SOF_LENGTH + PROTOCOL_VER_LEN_LENGTH + PROTOCOL_CMD_TYPE_LENGTH + PROTOCOL_ENC_LENGTH +                  \
+     PROTOCOL_RES_LENGTH + PROTOCOL_SEQ_LENGTH)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -55,14 +136,24 @@ typedef struct {
                            // CRC-32 校验值
 } protocol_frame_t;
 
+void protocol_fill_frame(const uint8_t *frame_data, size_t frame_length, protocol_frame_t *frame_out);
+
 int protocol_parse_notification(const uint8_t *frame_data, size_t frame_length, protocol_frame_t *frame_out);
 
 void *protocol_parse_data(const uint8_t *data, size_t data_length, uint8_t cmd_type,
                           size_t *data_length_without_cmd_out);
 
+size_t protocol_write_envelope(uint8_t *out, uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, uint16_t seq,
+                               size_t data_length);
+
+int protocol_encode_frame_into(uint8_t *out, size_t capacity, uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type,
+                               const void *structure, uint16_t seq, size_t *frame_length_out);
+
 uint8_t *protocol_create_frame(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint16_t seq,
                                size_t *frame_length_out);
 
+int protocol_frame_set_seq(uint8_t *frame, size_t frame_length, uint16_t seq);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+#include "custom_crc16.h"
+#include "custom_crc32.h"
+
+#include <string.h>
+
+#include "dji_protocol_data_structures.h"
+#include "dji_protocol_stream.h"
+
+#define TAG "DJI_PROTOCOL_STREAM"
+
+#define STREAM_MASK (PROTOCOL_STREAM_BUFFER_SIZE - 1)
+
+#if (PROTOCOL_STREAM_BUFFER_SIZE & STREAM_MASK) != 0 || PROTOCOL_STREAM_BUFFER_SIZE < 2 * PROTOCOL_MAX_FRAME_LENGTH
+#error "PROTOCOL_STREAM_BUFFER_SIZE must be a power of two holding two maximum frames"
+#endif
+
+/**
+ * Copy length bytes starting offset bytes after head out of the ring
+ * 从 head 之后 offset 字节处拷贝 length 字节
+ */
+static void stream_peek(const protocol_stream_t *stream, size_t offset, uint8_t *out, size_t length) {
+    size_t start = (stream->head + offset) & STREAM_MASK;
+    size_t first = PROTOCOL_STREAM_BUFFER_SIZE - start;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(out, &stream->buffer[start], first);
+    memcpy(out + first, stream->buffer, length - first);
+}
+
+/**
+ * Drop bytes from the head of the ring and count them as discarded
+ * 从环形缓冲区头部丢弃字节并计入丢弃计数
+ */
+static void stream_discard(protocol_stream_t *stream, size_t count) {
+    stream->head += count;
+    stream->stats.bytes_discarded += count;
+}
+
+/**
+ * Discard bytes until the head points at a SOF, returns 0 if the ring ran empty
+ * 丢弃字节直到 head 指向 SOF，缓冲区被清空时返回 0
+ */
+static int stream_seek_sof(protocol_stream_t *stream) {
+    while (stream->tail != stream->head) {
+        size_t start = stream->head & STREAM_MASK;
+        size_t available = stream->tail - stream->head;
+        size_t contiguous = PROTOCOL_STREAM_BUFFER_SIZE - start;
+        if (contiguous > available) {
+            contiguous = available;
+        }
+
+        const uint8_t *sof = (const uint8_t *)memchr(&stream->buffer[start], 0xAA, contiguous);
+        if (sof != NULL) {
+            stream_discard(stream, (size_t)(sof - &stream->buffer[start]));
+            return 1;
+        }
+        stream_discard(stream, contiguous);
+    }
+    return 0;
+}
+
+/**
+ * @brief Initialize stream decoder
+ *        初始化流式解码器
+ *
+ * @param stream Stream decoder
+ *               流式解码器
+ */
+void protocol_stream_init(protocol_stream_t *stream) {
+    memset(stream, 0, sizeof(*stream));
+}
+
+/**
+ * @brief Drop all buffered bytes, counters are kept
+ *        丢弃所有缓存字节，保留计数
+ *
+ * @param stream Stream decoder
+ *               流式解码器
+ */
+void protocol_stream_reset(protocol_stream_t *stream) {
+    stream_discard(stream, stream->tail - stream->head);
+}
+
+/**
+ * @brief Append received bytes to the stream
+ *        向流中追加接收到的字节
+ *
+ * Accepts as many bytes as fit in the ring; drain frames with protocol_stream_next before writing the rest
+ * 仅接收环形缓冲区能容纳的字节，剩余部分需先用 protocol_stream_next 取出帧后再写入
+ *
+ * @param stream Stream decoder
+ *               流式解码器
+ * @param data Received bytes
+ *             接收到的字节
+ * @param length Number of received bytes
+ *               接收到的字节数
+ *
+ * @return size_t Number of bytes accepted
+ *                实际接收的字节数
+ */
+size_t protocol_stream_write(protocol_stream_t *stream, const uint8_t *data, size_t length) {
+    size_t space = PROTOCOL_STREAM_BUFFER_SIZE - (stream->tail - stream->head);
+    if (length > space) {
+        length = space;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    size_t start = stream->tail & STREAM_MASK;
+    size_t first = PROTOCOL_STREAM_BUFFER_SIZE - start;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&stream->buffer[start], data, first);
+    memcpy(stream->buffer, data + first, length - first);
+
+    stream->tail += length;
+    stream->stats.bytes_received += length;
+    return length;
+}
+
+/**
+ * @brief Decode the next complete frame from the stream
+ *        从流中解出下一个完整帧
+ *
+ * Searches for SOF, checks CRC-16 as soon as the header is buffered, waits for the declared length and then
+ * checks CRC-32. On any failure only the SOF byte is dropped so that a frame starting inside the rejected bytes
+ * is still found. frame_out->data and *frame_bytes_out stay valid until the next call on this stream.
+ * 搜索 SOF，帧头到齐后立即校验 CRC-16，等待声明的长度到齐后再校验 CRC-32。
+ * 任一校验失败时只丢弃 SOF 字节，以便找回起始于被拒字节内部的帧。
+ * frame_out->data 与 *frame_bytes_out 在下一次调用本流的接口前有效。
+ *
+ * @param stream Stream decoder
+ *               流式解码器
+ * @param frame_out Output structure for parsed result
+ *                  解析结果输出结构体
+ * @param frame_bytes_out Optional output for the raw frame bytes
+ *                        可选的原始帧字节输出
+ *
+ * @return 1 when a frame was decoded, 0 when more data is needed
+ *         解出一帧返回 1，需要更多数据返回 0
+ */
+int protocol_stream_next(protocol_stream_t *stream, protocol_frame_t *frame_out, const uint8_t **frame_bytes_out) {
+    uint8_t header[PROTOCOL_CRC16_COVERED_LENGTH + PROTOCOL_CRC16_LENGTH];
+
+    while (stream_seek_sof(stream)) {
+        size_t available = stream->tail - stream->head;
+        if (available < sizeof(header)) {
+            return 0;
+        }
+
+        // Verify CRC-16 before trusting the length field
+        // 先校验 CRC-16 再信任长度字段
+        stream_peek(stream, 0, header, sizeof(header));
+        uint16_t crc16_received = (header[11] << 8) | header[10];
+        if (crc16_received != calculate_crc16(header, PROTOCOL_CRC16_COVERED_LENGTH)) {
+            stream->stats.crc16_errors++;
+            stream_discard(stream, PROTOCOL_SOF_LENGTH);
+            continue;
+        }
+
+        size_t frame_length = ((header[2] << 8) | header[1]) & 0x03FF;
+        if (frame_length < PROTOCOL_MIN_FRAME_LENGTH) {
+            ESP_LOGW(TAG, "Frame length %zu below minimum, resyncing", frame_length);
+            stream->stats.length_errors++;
+            stream_discard(stream, PROTOCOL_SOF_LENGTH);
+            continue;
+        }
+        if (available < frame_length) {
+            return 0;
+        }
+
+        // Frames wrapping around the end of the ring are linearized into scratch
+        // 跨越环形缓冲区末尾的帧线性拷贝到 scratch
+        size_t start = stream->head & STREAM_MASK;
+        const uint8_t *frame_data = &stream->buffer[start];
+        if (start + frame_length > PROTOCOL_STREAM_BUFFER_SIZE) {
+            stream_peek(stream, 0, stream->scratch, frame_length);
+            frame_data = stream->scratch;
+        }
+
+        const uint8_t *tail = &frame_data[frame_length - PROTOCOL_TAIL_LENGTH];
+        uint32_t crc32_received =
+            ((uint32_t)tail[3] << 24) | ((uint32_t)tail[2] << 16) | ((uint32_t)tail[1] << 8) | tail[0];
+        if (crc32_received != calculate_crc32(frame_data, frame_length - PROTOCOL_TAIL_LENGTH)) {
+            ESP_LOGW(TAG, "CRC-32 mismatch on %zu byte frame, resyncing", frame_length);
+            stream->stats.crc32_errors++;
+            stream_discard(stream, PROTOCOL_SOF_LENGTH);
+            continue;
+        }
+
+        protocol_fill_frame(frame_data, frame_length, frame_out);
+        if (frame_bytes_out != NULL) {
+            *frame_bytes_out = frame_data;
+        }
+        stream->head += frame_length;
+        stream->stats.frames_decoded++;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Feed an arbitrary chunk and emit every frame it completes
+ *        输入任意长度的数据块，并输出其补全的所有帧
+ *
+ * @param stream Stream decoder
+ *               流式解码器
+ * @param data Received bytes
+ *             接收到的字节
+ * @param length Number of received bytes
+ *               接收到的字节数
+ * @param callback Called once per decoded frame, frame pointers are only valid during the call
+ *                 每解出一帧调用一次，帧指针仅在回调期间有效
+ * @param user_data Passed through to callback
+ *                  透传给回调
+ *
+ * @return size_t Number of frames emitted
+ *                输出的帧数
+ */
+size_t protocol_stream_push(protocol_stream_t *stream, const uint8_t *data, size_t length,
+                            protocol_stream_frame_cb_t callback, void *user_data) {
+    size_t frames = 0;
+    size_t offset = 0;
+    protocol_frame_t frame;
+    const uint8_t *frame_bytes = NULL;
+
+    // The ring holds two maximum frames, so each pass either frees space or consumes the input
+    // 环形缓冲区可容纳两个最大帧，因此每轮要么腾出空间，要么耗尽输入
+    do {
+        offset += protocol_stream_write(stream, data + offset, length - offset);
+        while (protocol_stream_next(stream, &frame, &frame_bytes) == 1) {
+            frames++;
+            if (callback != NULL) {
+                callback(&frame, frame_bytes, user_data);
+            }
+        }
+    } while (offset < length);
+
+    return frames;
+}
@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (C) 2025 SZ DJI Technology Co., Ltd.
+ *
+ * All information contained herein is, and remains, the property of DJI.
+ * The intellectual and technical concepts contained herein are proprietary
+ * to DJI and may be covered by U.S. and foreign patents, patents in process,
+ * and protected by trade secret or copyright law.  Dissemination of this
+ * information, including but not limited to data and other proprietary
+ * material(s) incorporated within the information, in any form, is strictly
+ * prohibited without the express written consent of DJI.
+ *
+ * If you receive this source code without DJI’s authorization, you may not
+ * further disseminate the information, and you must immediately remove the
+ * source code and notify DJI of its removal. DJI reserves the right to pursue
+ * legal actions against you for any loss(es) or damage(s) caused by your
+ * failure to do so.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "dji_protocol_parser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Ring buffer size, must be a power of two and hold at least two maximum frames
+ * 环形缓冲区大小，必须为 2 的幂且至少容纳两个最大帧
+ */
+#define PROTOCOL_STREAM_BUFFER_SIZE 2048
+
+/**
+ * @brief Stream decoder counters
+ *        流式解码器计数
+ */
+typedef struct {
+    uint64_t bytes_received;  // Bytes accepted by protocol_stream_write
+                              // protocol_stream_write 接收的字节数
+    uint64_t bytes_discarded; // Bytes dropped while searching for a valid frame
+                              // 搜索有效帧时丢弃的字节数
+    uint64_t frames_decoded;  // Frames that passed both CRC checks
+                              // 通过两次 CRC 校验的帧数
+    uint64_t length_errors;   // Headers with a length field below the minimum frame
+                              // 长度字段小于最小帧长度的帧头数
+    uint64_t crc16_errors;    // Headers rejected by CRC-16
+                              // CRC-16 校验失败的帧头数
+    uint64_t crc32_errors;    // Frames rejected by CRC-32
+                              // CRC-32 校验失败的帧数
+} protocol_stream_stats_t;
+
+/**
+ * @brief Incremental frame decoder for fragmented or coalesced notifications
+ *        用于分片或合并通知的增量帧解码器
+ */
+typedef struct {
+    uint8_t buffer[PROTOCOL_STREAM_BUFFER_SIZE]; // Received bytes ring
+                                                 // 接收字节环形缓冲区
+    size_t head;                                 // Read position (free running)
+                                                 // 读位置（自由递增）
+    size_t tail;                                 // Write position (free running)
+                                                 // 写位置（自由递增）
+    uint8_t scratch[PROTOCOL_MAX_FRAME_LENGTH];  // Linear copy of frames that wrap around the ring
+                                                 // 跨越环形缓冲区边界的帧的线性副本
+    protocol_stream_stats_t stats;               // Decoder counters
+                                                 // 解码器计数
+} protocol_stream_t;
+
+/**
+ * Callback invoked for every frame decoded by protocol_stream_push
+ * protocol_stream_push 每解出一帧调用一次的回调
+ */
+typedef void (*protocol_stream_frame_cb_t)(const protocol_frame_t *frame, const uint8_t *frame_bytes,
+                                           void *user_data);
+
+void protocol_stream_init(protocol_stream_t *stream);
+
+void protocol_stream_reset(protocol_stream_t *stream);
+
+size_t protocol_stream_write(protocol_stream_t *stream, const uint8_t *data, size_t length);
+
+int protocol_stream_next(protocol_stream_t *stream, protocol_frame_t *frame_out, const uint8_t **frame_bytes_out);
+
+size_t protocol_stream_push(protocol_stream_t *stream, const uint8_t *data, size_t length,
+                            protocol_stream_frame_cb_t callback, void *user_data);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,347 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Single-threaded executor for coroutines and callbacks
+ *        协程与回调的单线程执行器
+ *
+ * post() may be called from any thread; everything posted runs on the thread inside run(). Completions from the
+ * BLE reader thread are posted here, so one loop thread can drive handshakes and command sequences for many
+ * devices without blocking on a queue per device.
+ * post() 可在任意线程调用，投递的任务都在执行 run() 的线程上运行。BLE 读取线程的完成通知会投递到这里，
+ * 因此一个事件循环线程即可同时驱动多台设备的握手与命令序列，而无需为每台设备阻塞等待队列。
+ */
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void post(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        cv_.notify_one();
+    }
+
+    void post(std::coroutine_handle<> handle) {
+        post([handle] { handle.resume(); });
+    }
+
+    // 在 deadline 之后执行 task
+    void post_at(Clock::time_point deadline, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timers_.push(Timer{deadline, next_timer_id_++, std::move(task)});
+        }
+        cv_.notify_one();
+    }
+
+    // 运行直到 stop() 被调用
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopped_) {
+            if (!timers_.empty() && timers_.top().deadline <= Clock::now()) {
+                std::function<void()> task = std::move(const_cast<Timer &>(timers_.top()).task);
+                timers_.pop();
+                lock.unlock();
+                task();
+                lock.lock();
+                continue;
+            }
+            if (!tasks_.empty()) {
+                std::function<void()> task = std::move(tasks_.front());
+                tasks_.pop_front();
+                lock.unlock();
+                task();
+                lock.lock();
+                continue;
+            }
+            if (timers_.empty()) {
+                cv_.wait(lock);
+            } else {
+                cv_.wait_until(lock, timers_.top().deadline);
+            }
+        }
+        stopped_ = false;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cv_.notify_one();
+    }
+
+    // co_await loop.schedule() 将当前协程切换到事件循环线程
+    auto schedule() {
+        struct Awaiter {
+            EventLoop &loop;
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { loop.post(handle); }
+            void await_resume() const {}
+        };
+        return Awaiter{*this};
+    }
+
+    // co_await loop.sleep_for(d) 在事件循环上等待，不占用线程
+    auto sleep_for(Clock::duration duration) {
+        struct Awaiter {
+            EventLoop &loop;
+            Clock::time_point deadline;
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                loop.post_at(deadline, [handle] { handle.resume(); });
+            }
+            void await_resume() const {}
+        };
+        return Awaiter{*this, Clock::now() + duration};
+    }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t id;
+        std::function<void()> task;
+
+        // 截止时间相同时按投递顺序执行
+        bool operator>(const Timer &other) const {
+            return deadline != other.deadline ? deadline > other.deadline : id > other.id;
+        }
+    };
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t next_timer_id_ = 0;
+    bool stopped_ = false;
+};
+
+/**
+ * @brief Lazily started coroutine returning T, resumes its awaiter when done
+ *        惰性启动、返回 T 的协程，完成后恢复等待它的协程
+ */
+template <typename T = void> class Task;
+
+namespace task_detail {
+
+// 协程结束时直接切换到等待它的协程（对称转移），避免递归恢复导致栈增长
+struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    template <typename P> std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept {
+        return handle.promise().continuation;
+    }
+    void await_resume() noexcept {}
+};
+
+struct PromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr exception;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+template <typename T> struct Promise : PromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object();
+    void return_value(T result) { value.emplace(std::move(result)); }
+    T result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+template <> struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void result() {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace task_detail
+
+template <typename T> class Task {
+public:
+    using promise_type = task_detail::Promise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task &&other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace task_detail {
+
+template <typename T> Task<T> Promise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+// 自行销毁的顶层协程，用于 spawn 和 sync_wait
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+} // namespace task_detail
+
+/**
+ * @brief Start task on loop without waiting for it, the coroutine frame frees itself when done
+ *        在事件循环上启动 task 且不等待其结果，协程帧完成后自行释放
+ */
+inline void spawn(EventLoop &loop, Task<void> task) {
+    [](EventLoop &loop, Task<void> task) -> task_detail::Detached {
+        co_await loop.schedule();
+        co_await std::move(task);
+    }(loop, std::move(task));
+}
+
+/**
+ * @brief Run task from a plain thread and block until it finishes
+ *        在普通线程中运行 task 并阻塞等待其完成
+ *
+ * The task starts on the calling thread and continues wherever its awaits resume it; it must not need the
+ * calling thread to make progress.
+ * task 在调用线程上开始执行，之后在各个 await 恢复它的线程上继续运行；它不能依赖调用线程才能继续推进。
+ */
+template <typename T> T sync_wait(Task<T> task) {
+    std::promise<T> promise;
+    std::future<T> future = promise.get_future();
+    [](Task<T> task, std::promise<T> &promise) -> task_detail::Detached {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(task);
+                promise.set_value();
+            } else {
+                promise.set_value(co_await std::move(task));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    }(std::move(task), promise);
+    return future.get();
+}
+
+/**
+ * @brief One-shot value completed from any thread and awaited by one coroutine
+ *        可在任意线程完成、由一个协程等待的一次性结果
+ *
+ * The result is buffered, so the operation can be armed before the coroutine reaches co_await without losing
+ * a completion that arrives in between. With a loop the waiting coroutine is resumed on the loop thread,
+ * otherwise on the completing thread.
+ * 结果会被缓存，因此可以在协程执行 co_await 之前发起操作，期间到达的完成通知不会丢失。
+ * 指定事件循环时等待的协程在事件循环线程上恢复，否则在完成通知所在的线程上恢复。
+ */
+template <typename T> class AsyncValue {
+public:
+    explicit AsyncValue(EventLoop *loop = nullptr) : state_(std::make_shared<State>()) { state_->loop = loop; }
+
+    // 返回用于完成结果的回调，可拷贝，只有第一次调用生效
+    std::function<void(T)> completer() const {
+        return [state = state_](T value) { state->complete(std::move(value)); };
+    }
+
+    bool await_ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->value.has_value();
+    }
+    bool await_suspend(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->value.has_value()) {
+            return false;
+        }
+        state_->waiter = handle;
+        return true;
+    }
+    T await_resume() {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return std::move(*state_->value);
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::optional<T> value;
+        std::coroutine_handle<> waiter;
+        EventLoop *loop = nullptr;
+
+        void complete(T result) {
+            std::coroutine_handle<> handle;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (value.has_value()) {
+                    return;
+                }
+                value.emplace(std::move(result));
+                handle = std::exchange(waiter, nullptr);
+            }
+            if (!handle) {
+                return;
+            }
+            if (loop != nullptr) {
+                loop->post(handle);
+            } else {
+                handle.resume();
+            }
+        }
+    };
+
+    std::shared_ptr<State> state_;
+};
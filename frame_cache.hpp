@@ -0,0 +1,166 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "dji/dji_protocol_data_processor.h"
+#include "dji/dji_protocol_parser.h"
+
+/**
+ * @brief Fully encoded frame whose SEQ can be rewritten per send
+ *        完整编码的帧模板，每次发送只改写 SEQ
+ *
+ * Send it with OsmoDevice::request_frame or send_frame_async, which stamp the SEQ on a copy.
+ * 通过 OsmoDevice::request_frame 或 send_frame_async 发送，二者在副本上改写 SEQ。
+ */
+class FrameTemplate {
+public:
+    FrameTemplate(const uint8_t *frame, size_t length) : length_(length) { std::memcpy(bytes_.data(), frame, length); }
+
+    // 拷贝模板并改写 SEQ 与两个校验值，返回帧长度，缓冲区不足时返回 0
+    size_t stamp(uint16_t seq, uint8_t *out, size_t capacity) const {
+        if (capacity < length_) {
+            return 0;
+        }
+        std::memcpy(out, bytes_.data(), length_);
+        protocol_frame_set_seq(out, length_, seq);
+        return length_;
+    }
+
+    const uint8_t *data() const { return bytes_.data(); }
+    const uint8_t *payload() const { return bytes_.data() + PROTOCOL_HEADER_LENGTH; }
+    size_t payload_length() const { return length_ - PROTOCOL_FULL_FRAME_LENGTH(0); }
+    size_t length() const { return length_; }
+
+private:
+    std::array<uint8_t, PROTOCOL_MAX_FRAME_LENGTH> bytes_;
+    size_t length_;
+};
+
+/**
+ * @brief Cache of encoded frames keyed by (cmd_set, cmd_id, cmd_type, payload hash)
+ *        以 (cmd_set, cmd_id, cmd_type, 有效载荷哈希) 为键的已编码帧缓存
+ *
+ * Meant for commands whose payload is constant per device, such as record control, mode switch and status
+ * subscription. The cache stops inserting once it holds max_entries templates so that varying payloads cannot
+ * grow it without bound. A lookup encodes the payload, hashes it and takes a shared lock, which costs about as much
+ * as encoding the frame, so look a command up once and keep the template; templates do not depend on the device and
+ * can be sent to any number of them.
+ * 适用于每台设备有效载荷固定的命令，例如拍录控制、模式切换和状态订阅。
+ * 模板数达到 max_entries 后不再插入，避免变化的有效载荷使缓存无限增长。一次查找需编码有效载荷、计算哈希并加共享锁，
+ * 开销与编码整帧相当，因此每条命令只查找一次并保留模板；模板与设备无关，可发送给任意多台设备。
+ */
+class FrameTemplateCache {
+public:
+    explicit FrameTemplateCache(size_t max_entries = 64) : max_entries_(max_entries) {}
+
+    // 查找或创建模板；模板创建后不再修改或删除，返回的指针在缓存生命周期内有效
+    // 缓存已满、哈希冲突或有效载荷无法单独编码时返回 nullptr
+    const FrameTemplate *get(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure) {
+        // 有效载荷需先编码才能计算哈希，这里只做 memcpy 级别的工作，不计算 CRC
+        uint8_t payload[PROTOCOL_MAX_DATA_LENGTH];
+        size_t payload_length = 0;
+        if (structure != nullptr &&
+            data_encoder_by_structure(cmd_set, cmd_id, cmd_type, structure, payload, sizeof(payload),
+                                      &payload_length) != 0) {
+            return nullptr;
+        }
+
+        Key key{cmd_set, cmd_id, cmd_type, payload_hash(payload, payload_length)};
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = templates_.find(key);
+            if (it != templates_.end()) {
+                if (!matches(*it->second, payload, payload_length)) {
+                    return nullptr;
+                }
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return it->second.get();
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+
+        uint8_t frame[PROTOCOL_MAX_FRAME_LENGTH];
+        size_t frame_length = 0;
+        if (protocol_encode_frame_into(frame, sizeof(frame), cmd_set, cmd_id, cmd_type, structure, 0,
+                                       &frame_length) != 0) {
+            return nullptr;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        auto it = templates_.find(key);
+        if (it == templates_.end()) {
+            if (templates_.size() >= max_entries_) {
+                return nullptr;
+            }
+            it = templates_.emplace(key, std::make_unique<FrameTemplate>(frame, frame_length)).first;
+        }
+        return matches(*it->second, payload, payload_length) ? it->second.get() : nullptr;
+    }
+
+    // 编码到 out，命中缓存时只改写 SEQ 与校验值，未能缓存时退回完整编码；返回帧长度，失败返回 0
+    size_t encode(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint16_t seq,
+                  uint8_t *out, size_t capacity) {
+        const FrameTemplate *frame_template = get(cmd_set, cmd_id, cmd_type, structure);
+        if (frame_template != nullptr) {
+            return frame_template->stamp(seq, out, capacity);
+        }
+
+        size_t frame_length = 0;
+        if (protocol_encode_frame_into(out, capacity, cmd_set, cmd_id, cmd_type, structure, seq, &frame_length) !=
+            0) {
+            return 0;
+        }
+        return frame_length;
+    }
+
+    size_t size() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return templates_.size();
+    }
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Key {
+        uint8_t cmd_set;
+        uint8_t cmd_id;
+        uint8_t cmd_type;
+        uint64_t payload_hash;
+
+        bool operator==(const Key &other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return std::hash<uint64_t>()(key.payload_hash ^ ((uint64_t)key.cmd_set << 56) ^
+                                         ((uint64_t)key.cmd_id << 48) ^ ((uint64_t)key.cmd_type << 40));
+        }
+    };
+
+    // FNV-1a
+    static uint64_t payload_hash(const uint8_t *data, size_t length) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ data[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    static bool matches(const FrameTemplate &frame_template, const uint8_t *payload, size_t payload_length) {
+        return frame_template.payload_length() == payload_length &&
+               std::memcmp(frame_template.payload(), payload, payload_length) == 0;
+    }
+
+    size_t max_entries_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<Key, std::unique_ptr<FrameTemplate>, KeyHash> templates_;
+    std::atomic<uint64_t> hits_ = 0;
+    std::atomic<uint64_t> misses_ = 0;
+};
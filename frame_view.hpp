@@ -0,0 +1,167 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "dji/dji_protocol_parser.h"
+#include "message_registry.hpp"
+#include "rx_buffer_pool.hpp"
+
+/**
+ * @brief Little-endian load from an arbitrarily aligned address
+ *        从任意对齐的地址按小端读取
+ */
+template <typename T>
+    requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+T load_le(const uint8_t *p) {
+    if constexpr (std::is_enum_v<T>) {
+        return static_cast<T>(load_le<std::underlying_type_t<T>>(p));
+    } else if constexpr (std::is_floating_point_v<T>) {
+        using Bits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+        Bits bits = load_le<Bits>(p);
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    } else {
+        // 逐字节组装，编译器在小端平台上会合并为一次非对齐读取
+        std::make_unsigned_t<T> value = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            value |= static_cast<std::make_unsigned_t<T>>(p[i]) << (8 * i);
+        }
+        return static_cast<T>(value);
+    }
+}
+
+/**
+ * @brief Read-only view of one received frame that keeps its pooled buffer alive
+ *        单个已接收帧的只读视图，持有其所在的池化缓冲区
+ *
+ * The frame must already be validated (the stream reassembler checks both CRCs) and hold at least CmdSet and CmdID,
+ * which RxBufferPool::acquire() enforces, so accessors read the header fields straight from the bytes.
+ * 帧必须已通过校验（流式重组器会检查两个 CRC）且至少包含 CmdSet 与 CmdID（由 RxBufferPool::acquire() 保证），
+ * 访问函数直接从字节中读取帧头字段。
+ */
+class FrameView {
+public:
+    FrameView() = default;
+    explicit FrameView(RxBufferRef buffer) : buffer_(std::move(buffer)) {}
+
+    explicit operator bool() const { return static_cast<bool>(buffer_); }
+
+    const uint8_t *bytes() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+    // 帧重组完成的时间
+    std::chrono::steady_clock::time_point received_at() const { return buffer_.received_at(); }
+
+    uint8_t cmd_type() const { return bytes()[3]; }
+    uint16_t seq() const { return (uint16_t)((bytes()[8] << 8) | bytes()[9]); }
+    uint8_t cmd_set() const { return bytes()[PROTOCOL_HEADER_LENGTH - 2]; }
+    uint8_t cmd_id() const { return bytes()[PROTOCOL_HEADER_LENGTH - 1]; }
+
+    // CmdSet、CmdId 之后的有效载荷
+    std::span<const uint8_t> payload() const {
+        return {bytes() + PROTOCOL_HEADER_LENGTH, size() - PROTOCOL_FULL_FRAME_LENGTH(0)};
+    }
+
+    // 供 C 接口使用的解析结果，data 指向本视图持有的缓冲区
+    protocol_frame_t frame() const {
+        protocol_frame_t frame;
+        protocol_fill_frame(bytes(), size(), &frame);
+        return frame;
+    }
+
+private:
+    RxBufferRef buffer_;
+};
+
+/**
+ * @brief Typed, read-only view of a payload structure inside a FrameView, no copy is made
+ *        FrameView 中有效载荷结构体的类型化只读视图，不进行拷贝
+ *
+ * Read fields with OSMO_FIELD(view, member). Numeric fields are loaded little-endian regardless of host byte order
+ * and alignment, array fields are returned as a span over the frame bytes.
+ * 使用 OSMO_FIELD(view, member) 读取字段。数值字段与主机字节序和对齐无关地按小端读取，数组字段返回指向帧字节的 span。
+ */
+template <typename T> class MessageView {
+public:
+    using value_type = T;
+
+    explicit MessageView(FrameView frame) : frame_(std::move(frame)) {}
+
+    template <typename Field, size_t Offset> auto field() const {
+        static_assert(Offset + sizeof(Field) <= sizeof(T), "field outside of payload structure");
+        const uint8_t *p = frame_.bytes() + PROTOCOL_HEADER_LENGTH + Offset;
+        if constexpr (std::is_array_v<Field>) {
+            return std::span<const uint8_t, sizeof(Field)>(p, sizeof(Field));
+        } else {
+            return load_le<Field>(p);
+        }
+    }
+
+    // 需要完整结构体时再拷贝
+    T copy() const {
+        T value;
+        std::memcpy(&value, frame_.bytes() + PROTOCOL_HEADER_LENGTH, sizeof(T));
+        return value;
+    }
+
+    const FrameView &frame() const { return frame_; }
+
+private:
+    FrameView frame_;
+};
+
+#define OSMO_FIELD(view, member)                                                                                       \
+    (view).template field<decltype(std::declval<typename std::decay_t<decltype(view)>::value_type &>().member),      \
+                          offsetof(typename std::decay_t<decltype(view)>::value_type, member)>()
+
+namespace message_detail {
+
+// 在 OsmoMessages 中查找有效载荷结构体所属的消息与方向
+template <typename T, typename List> struct payload_owner;
+template <typename T> struct payload_owner<T, TypeList<>> {
+    using message = void;
+    static constexpr bool found = false;
+    static constexpr uint8_t cmd_set = 0;
+    static constexpr uint8_t cmd_id = 0;
+    static constexpr bool response = false;
+};
+template <typename T, typename M, typename... Ms> struct payload_owner<T, TypeList<M, Ms...>> {
+    static constexpr bool is_command = std::is_same_v<T, typename M::command_type>;
+    static constexpr bool is_response = std::is_same_v<T, typename M::response_type>;
+    using next = payload_owner<T, TypeList<Ms...>>;
+
+    using message = std::conditional_t<is_command || is_response, M, typename next::message>;
+    static constexpr bool found = is_command || is_response || next::found;
+    static constexpr uint8_t cmd_set = (is_command || is_response) ? M::cmd_set : next::cmd_set;
+    static constexpr uint8_t cmd_id = (is_command || is_response) ? M::cmd_id : next::cmd_id;
+    static constexpr bool response = (is_command || is_response) ? is_response : next::response;
+};
+
+} // namespace message_detail
+
+// 有效载荷结构体所属的 Msg 及其应答结构体
+template <typename T> using message_of_t = typename message_detail::payload_owner<T, OsmoMessages>::message;
+template <typename T> using response_of_t = typename message_of_t<T>::response_type;
+
+/**
+ * @brief View frame as payload structure T, nullopt when the frame is empty, carries another message, the other
+ *        direction or too few bytes
+ *        将帧视为有效载荷结构体 T；帧为空、属于其他消息、方向不符或长度不足时返回 nullopt
+ */
+template <typename T> std::optional<MessageView<T>> view_as(const FrameView &frame) {
+    using Owner = message_detail::payload_owner<T, OsmoMessages>;
+    static_assert(Owner::found, "payload structure is not registered in OsmoMessages");
+
+    if (!frame || frame.cmd_set() != Owner::cmd_set || frame.cmd_id() != Owner::cmd_id ||
+        ((frame.cmd_type() & message_detail::response_bit) != 0) != Owner::response ||
+        frame.payload().size() < sizeof(T)) {
+        return std::nullopt;
+    }
+    return MessageView<T>(frame);
+}
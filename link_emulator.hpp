@@ -0,0 +1,353 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <numbers>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "timed_scheduler.hpp"
+#include "transport.hpp"
+
+/**
+ * @brief Impairs the link between OsmoDevice and any Transport: latency, jitter, loss, duplication, reordering,
+ *        bandwidth caps and notification fragmentation
+ *        在 OsmoDevice 与任意 Transport 之间注入链路损伤：时延、抖动、丢包、重复、乱序、带宽上限与通知分片
+ *
+ * wrap() decorates a transport so that notifications (camera to host) and writes (host to camera) each pass through
+ * their own Impairment. A packet first waits for the direction's bandwidth, then is delayed by latency plus a jitter
+ * sample, and may be dropped, duplicated or held back by reorder_delay so that later packets overtake it; apart from
+ * those held back, packets keep their order as on a real BLE connection. Notifications may also be split into
+ * several smaller ones. Each link and direction draws from its own generator seeded from Config::seed and the order
+ * in which links were wrapped, so the same packets on a link get the same impairments on every run.
+ * wrap() 包装一个传输层，使通知（相机到主机）与写入（主机到相机）各自经过一组 Impairment。每个数据包先按该方向的
+ * 带宽排队，再延迟 latency 加一次抖动采样，并可能被丢弃、重复，或被额外推迟 reorder_delay 使后续数据包先到；除被
+ * 推迟的数据包外，顺序与真实的 BLE 连接一样保持不变。通知还可以被拆成多个更小的通知。每条链路的每个方向使用各自的
+ * 随机数发生器，由 Config::seed 与包装顺序决定，因此同一条链路上相同的数据包在每次运行中得到相同的损伤。
+ *
+ * A direction without any impairment passes straight through. Impaired writes are handed to the inner transport
+ * from the emulator's scheduler thread, so their failures are counted rather than thrown and the request waits for
+ * its timeout. Like CameraSimulator, all links share one scheduler thread and the emulator must outlive its links.
+ * 没有任何损伤的方向直接透传。有损伤的写入由仿真器的调度线程交给内层传输层，写入失败只计数而不抛出，对应的请求
+ * 等到超时。与 CameraSimulator 一样，所有链路共用一个调度线程，仿真器必须比它包装的链路活得更久。
+ */
+class LinkEmulator {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Distribution {
+        Uniform, // latency ± jitter 内均匀分布
+        Normal,  // 以 latency 为均值、jitter 为标准差
+        Pareto,  // latency 加上以 jitter 为尺度的帕累托长尾
+    };
+
+    struct Impairment {
+        Clock::duration latency = Clock::duration::zero();
+        Clock::duration jitter = Clock::duration::zero();
+        Distribution distribution = Distribution::Uniform;
+        double pareto_shape = 2.0;                                     // 越小尾部越长
+        double loss = 0;                                               // 丢弃概率
+        double duplicate = 0;                                          // 再投递一份副本的概率
+        double reorder = 0;                                            // 额外推迟 reorder_delay 的概率
+        Clock::duration reorder_delay = std::chrono::milliseconds(10);
+        uint64_t bandwidth = 0;                                        // 字节每秒，0 表示不限
+        size_t fragment = 0;                                           // 仅通知：拆成不超过此字节数的随机分片，0 表示不拆
+
+        bool active() const {
+            return latency > Clock::duration::zero() || jitter > Clock::duration::zero() || loss > 0 ||
+                   duplicate > 0 || reorder > 0 || bandwidth > 0 || fragment > 0;
+        }
+    };
+
+    struct Config {
+        Impairment notify; // 相机到主机
+        Impairment write;  // 主机到相机
+        uint64_t seed = 1;
+    };
+
+    struct DirectionStats {
+        uint64_t packets = 0;    // 进入链路的数据包
+        uint64_t dropped = 0;
+        uint64_t duplicated = 0;
+        uint64_t reordered = 0;
+        uint64_t fragments = 0;  // 拆分产生的额外分片
+        uint64_t delivered = 0;  // 交给对端的数据包（含副本与分片）
+        uint64_t failed = 0;     // 内层写入抛出异常或链路已断开
+    };
+
+    struct Stats {
+        DirectionStats notify;
+        DirectionStats write;
+    };
+
+    static Config default_config() { return Config(); }
+
+    explicit LinkEmulator(Config config = default_config()) : config_(config) {}
+
+    LinkEmulator(const LinkEmulator &) = delete;
+    LinkEmulator &operator=(const LinkEmulator &) = delete;
+
+    std::unique_ptr<Transport> wrap(std::unique_ptr<Transport> inner) {
+        uint64_t index = next_link_.fetch_add(1, std::memory_order_relaxed);
+        auto state = std::make_shared<State>(std::move(inner));
+        state->paths[Notify].random = Random(config_.seed, index * 2);
+        state->paths[Write].random = Random(config_.seed, index * 2 + 1);
+        return std::make_unique<Link>(*this, std::move(state));
+    }
+
+    Stats stats() const {
+        Stats stats;
+        stats.notify = counters_[Notify].snapshot();
+        stats.write = counters_[Write].snapshot();
+        return stats;
+    }
+
+private:
+    enum Direction { Notify = 0, Write = 1 };
+
+    // splitmix64：输出只取决于种子，不同标准库实现之间也能复现
+    class Random {
+    public:
+        Random() = default;
+        Random(uint64_t seed, uint64_t stream) : state_(seed ^ (stream * 0xD1B54A32D192ED03ull)) {}
+
+        uint64_t next() {
+            uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // [0, 1)
+        double uniform() { return (double)(next() >> 11) * 0x1.0p-53; }
+        bool chance(double probability) { return probability > 0 && uniform() < probability; }
+
+    private:
+        uint64_t state_ = 0;
+    };
+
+    // 单条链路单个方向的状态，由链路锁保护
+    struct Path {
+        Random random;
+        Clock::time_point busy_until; // 带宽占用到此时刻
+        Clock::time_point last_due;   // 未被推迟的数据包按此保持顺序
+    };
+
+    struct State : SimulatedEndpoint {
+        explicit State(std::unique_ptr<Transport> inner) : inner(std::move(inner)) {}
+
+        const std::unique_ptr<Transport> inner;
+        // 同样由 mutex 保护
+        Path paths[2];
+    };
+
+    struct Packet {
+        std::shared_ptr<State> link;
+        uint64_t generation = 0;
+        Direction direction = Notify;
+        std::vector<uint8_t> data;
+    };
+    using Scheduler = TimedScheduler<Packet>;
+    using Event = Scheduler::Event;
+
+    class Link : public Transport {
+    public:
+        Link(LinkEmulator &emulator, std::shared_ptr<State> state) : emulator_(emulator), state_(std::move(state)) {}
+        ~Link() override { disconnect(); }
+
+        void connect() override {
+            state_->inner->connect();
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->connect_locked();
+        }
+
+        void disconnect() override {
+            // 内层传输层持有自己的锁调用通知回调，先断开内层，避免与链路锁形成反向加锁
+            state_->inner->disconnect();
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            state_->disconnect_locked();
+        }
+
+        bool is_connected() override { return state_->inner->is_connected(); }
+        std::string address() override { return state_->inner->address(); }
+        size_t mtu() override { return state_->inner->mtu(); }
+
+        void subscribe(NotifyCallback callback) override {
+            if (!emulator_.config_.notify.active()) {
+                state_->inner->subscribe(std::move(callback));
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(state_->mutex);
+                state_->callback = std::move(callback);
+            }
+            state_->inner->subscribe([&emulator = emulator_, link = std::weak_ptr<State>(state_)](
+                                         const uint8_t *data, size_t length) {
+                if (auto state = link.lock()) {
+                    emulator.transmit(state, Notify, data, length);
+                }
+            });
+        }
+
+        void write(const uint8_t *data, size_t length) override {
+            if (!emulator_.config_.write.active()) {
+                state_->inner->write(data, length);
+                return;
+            }
+            emulator_.transmit(state_, Write, data, length);
+        }
+
+    private:
+        LinkEmulator &emulator_;
+        std::shared_ptr<State> state_;
+    };
+
+    Clock::duration jitter(const Impairment &impairment, Random &random) {
+        if (impairment.jitter <= Clock::duration::zero()) {
+            return Clock::duration::zero();
+        }
+        double scale = (double)impairment.jitter.count();
+        double sample = 0;
+        switch (impairment.distribution) {
+        case Distribution::Uniform:
+            sample = (random.uniform() * 2 - 1) * scale;
+            break;
+        case Distribution::Normal: {
+            // Box-Muller
+            double u = 1.0 - random.uniform();
+            sample = std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * std::numbers::pi * random.uniform()) * scale;
+            break;
+        }
+        case Distribution::Pareto:
+            sample = scale * (std::pow(1.0 - random.uniform(), -1.0 / impairment.pareto_shape) - 1.0);
+            break;
+        }
+        return Clock::duration((Clock::duration::rep)sample);
+    }
+
+    // 在通知线程或写线程上调用：为一个数据包决定损伤并排定投递
+    void transmit(const std::shared_ptr<State> &link, Direction direction, const uint8_t *data, size_t length) {
+        const Impairment &impairment = direction == Notify ? config_.notify : config_.write;
+        DirectionCounters &counters = counters_[direction];
+        counters.packets.fetch_add(1, std::memory_order_relaxed);
+
+        std::vector<Event> events;
+        {
+            std::lock_guard<std::mutex> lock(link->mutex);
+            if (!link->connected) {
+                counters.failed.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            Path &path = link->paths[direction];
+            Random &random = path.random;
+            Clock::time_point now = Clock::now();
+
+            // 先占用带宽，丢失的数据包同样占用了空口时间
+            Clock::time_point sent = std::max(now, path.busy_until);
+            if (impairment.bandwidth > 0) {
+                sent += std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>((double)length / (double)impairment.bandwidth));
+                path.busy_until = sent;
+            }
+            if (random.chance(impairment.loss)) {
+                counters.dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            Clock::time_point due = sent + impairment.latency + jitter(impairment, random);
+            if (random.chance(impairment.reorder)) {
+                due = std::max(due, path.last_due) + impairment.reorder_delay;
+                counters.reordered.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                due = std::max(due, path.last_due);
+                path.last_due = due;
+            }
+
+            size_t copies = random.chance(impairment.duplicate) ? 2 : 1;
+            if (copies > 1) {
+                counters.duplicated.fetch_add(1, std::memory_order_relaxed);
+            }
+            for (size_t copy = 0; copy < copies; copy++) {
+                size_t offset = 0;
+                while (offset < length) {
+                    size_t size = length - offset;
+                    if (direction == Notify && impairment.fragment > 0) {
+                        size = std::min(size, 1 + (size_t)(random.next() % impairment.fragment));
+                    }
+                    events.push_back(Event{due, Packet{link, link->generation, direction,
+                                                       std::vector<uint8_t>(data + offset, data + offset + size)}});
+                    offset += size;
+                }
+            }
+            if (events.size() > copies) {
+                counters.fragments.fetch_add(events.size() - copies, std::memory_order_relaxed);
+            }
+        }
+        scheduler_.schedule(std::move(events));
+    }
+
+    // 调度线程调用：把到期的数据包交给对端
+    void deliver(Event &event) {
+        Packet &packet = event.item;
+        State &state = *packet.link;
+        DirectionCounters &counters = counters_[packet.direction];
+        if (packet.direction == Notify) {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.current_locked(packet.generation) || !state.callback) {
+                counters.failed.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            state.callback(packet.data.data(), packet.data.size());
+            counters.delivered.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.current_locked(packet.generation)) {
+                counters.failed.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        // 不持有链路锁写入内层，内层可能在写入时同步发出通知
+        try {
+            state.inner->write(packet.data.data(), packet.data.size());
+            counters.delivered.fetch_add(1, std::memory_order_relaxed);
+        } catch (const std::exception &) {
+            counters.failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    struct DirectionCounters {
+        std::atomic<uint64_t> packets = 0;
+        std::atomic<uint64_t> dropped = 0;
+        std::atomic<uint64_t> duplicated = 0;
+        std::atomic<uint64_t> reordered = 0;
+        std::atomic<uint64_t> fragments = 0;
+        std::atomic<uint64_t> delivered = 0;
+        std::atomic<uint64_t> failed = 0;
+
+        DirectionStats snapshot() const {
+            DirectionStats stats;
+            stats.packets = packets.load(std::memory_order_relaxed);
+            stats.dropped = dropped.load(std::memory_order_relaxed);
+            stats.duplicated = duplicated.load(std::memory_order_relaxed);
+            stats.reordered = reordered.load(std::memory_order_relaxed);
+            stats.fragments = fragments.load(std::memory_order_relaxed);
+            stats.delivered = delivered.load(std::memory_order_relaxed);
+            stats.failed = failed.load(std::memory_order_relaxed);
+            return stats;
+        }
+    };
+
+    const Config config_;
+    std::atomic<uint64_t> next_link_ = 0;
+    DirectionCounters counters_[2];
+    Scheduler scheduler_{[this](Event &event) { deliver(event); }};
+};
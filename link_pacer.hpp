@@ -0,0 +1,126 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Credit window over outstanding BLE writes plus link throughput statistics
+ *        在途 BLE 写操作的信用窗口及链路吞吐统计
+ *
+ * Writes without response are never acknowledged, so credits come back on a timer: every write takes one credit
+ * and returns it credit_return after it was written, so at most `credits` writes are in flight per credit_return.
+ * BleWriter derives both from the connection parameters, the packets the peripheral takes per connection event and
+ * the connection interval, because a queued write goes out in the next connection event. credits 0 disables pacing.
+ * 无应答写入不会得到确认，因此信用按时间归还：每次写操作占用一个信用，写出 credit_return 之后归还，即每个
+ * credit_return 内最多有 credits 次写操作在途。BleWriter 根据连接参数设定两者：外设每个连接事件能接收的包数与
+ * 连接间隔，因为排队的写操作在下一个连接事件中发出。credits 为 0 时不限制。
+ *
+ * The outstanding writes are kept in a ring of `credits` entries allocated up front, so the writer thread never
+ * allocates here. Only the writer thread calls has_credit(), next_credit_time() and on_write(); stats() may be
+ * called from any thread.
+ * 在途写操作记录在预先分配的 credits 个条目的环形缓冲中，写线程在这里不会分配内存。只有写线程调用
+ * has_credit()、next_credit_time() 和 on_write()；stats() 可在任意线程调用。
+ */
+class LinkPacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        uint64_t writes = 0;         // write_command 调用次数，含分片
+        uint64_t frames = 0;         // 完整发出的协议帧数
+        uint64_t bytes = 0;          // 写出的字节数
+        uint64_t fragments = 0;      // 因超出 MTU 而拆分出的写操作数
+        uint64_t credit_waits = 0;   // 因信用耗尽而等待的次数
+        double frames_per_write = 0; // frames / writes
+        double bytes_per_second = 0; // 最近一个完整统计窗口内的吞吐，链路空闲时随时间下降
+    };
+
+    LinkPacer(size_t credits, Clock::duration credit_return)
+        : credits_(credits), credit_return_(credit_return), outstanding_(credits) {}
+
+    bool has_credit(Clock::time_point now) {
+        if (credits_ == 0) {
+            return true;
+        }
+        expire(now);
+        if (count_ < credits_) {
+            return true;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.credit_waits++;
+        return false;
+    }
+
+    // 信用耗尽时最早归还一个信用的时间
+    Clock::time_point next_credit_time() const {
+        return count_ == 0 ? Clock::now() : outstanding_[head_] + credit_return_;
+    }
+
+    // 记录一次写操作；frames 为本次写完的协议帧数，fragment 表示这是一个超长帧的分片
+    void on_write(Clock::time_point now, size_t bytes, size_t frames, bool fragment) {
+        if (credits_ != 0) {
+            expire(now);
+            // 未检查信用就写出（MTU 未知时）的写操作会占满窗口，此时覆盖最早的一条
+            if (count_ == credits_) {
+                head_ = (head_ + 1) % credits_;
+                count_--;
+            }
+            outstanding_[(head_ + count_) % credits_] = now;
+            count_++;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.writes++;
+        stats_.frames += frames;
+        stats_.bytes += bytes;
+        stats_.fragments += fragment ? 1 : 0;
+
+        if (window_bytes_ == 0 && stats_.writes == 1) {
+            window_start_ = now;
+        }
+        window_bytes_ += bytes;
+        auto elapsed = std::chrono::duration<double>(now - window_start_).count();
+        if (elapsed >= window_seconds) {
+            stats_.bytes_per_second = window_bytes_ / elapsed;
+            window_start_ = now;
+            window_bytes_ = 0;
+        }
+    }
+
+    Stats stats() const {
+        Clock::time_point now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        Stats stats = stats_;
+        stats.frames_per_write = stats.writes != 0 ? (double)stats.frames / stats.writes : 0;
+        // 当前窗口已满一个统计周期却没有写操作来结束它（链路空闲），按至今的时长折算，而不是沿用上一个窗口的值
+        auto elapsed = std::chrono::duration<double>(now - window_start_).count();
+        if (stats.writes != 0 && elapsed >= window_seconds) {
+            stats.bytes_per_second = window_bytes_ / elapsed;
+        }
+        return stats;
+    }
+
+private:
+    static constexpr double window_seconds = 1.0;
+
+    // 归还已超过 credit_return 的写操作占用的信用
+    void expire(Clock::time_point now) {
+        while (count_ != 0 && outstanding_[head_] + credit_return_ <= now) {
+            head_ = (head_ + 1) % credits_;
+            count_--;
+        }
+    }
+
+    const size_t credits_;
+    const Clock::duration credit_return_;
+    // 仅写线程访问，按写出时间排序的环形缓冲，从 head_ 开始共 count_ 条
+    std::vector<Clock::time_point> outstanding_;
+    size_t head_ = 0;
+    size_t count_ = 0;
+
+    mutable std::mutex mutex_;
+    Stats stats_;
+    Clock::time_point window_start_;
+    uint64_t window_bytes_ = 0;
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Read-only mapping of a whole file, mmap on POSIX systems and MapViewOfFile on Windows
+ *        整个文件的只读映射，POSIX 系统上使用 mmap，Windows 上使用 MapViewOfFile
+ *
+ * The file may still be written by another process, the mapping covers the size it had when it was opened. An empty
+ * file is not mapped and has no data. what names the kind of file in error messages.
+ * 文件仍可被其他进程写入，映射范围是打开时的大小。空文件不做映射，没有数据。what 为错误信息中的文件类型名称。
+ */
+class MappedFile {
+public:
+    // 无法打开或映射时抛出异常
+    MappedFile(const std::string &path, const char *what) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error(std::string("Failed to open ") + what + " " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error(std::string("Failed to open ") + what + " " + path);
+        }
+        size_ = (size_t)size.QuadPart;
+        if (size_ == 0) {
+            CloseHandle(file);
+            return;
+        }
+        // 视图会保持文件映射对象存活，两个句柄都可以立即关闭
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        void *view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        if (view == nullptr) {
+            throw std::runtime_error(std::string("Failed to map ") + what + " " + path);
+        }
+        data_ = static_cast<const uint8_t *>(view);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("Failed to open ") + what + " " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("Failed to open ") + what + " " + path);
+        }
+        size_ = (size_t)st.st_size;
+        if (size_ == 0) {
+            ::close(fd);
+            return;
+        }
+        void *mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error(std::string("Failed to map ") + what + " " + path);
+        }
+        data_ = static_cast<const uint8_t *>(mapping);
+#endif
+    }
+
+    ~MappedFile() {
+        if (data_ == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        ::munmap(const_cast<uint8_t *>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// 将 from 改名为 to，to 已存在时将其替换；Windows 上 std::rename 不会覆盖已有文件
+inline bool replace_file(const std::string &from, const std::string &to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
+#include "dji/dji_protocol_data_structures.h"
+#include "dji/dji_protocol_parser.h"
+
+/**
+ * @brief Compile-time message registry on top of the C protocol layer
+ *        基于 C 协议层的编译期消息注册表
+ *
+ * Every message is a Msg<CmdSet, CmdId, Command, Response> listed in OsmoMessages. Encoding and decoding are
+ * resolved per type at compile time: payloads are copied by value with fixed sizes, there is no heap allocation
+ * and no call through data_creator_func_t / data_parser_func_t. The frame envelope and CRCs still come from
+ * protocol_write_envelope, and the C API (protocol_create_frame, protocol_parse_data, ...) is unchanged.
+ * 每条消息是 OsmoMessages 中的一个 Msg<CmdSet, CmdId, Command, Response>。编码和解码在编译期按类型确定：
+ * 有效载荷按固定长度值拷贝，没有堆分配，也不经过 data_creator_func_t / data_parser_func_t 间接调用。
+ * 帧头与 CRC 仍由 protocol_write_envelope 生成，C 接口（protocol_create_frame、protocol_parse_data 等）保持不变。
+ *
+ * Use void for a direction the message does not have. Messages with a variable-length payload such as the
+ * version query (flexible array member) are not registered here and keep using the C API.
+ * 消息不存在的方向使用 void。有效载荷长度可变的消息（例如带柔性数组的版本号查询）不在此注册，继续使用 C 接口。
+ */
+template <uint8_t Set, uint8_t Id, typename Command, typename Response> struct Msg {
+    static constexpr uint8_t cmd_set = Set;
+    static constexpr uint8_t cmd_id = Id;
+    using command_type = Command;
+    using response_type = Response;
+};
+
+template <typename... Ts> struct TypeList {};
+
+namespace message_detail {
+
+// 命令帧与应答帧由 CmdType 的第 5 位区分
+inline constexpr uint8_t response_bit = 0x20;
+
+template <typename T> constexpr bool is_payload_v = std::is_void_v<T> || std::is_trivially_copyable_v<T>;
+
+template <typename T> constexpr bool fits_frame_v = std::is_void_v<T> || sizeof(T) <= PROTOCOL_MAX_DATA_LENGTH;
+
+template <typename T, typename... Ts> constexpr bool is_one_of_v = (std::is_same_v<T, Ts> || ...);
+
+template <typename... Ts> constexpr bool all_distinct() {
+    if constexpr (sizeof...(Ts) == 0) {
+        return true;
+    } else {
+        return []<typename T, typename... Rest>(TypeList<T, Rest...>) {
+            return !is_one_of_v<T, Rest...> && all_distinct<Rest...>();
+        }(TypeList<Ts...>{});
+    }
+}
+
+// 展开所有消息的两个方向并去掉 void，得到 std::variant 的备选类型
+template <typename Variant, typename T> struct append_payload {
+    using type = Variant;
+};
+template <typename... Vs, typename T>
+    requires(!std::is_void_v<T>)
+struct append_payload<std::variant<Vs...>, T> {
+    using type = std::variant<Vs..., T>;
+};
+
+template <typename Variant, typename List> struct payload_variant;
+template <typename Variant> struct payload_variant<Variant, TypeList<>> {
+    using type = Variant;
+};
+template <typename Variant, typename M, typename... Ms> struct payload_variant<Variant, TypeList<M, Ms...>> {
+    using with_command = typename append_payload<Variant, typename M::command_type>::type;
+    using with_response = typename append_payload<with_command, typename M::response_type>::type;
+    using type = typename payload_variant<with_response, TypeList<Ms...>>::type;
+};
+
+template <typename Variant> struct variant_distinct;
+template <typename... Vs> struct variant_distinct<std::variant<Vs...>> {
+    static constexpr bool value = all_distinct<Vs...>();
+};
+
+template <typename List> struct message_keys_distinct;
+template <typename... Ms> struct message_keys_distinct<TypeList<Ms...>> {
+    static constexpr bool value =
+        all_distinct<std::integral_constant<uint16_t, (Ms::cmd_set << 8) | Ms::cmd_id>...>();
+};
+
+// 尺寸与方向在编译期确定，长度检查只剩一次比较
+template <typename T, typename Visitor>
+bool decode_payload(const uint8_t *data, size_t data_length, Visitor &&visitor) {
+    if constexpr (std::is_void_v<T>) {
+        return false;
+    } else {
+        if (data_length < sizeof(T)) {
+            return false;
+        }
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        visitor(value);
+        return true;
+    }
+}
+
+template <typename M, typename Visitor>
+bool decode_one(uint8_t cmd_type, const uint8_t *data, size_t data_length, Visitor &&visitor) {
+    if (cmd_type & response_bit) {
+        return decode_payload<typename M::response_type>(data, data_length, visitor);
+    }
+    return decode_payload<typename M::command_type>(data, data_length, visitor);
+}
+
+template <typename Visitor, typename... Ms>
+bool dispatch(TypeList<Ms...>, uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const uint8_t *data,
+              size_t data_length, Visitor &&visitor) {
+    bool decoded = false;
+    ((cmd_set == Ms::cmd_set && cmd_id == Ms::cmd_id
+          ? (decoded = decode_one<Ms>(cmd_type, data, data_length, visitor), true)
+          : false) ||
+     ...);
+    return decoded;
+}
+
+} // namespace message_detail
+
+// 拍摄模式切换
+using CameraModeSwitchMsg = Msg<0x1D, 0x04, camera_mode_switch_command_frame_t, camera_mode_switch_response_frame_t>;
+// 拍录控制
+using RecordControlMsg = Msg<0x1D, 0x03, record_control_command_frame_t, record_control_response_frame_t>;
+// GPS 数据推送
+using GpsDataPushMsg = Msg<0x00, 0x17, gps_data_push_command_frame, gps_data_push_response_frame>;
+// 连接请求
+using ConnectionRequestMsg = Msg<0x00, 0x19, connection_request_command_frame, connection_request_response_frame>;
+// 相机状态订阅
+using CameraStatusSubscriptionMsg = Msg<0x1D, 0x05, camera_status_subscription_command_frame, void>;
+// 相机状态推送
+using CameraStatusPushMsg = Msg<0x1D, 0x02, camera_status_push_command_frame, void>;
+// 按键上报
+using KeyReportMsg = Msg<0x00, 0x11, key_report_command_frame_t, key_report_response_frame_t>;
+
+using OsmoMessages = TypeList<CameraModeSwitchMsg, RecordControlMsg, GpsDataPushMsg, ConnectionRequestMsg,
+                              CameraStatusSubscriptionMsg, CameraStatusPushMsg, KeyReportMsg>;
+
+/**
+ * @brief Any decoded payload, std::monostate when the frame is unknown or too short
+ *        任意已解码的有效载荷，帧未注册或长度不足时为 std::monostate
+ */
+using DecodedMessage = message_detail::payload_variant<std::variant<std::monostate>, OsmoMessages>::type;
+
+static_assert(message_detail::message_keys_distinct<OsmoMessages>::value, "duplicate (CmdSet, CmdId) in OsmoMessages");
+static_assert(message_detail::variant_distinct<DecodedMessage>::value,
+              "each payload structure must belong to exactly one message direction");
+
+/**
+ * @brief Encode a typed payload into out, returns the frame length or 0 if the buffer is too small or cmd_type
+ *        selects the other direction
+ *        将类型化的有效载荷编码到 out，返回帧长度；缓冲区不足或 cmd_type 与有效载荷方向不符时返回 0
+ */
+template <typename M, typename T>
+    requires(std::is_same_v<T, typename M::command_type> || std::is_same_v<T, typename M::response_type>)
+size_t encode_message(const T &payload, uint8_t cmd_type, uint16_t seq, uint8_t *out, size_t capacity) {
+    static_assert(message_detail::is_payload_v<T>, "payload must be trivially copyable");
+    static_assert(message_detail::fits_frame_v<T>, "payload too large for one frame");
+    constexpr bool is_response = std::is_same_v<T, typename M::response_type>;
+
+    if (((cmd_type & message_detail::response_bit) != 0) != is_response) {
+        return 0;
+    }
+    if (capacity < PROTOCOL_FULL_FRAME_LENGTH(sizeof(T))) {
+        return 0;
+    }
+    std::memcpy(out + PROTOCOL_HEADER_LENGTH, &payload, sizeof(T));
+    return protocol_write_envelope(out, M::cmd_set, M::cmd_id, cmd_type, seq, sizeof(T));
+}
+
+/**
+ * @brief Encode into an exactly sized array, the frame length is part of the return type
+ *        编码到长度恰好的数组中，帧长度体现在返回类型上
+ */
+template <typename M, typename T>
+    requires(std::is_same_v<T, typename M::command_type> || std::is_same_v<T, typename M::response_type>)
+std::array<uint8_t, PROTOCOL_FULL_FRAME_LENGTH(sizeof(T))> encode_message(const T &payload, uint8_t cmd_type,
+                                                                          uint16_t seq) {
+    std::array<uint8_t, PROTOCOL_FULL_FRAME_LENGTH(sizeof(T))> frame{};
+    encode_message<M>(payload, cmd_type, seq, frame.data(), frame.size());
+    return frame;
+}
+
+/**
+ * @brief Decode a parsed frame and call visitor with the concrete payload structure
+ *        解码已解析的帧，并以具体的有效载荷结构体调用 visitor
+ *
+ * Returns false when the (CmdSet, CmdId) is not registered, the direction has no payload type or the data is
+ * shorter than the structure.
+ * (CmdSet, CmdId) 未注册、该方向没有有效载荷类型或数据短于结构体时返回 false。
+ */
+template <typename Visitor> bool decode_message(const protocol_frame_t &frame, Visitor &&visitor) {
+    if (frame.data == nullptr || frame.data_length < PROTOCOL_CMD_SET_LENGTH + PROTOCOL_CMD_ID_LENGTH) {
+        return false;
+    }
+    return message_detail::dispatch(OsmoMessages{}, frame.data[0], frame.data[1], frame.cmd_type, frame.data + 2,
+                                    frame.data_length - 2, visitor);
+}
+
+/**
+ * @brief Decode a parsed frame into a DecodedMessage
+ *        将已解析的帧解码为 DecodedMessage
+ */
+inline DecodedMessage decode_message(const protocol_frame_t &frame) {
+    DecodedMessage message;
+    decode_message(frame, [&message](const auto &payload) { message = payload; });
+    return message;
+}
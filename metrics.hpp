@@ -0,0 +1,515 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace metrics_detail {
+
+constexpr size_t cache_line = 64;
+
+// 每个线程固定使用一个分片，分片数为 2 的幂
+template <size_t Shards> size_t shard_index() {
+    static std::atomic<size_t> next = 0;
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index & (Shards - 1);
+}
+
+// Prometheus 文本格式中的标签值转义
+inline void append_escaped(std::string &out, const std::string &value) {
+    for (char c : value) {
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '"':
+            out += "\\\"";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        default:
+            out += c;
+            break;
+        }
+    }
+}
+
+inline std::string format_double(double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    return buffer;
+}
+
+} // namespace metrics_detail
+
+/**
+ * @brief Monotonic counter sharded per thread
+ *        按线程分片的单调计数器
+ *
+ * Each thread increments its own cache-line sized shard with a relaxed add, so threads counting the same event do not
+ * bounce one cache line between cores. value() sums the shards.
+ * 每个线程以 relaxed 加法累加自己独占一条缓存行的分片，多个线程统计同一事件时不会在核心之间来回争用同一条缓存行。
+ * value() 对所有分片求和。
+ */
+class Counter {
+public:
+    void inc(uint64_t n = 1) {
+        shards_[metrics_detail::shard_index<shard_count>()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto &shard : shards_) {
+            total += shard.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+private:
+    static constexpr size_t shard_count = 8;
+
+    struct alignas(metrics_detail::cache_line) Shard {
+        std::atomic<uint64_t> value = 0;
+    };
+    std::array<Shard, shard_count> shards_;
+};
+
+// 瞬时值，例如队列深度；由单一来源设置，不分片
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_ = 0;
+};
+
+/**
+ * @brief Log-linear latency histogram in microseconds, sharded per thread
+ *        以微秒为单位、按线程分片的对数线性延迟直方图
+ *
+ * Every power of two is split into sub_buckets linear buckets, so the relative error of a quantile is at most
+ * 1 / sub_buckets at any scale, from single microseconds to minutes, with a fixed number of buckets and one relaxed
+ * add per observation.
+ * 每个 2 的幂区间再线性划分为 sub_buckets 个桶，因此从微秒到分钟的任何量级上分位数的相对误差都不超过
+ * 1 / sub_buckets；桶数固定，每次记录只需一次 relaxed 加法。
+ */
+class Histogram {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t sub_bucket_bits = 3;
+    static constexpr size_t sub_buckets = size_t(1) << sub_bucket_bits;
+    // 2^max_exponent 微秒（约 71 分钟）及以上的值计入最后一个桶
+    static constexpr size_t max_exponent = 32;
+    static constexpr size_t bucket_count = (max_exponent - sub_bucket_bits + 1) * sub_buckets;
+
+    struct Snapshot {
+        std::array<uint64_t, bucket_count> buckets{};
+        uint64_t count = 0;
+        uint64_t sum = 0; // 微秒
+
+        // q 取 [0, 1]，返回所在桶的上界（微秒）
+        uint64_t quantile(double q) const {
+            if (count == 0) {
+                return 0;
+            }
+            uint64_t rank = (uint64_t)(q * (double)(count - 1)) + 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < bucket_count; i++) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return upper_bound(i);
+                }
+            }
+            return upper_bound(bucket_count - 1);
+        }
+    };
+
+    void observe(Clock::duration duration) {
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        observe_micros(micros > 0 ? (uint64_t)micros : 0);
+    }
+
+    void observe_micros(uint64_t micros) {
+        Shard &shard = shards_[metrics_detail::shard_index<shard_count>()];
+        shard.buckets[bucket_of(micros)].fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(micros, std::memory_order_relaxed);
+    }
+
+    Snapshot snapshot() const {
+        Snapshot snapshot;
+        for (const auto &shard : shards_) {
+            for (size_t i = 0; i < bucket_count; i++) {
+                uint64_t n = shard.buckets[i].load(std::memory_order_relaxed);
+                snapshot.buckets[i] += n;
+                snapshot.count += n;
+            }
+            snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+        }
+        return snapshot;
+    }
+
+    static size_t bucket_of(uint64_t micros) {
+        if (micros < sub_buckets) {
+            return (size_t)micros;
+        }
+        size_t exponent = 63 - (size_t)std::countl_zero(micros);
+        if (exponent >= max_exponent) {
+            return bucket_count - 1;
+        }
+        size_t sub = (size_t)(micros >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+        return (exponent - sub_bucket_bits + 1) * sub_buckets + sub;
+    }
+
+    // 桶 index 中最大的值（微秒）
+    static uint64_t upper_bound(size_t index) {
+        if (index < sub_buckets) {
+            return index;
+        }
+        size_t exponent = index / sub_buckets + sub_bucket_bits - 1;
+        uint64_t sub = index % sub_buckets;
+        return ((sub_buckets + sub + 1) << (exponent - sub_bucket_bits)) - 1;
+    }
+
+private:
+    static constexpr size_t shard_count = 4;
+
+    struct alignas(metrics_detail::cache_line) Shard {
+        std::array<std::atomic<uint64_t>, bucket_count> buckets{};
+        std::atomic<uint64_t> sum = 0;
+    };
+    std::array<Shard, shard_count> shards_;
+};
+
+/**
+ * @brief Named metric families with labels, rendered in the Prometheus text exposition format
+ *        带标签的具名指标族，按 Prometheus 文本格式输出
+ *
+ * counter(), gauge() and histogram() take a lock and return the same object for the same name and labels; callers
+ * look metrics up once and keep the reference, after which updating them is lock-free. Metrics live as long as the
+ * registry. Collectors run before every export and copy statistics that components already keep (queue depths,
+ * drop counts) into metrics.
+ * counter()、gauge() 与 histogram() 会加锁，相同名称与标签返回同一个对象；调用方查找一次后保存引用，此后的更新
+ * 都是无锁的。指标与注册表的生命周期相同。每次导出前先运行收集函数，将各组件已有的统计（队列深度、丢弃计数）
+ * 复制到指标中。
+ */
+class MetricsRegistry {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+    using Collector = std::function<void()>;
+
+    MetricsRegistry() = default;
+    MetricsRegistry(const MetricsRegistry &) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry &) = delete;
+
+    static MetricsRegistry &global() {
+        static MetricsRegistry registry;
+        return registry;
+    }
+
+    Counter &counter(const std::string &name, const std::string &help, const Labels &labels = {}) {
+        return *find_or_add(name, help, Type::Counter, labels).counter;
+    }
+
+    Gauge &gauge(const std::string &name, const std::string &help, const Labels &labels = {}) {
+        return *find_or_add(name, help, Type::Gauge, labels).gauge;
+    }
+
+    // 记录微秒，导出时以秒为单位
+    Histogram &histogram(const std::string &name, const std::string &help, const Labels &labels = {}) {
+        return *find_or_add(name, help, Type::Histogram, labels).histogram;
+    }
+
+    size_t add_collector(Collector collector) {
+        std::lock_guard<std::mutex> lock(collect_mutex_);
+        size_t id = next_collector_++;
+        collectors_.emplace(id, std::move(collector));
+        return id;
+    }
+
+    // 返回后该收集函数不会再被调用
+    void remove_collector(size_t id) {
+        std::lock_guard<std::mutex> lock(collect_mutex_);
+        collectors_.erase(id);
+    }
+
+    std::string prometheus_text() {
+        {
+            std::lock_guard<std::mutex> lock(collect_mutex_);
+            for (auto &[id, collector] : collectors_) {
+                collector();
+            }
+        }
+
+        std::string out;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &[name, family] : families_) {
+            out += "# HELP " + name + " " + family.help + "\n";
+            out += "# TYPE " + name + " " + type_name(family.type) + "\n";
+            for (const auto &series : family.series) {
+                switch (family.type) {
+                case Type::Counter:
+                    append_sample(out, name, series->labels, "", std::to_string(series->counter->value()));
+                    break;
+                case Type::Gauge:
+                    append_sample(out, name, series->labels, "", std::to_string(series->gauge->value()));
+                    break;
+                case Type::Histogram:
+                    append_histogram(out, name, *series);
+                    break;
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    enum class Type : uint8_t {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    struct Series {
+        Labels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family {
+        std::string help;
+        Type type;
+        std::vector<std::unique_ptr<Series>> series;
+    };
+
+    // 导出的桶边界：从 2^sub_bucket_bits - 1 微秒起每个 2 的幂一个，直到约一分钟
+    static constexpr size_t exported_max_exponent = 26;
+
+    static const char *type_name(Type type) {
+        switch (type) {
+        case Type::Counter:
+            return "counter";
+        case Type::Gauge:
+            return "gauge";
+        default:
+            return "histogram";
+        }
+    }
+
+    Series &find_or_add(const std::string &name, const std::string &help, Type type, const Labels &labels) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto [it, inserted] = families_.try_emplace(name);
+        Family &family = it->second;
+        if (inserted) {
+            family.help = help;
+            family.type = type;
+        }
+        // 同名指标必须是同一类型，否则导出的格式无效
+        if (family.type != type) {
+            throw std::logic_error("metric " + name + " registered with a different type");
+        }
+        for (auto &series : family.series) {
+            if (series->labels == labels) {
+                return *series;
+            }
+        }
+
+        auto series = std::make_unique<Series>();
+        series->labels = labels;
+        switch (type) {
+        case Type::Counter:
+            series->counter = std::make_unique<Counter>();
+            break;
+        case Type::Gauge:
+            series->gauge = std::make_unique<Gauge>();
+            break;
+        case Type::Histogram:
+            series->histogram = std::make_unique<Histogram>();
+            break;
+        }
+        family.series.push_back(std::move(series));
+        return *family.series.back();
+    }
+
+    static void append_sample(std::string &out, const std::string &name, const Labels &labels, const std::string &le,
+                              const std::string &value) {
+        out += name;
+        if (!labels.empty() || !le.empty()) {
+            out += '{';
+            bool first = true;
+            for (const auto &[key, label] : labels) {
+                out += first ? "" : ",";
+                out += key + "=\"";
+                metrics_detail::append_escaped(out, label);
+                out += '"';
+                first = false;
+            }
+            if (!le.empty()) {
+                out += first ? "" : ",";
+                out += "le=\"" + le + "\"";
+            }
+            out += '}';
+        }
+        out += ' ';
+        out += value;
+        out += '\n';
+    }
+
+    static void append_histogram(std::string &out, const std::string &name, const Series &series) {
+        Histogram::Snapshot snapshot = series.histogram->snapshot();
+        uint64_t cumulative = 0;
+        size_t index = 0;
+        for (size_t exponent = Histogram::sub_bucket_bits; exponent <= exported_max_exponent; exponent++) {
+            // 累加所有值都不超过 2^exponent - 1 微秒的桶；le 是包含的上界，因此标为该值而不是 2^exponent
+            uint64_t bound = (uint64_t(1) << exponent) - 1;
+            while (index < Histogram::bucket_count && Histogram::upper_bound(index) <= bound) {
+                cumulative += snapshot.buckets[index++];
+            }
+            append_sample(out, name + "_bucket", series.labels, metrics_detail::format_double((double)bound / 1e6),
+                          std::to_string(cumulative));
+        }
+        append_sample(out, name + "_bucket", series.labels, "+Inf", std::to_string(snapshot.count));
+        append_sample(out, name + "_sum", series.labels, "", metrics_detail::format_double((double)snapshot.sum / 1e6));
+        append_sample(out, name + "_count", series.labels, "", std::to_string(snapshot.count));
+    }
+
+    std::mutex mutex_;
+    std::map<std::string, Family> families_;
+
+    std::mutex collect_mutex_;
+    std::map<size_t, Collector> collectors_;
+    size_t next_collector_ = 0;
+};
+
+/**
+ * @brief Metrics of one family indexed by a 16-bit key such as (cmd_set << 8) | cmd_id
+ *        以 16 位键（例如 (cmd_set << 8) | cmd_id）索引的一组同族指标
+ *
+ * Two levels of 256 atomic pointers filled on first use through the registry, so a lookup on the hot path is two
+ * acquire loads and only the first use of a key takes the registry lock.
+ * 两级各 256 个原子指针，首次使用时通过注册表创建，热路径上的查找只是两次 acquire 读取，只有某个键第一次使用时
+ * 才会获取注册表的锁。
+ */
+template <typename Metric> class KeyedMetrics {
+public:
+    // 为键创建（或取回）注册表中的指标
+    using Factory = std::function<Metric &(uint16_t key)>;
+
+    explicit KeyedMetrics(Factory factory) : factory_(std::move(factory)) {}
+    ~KeyedMetrics() {
+        for (auto &page : pages_) {
+            delete page.load(std::memory_order_relaxed);
+        }
+    }
+
+    KeyedMetrics(const KeyedMetrics &) = delete;
+    KeyedMetrics &operator=(const KeyedMetrics &) = delete;
+
+    Metric &operator[](uint16_t key) {
+        Page *page = pages_[key >> 8].load(std::memory_order_acquire);
+        if (page == nullptr) {
+            auto created = std::make_unique<Page>();
+            if (pages_[key >> 8].compare_exchange_strong(page, created.get(), std::memory_order_acq_rel)) {
+                page = created.release();
+            }
+        }
+        std::atomic<Metric *> &slot = (*page)[key & 0xFF];
+        Metric *metric = slot.load(std::memory_order_acquire);
+        if (metric == nullptr) {
+            // 注册表对相同标签返回同一个对象，并发创建时写入的是同一个指针
+            metric = &factory_(key);
+            slot.store(metric, std::memory_order_release);
+        }
+        return *metric;
+    }
+
+private:
+    using Page = std::array<std::atomic<Metric *>, 256>;
+
+    Factory factory_;
+    std::array<std::atomic<Page *>, 256> pages_{};
+};
+
+/**
+ * @brief Periodically writes the registry to a Prometheus text file
+ *        定期将注册表写入 Prometheus 文本文件
+ *
+ * The file is written next to the target and renamed over it, so a scraper such as the node_exporter textfile
+ * collector never reads a half-written file. A last snapshot is written on destruction.
+ * 先写入目标旁边的临时文件再重命名覆盖，node_exporter textfile collector 等读取方不会读到写了一半的文件。
+ * 析构时再写入最后一次快照。
+ */
+class MetricsExporter {
+public:
+    MetricsExporter(MetricsRegistry &registry, std::filesystem::path path,
+                    std::chrono::milliseconds interval = std::chrono::seconds(15))
+        : registry_(registry), path_(std::move(path)), interval_(interval), worker_([this] { run(); }) {}
+
+    ~MetricsExporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+    }
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+    // 立即写出一次，成功返回 true
+    bool write() {
+        std::string text = registry_.prometheus_text();
+        std::filesystem::path temporary = path_;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.write(text.data(), (std::streamsize)text.size())) {
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path_, error);
+        return !error;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            cv_.wait_for(lock, interval_, [this] { return stopping_; });
+            lock.unlock();
+            write();
+            lock.lock();
+        }
+    }
+
+    MetricsRegistry &registry_;
+    const std::filesystem::path path_;
+    const std::chrono::milliseconds interval_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+
+    std::thread worker_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+
+/**
+ * @brief Link field of an element of MpscQueue, embed it by deriving from it
+ *        MpscQueue 元素的链接字段，元素类型通过继承它嵌入
+ */
+struct MpscNode {
+    std::atomic<MpscNode *> next = nullptr;
+};
+
+/**
+ * @brief Unbounded lock-free intrusive multi-producer/single-consumer queue (Vyukov)
+ *        无界无锁侵入式多生产者/单消费者队列（Vyukov 算法）
+ *
+ * Elements derive from MpscNode and are linked in place, so the queue never allocates; the caller owns them and
+ * keeps them alive while queued. An element can only be in one queue at a time. push() is one atomic exchange plus
+ * one store and never waits for other producers or the consumer. try_pop() must only be called from one consumer
+ * thread. A producer preempted between its exchange and its store briefly hides the elements behind it, so
+ * try_pop() may return nullptr while the queue is not empty; the consumer simply tries again after the producer's
+ * wake-up signal.
+ * 元素继承 MpscNode 并在原处链接，队列本身从不分配内存；元素由调用方持有，排队期间须保持有效，同一时刻只能位于
+ * 一个队列中。push() 只是一次原子交换加一次写入，不会等待其他生产者或消费者。try_pop() 只能由唯一的消费者线程
+ * 调用。生产者若在交换与写入之间被抢占，其后的元素会暂时不可见，此时 try_pop() 可能在队列非空时返回 nullptr，
+ * 消费者在收到该生产者的唤醒信号后再次读取即可。
+ */
+template <typename T> class MpscQueue {
+public:
+    MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // 任意线程调用
+    void push(T *item) { link(item); }
+
+    // 仅消费者线程调用，队列为空（或最新的元素尚未链接完成）时返回 nullptr
+    T *try_pop() {
+        MpscNode *tail = tail_;
+        MpscNode *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &stub_) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail_ = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<T *>(tail);
+        }
+        // tail 是最后一个元素：重新放入哨兵节点，使 tail 有后继后才能取出
+        if (tail != head_.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        link(&stub_);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail_ = next;
+            return static_cast<T *>(tail);
+        }
+        return nullptr;
+    }
+
+private:
+    void link(MpscNode *node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MpscNode *previous = head_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    MpscNode stub_;
+    // 生产者与消费者各自访问的指针放在不同缓存行
+    alignas(64) std::atomic<MpscNode *> head_;
+    alignas(64) MpscNode *tail_;
+};
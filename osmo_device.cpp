@@ -0,0 +1,259 @@
+#include "osmo_device.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+namespace {
+
+[[maybe_unused]] std::string to_hex(const uint8_t *data, size_t length) {
+    std::string hex(length * 2, '0');
+    for (size_t i = 0; i < length; i++) {
+        std::snprintf(&hex[i * 2], 3, "%02x", data[i]);
+    }
+    return hex;
+}
+
+} // namespace
+
+Task<bool> OsmoDevice::connect() {
+    connect_status_ = 1;
+
+    // 相机在应答连接请求后会主动发起连接请求，verify_mode 为 2；先开始等待，避免它在等待前到达
+    auto camera_request = expect<connection_request_command_frame>(
+        default_timeout, [](const MessageView<connection_request_command_frame> &view) {
+            return OSMO_FIELD(view, verify_mode) == 2;
+        });
+
+    // 构造连接请求
+    uint8_t verify_mode = 0;
+    // 随机验证数据
+    verify_data_ = (uint16_t)(rand() % 10000);
+    connection_request_command_frame connection_request = {
+        .device_id = 0xFF33,
+        .mac_addr_len = (uint8_t)adapter_mac_.size(),
+        .fw_version = 0,
+        .verify_mode = verify_mode,
+        .verify_data = verify_data_,
+    };
+    std::memcpy(connection_request.mac_addr, adapter_mac_.data(), adapter_mac_.size());
+
+    auto response = co_await send(connection_request);
+    if (!response) {
+        ESP_LOGE("OSMO", "Failed to send connection request");
+        connect_status_ = -1;
+        co_return false;
+    }
+    if (response->device_id != 0xFF44 || response->ret_code != 0) {
+        ESP_LOGE("OSMO", "Failed to connect to device");
+        connect_status_ = -1;
+        co_return false;
+    }
+
+    // 等待相机发来连接消息
+    FrameView frame = co_await camera_request;
+    if (!frame) {
+        ESP_LOGE("OSMO", "Timed out waiting for connection request from camera");
+        connect_status_ = -1;
+        co_return false;
+    }
+    auto camera_connection = view_as<connection_request_command_frame>(frame);
+    ESP_LOGI("OSMO", "Connection request from: 0x%04x", (unsigned)OSMO_FIELD(*camera_connection, device_id));
+
+    // 最后一步，使用相机请求的 SEQ 发送返回消息
+    connection_request_response_frame connection_response = {.device_id = 0xFF33, .ret_code = 0};
+    memset(connection_response.reserved, 0, sizeof(connection_response.reserved));
+
+    send_async(0x00, 0x19, ACK_NO_RESPONSE, &connection_response, frame.seq(), default_timeout, nullptr);
+    connect_status_ = 2;
+    co_return true;
+}
+
+void OsmoDevice::parse_mac(std::string mac) {
+    // six hex digits, separated by colons, e.g. "00:11:22:33:44:55"
+    std::stringstream ss(mac);
+    std::string token;
+    std::array<int8_t, 6> mac_bytes;
+    int i = 0;
+    while (std::getline(ss, token, ':')) {
+        mac_bytes[i] = std::stoi(token, nullptr, 16);
+        i++;
+    }
+    adapter_mac_ = mac_bytes;
+}
+
+
+void OsmoDevice::reader_loop() {
+    while (running_) {
+        // 等待新帧，最迟在最近的截止时间醒来处理超时，之后登记的更早截止时间会提前唤醒；空闲时也定期醒来，
+        // 避免等待过远的时间点
+        auto deadline = std::min(pending_.next_deadline(), PendingRequests::Clock::now() + std::chrono::seconds(1));
+        if (rx_ring_.wait_until(deadline)) {
+            // 一次取完已到达的帧；拷贝到池化缓冲区的工作由读取线程完成，之后的消费者都只持有视图
+            while (const SpscFrameRing::Slot *slot = rx_ring_.front()) {
+                FrameView view(rx_pool_.acquire(slot->data(), slot->size(), slot->timestamp()));
+                rx_ring_.pop();
+                if (!view) {
+                    continue;
+                }
+                metrics_.frame_received(view.cmd_set(), view.cmd_id());
+                // dispatch：帧重组完成至匹配到请求（含结果交付）或确定交给订阅者
+                bool claimed = pending_.complete(view) || pending_.offer(view);
+                OSMO_TRACE_RECORD("dispatch", trace_device_, view.seq(), view.received_at(),
+                                  TraceRecorder::Clock::now());
+                if (!claimed) {
+                    dispatcher_.post(std::move(view));
+                }
+            }
+        }
+        pending_.expire(PendingRequests::Clock::now());
+    }
+}
+
+bool OsmoDevice::send_async(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint16_t seq,
+                            std::chrono::milliseconds timeout, PendingRequests::Callback callback) {
+    // 直接编码到栈上缓冲区，避免每次发送的堆分配
+    uint8_t frame[PROTOCOL_MAX_FRAME_LENGTH];
+    size_t frame_length = 0;
+    OSMO_TRACE_BEGIN(encode_begin);
+    if (protocol_encode_frame_into(frame, sizeof(frame), cmd_set, cmd_id, cmd_type, structure, seq, &frame_length) !=
+        0) {
+        frame_length = 0;
+    }
+    OSMO_TRACE_END("encode", trace_device_, seq, encode_begin);
+    if (frame_length == 0) {
+        ESP_LOGE("OSMO", "Failed to create frame");
+        return false;
+    }
+
+    return write_frame(frame, frame_length, cmd_set, cmd_id, cmd_type, seq, timeout, std::move(callback));
+}
+
+bool OsmoDevice::send_frame_async(const uint8_t *frame, size_t frame_length, uint16_t seq,
+                                  std::chrono::milliseconds timeout, PendingRequests::Callback callback) {
+    // 有效载荷与 CRC 覆盖范围都不变，改写 SEQ 的开销与帧长无关
+    uint8_t stamped[PROTOCOL_MAX_FRAME_LENGTH];
+    OSMO_TRACE_BEGIN(encode_begin);
+    bool valid = frame != nullptr && frame_length >= PROTOCOL_MIN_FRAME_LENGTH && frame_length <= sizeof(stamped);
+    if (valid) {
+        std::memcpy(stamped, frame, frame_length);
+        valid = protocol_frame_set_seq(stamped, frame_length, seq) == 0;
+    }
+    OSMO_TRACE_END("encode", trace_device_, seq, encode_begin);
+    if (!valid) {
+        ESP_LOGE("OSMO", "Not an encoded frame");
+        return false;
+    }
+
+    return write_frame(stamped, frame_length, stamped[PROTOCOL_HEADER_LENGTH - 2], stamped[PROTOCOL_HEADER_LENGTH - 1],
+                       stamped[3], seq, timeout, std::move(callback));
+}
+
+bool OsmoDevice::write_frame(const uint8_t *frame, size_t frame_length, uint8_t cmd_set, uint8_t cmd_id,
+                             uint8_t cmd_type, uint16_t seq, std::chrono::milliseconds timeout,
+                             PendingRequests::Callback callback) {
+    // 先登记再发送，避免应答先于登记到达；结果经由 deliver() 记录指标，回调无需再包装一层
+    bool wait_response = expects_response(cmd_type) && callback;
+    if (wait_response &&
+        !pending_.add(seq, cmd_set, cmd_id, PendingRequests::Clock::now() + timeout, std::move(callback))) {
+        ESP_LOGW("OSMO", "seq %u is still in flight", (unsigned)seq);
+        return false;
+    }
+
+    // 交给写线程发送，写出失败时让等待中的请求立即以空视图完成而不是等到超时
+    BleWriter::DoneCallback done;
+    if (wait_response) {
+        done = [this, seq](bool written) {
+            if (!written) {
+                pending_.fail(seq);
+            }
+        };
+    }
+    metrics_.command_sent(cmd_set, cmd_id);
+    writer_.submit(frame, frame_length, priority_for(cmd_set, cmd_id), std::move(done));
+    return true;
+}
+
+void OsmoDevice::deliver(PendingRequests::Result &result, FrameView response) {
+    if (response) {
+        metrics_.command_completed(result.cmd_set, result.cmd_id, DeviceMetrics::Clock::now() - result.added);
+    } else {
+        metrics_.command_failed(result.cmd_set, result.cmd_id);
+    }
+    OSMO_TRACE_SCOPE("deliver", trace_device_, result.seq);
+    result.callback(std::move(response));
+}
+
+void OsmoDevice::write_to_device(const uint8_t *frame, size_t frame_length) {
+    // 默认日志级别下不会生成 to_hex() 的调用
+    ESP_LOGD("OSMO", "Sending command: %s", to_hex(frame, frame_length).c_str());
+    if (CaptureWriter *capture = capture_.load(std::memory_order_acquire)) {
+        capture->record(CaptureType::Write, capture_device_.load(std::memory_order_relaxed), frame, frame_length);
+    }
+    try {
+        transport_->write(frame, frame_length);
+    } catch (const std::exception &e) {
+        ESP_LOGE("OSMO", "Failed to send command: %s", e.what());
+        throw;
+    }
+}
+
+AsyncValue<FrameView> OsmoDevice::request(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure,
+                                          std::chrono::milliseconds timeout) {
+    AsyncValue<FrameView> response(loop_);
+    if (!send_async(cmd_set, cmd_id, cmd_type, structure, get_seq(), timeout, response.completer()) ||
+        !expects_response(cmd_type)) {
+        response.completer()(FrameView());
+    }
+    return response;
+}
+
+AsyncValue<FrameView> OsmoDevice::request_frame(const uint8_t *frame, size_t frame_length,
+                                                std::chrono::milliseconds timeout) {
+    AsyncValue<FrameView> response(loop_);
+    if (!send_frame_async(frame, frame_length, get_seq(), timeout, response.completer()) ||
+        !expects_response(frame[3])) {
+        response.completer()(FrameView());
+    }
+    return response;
+}
+
+std::future<FrameView> OsmoDevice::send_request(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type,
+                                                const void *structure, uint16_t seq,
+                                                std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<std::promise<FrameView>>();
+    std::future<FrameView> future = promise->get_future();
+
+    bool sent = send_async(cmd_set, cmd_id, cmd_type, structure, seq, timeout,
+                           [promise](FrameView response) { promise->set_value(std::move(response)); });
+    if (!sent || !expects_response(cmd_type)) {
+        promise->set_value(FrameView());
+    }
+    return future;
+}
+
+CommandResult OsmoDevice::send_command(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure,
+                                       uint16_t seq, std::chrono::milliseconds timeout) {
+    FrameView response = send_request(cmd_set, cmd_id, cmd_type, structure, seq, timeout).get();
+    if (!response) {
+        if ((cmd_type & 0x03) == CMD_WAIT_RESULT) {
+            ESP_LOGW("OSMO", "No response for seq %u", (unsigned)seq);
+        }
+        return CommandResult();
+    }
+
+    // 本次命令中 dji 库的分配（应答结构体）都来自本设备的缓冲池
+    SlabPool::Scope pool_scope(payload_pool_);
+    OSMO_TRACE_SCOPE("parse", trace_device_, seq);
+
+    protocol_frame_t frame = response.frame();
+    size_t structure_data_length = 0;
+    void *structure_data = protocol_parse_data(frame.data, frame.data_length, frame.cmd_type, &structure_data_length);
+    if (structure_data == nullptr) {
+        metrics_.parse_failed(response.cmd_set(), response.cmd_id());
+        ESP_LOGE("OSMO", "Failed to parse data");
+        return CommandResult();
+    }
+    return CommandResult(structure_data, structure_data_length);
+}
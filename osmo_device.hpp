@@ -0,0 +1,492 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "dji/dji_log.h"
+#include "dji/dji_protocol_data_structures.h"
+#include "dji/dji_protocol_parser.h"
+#include "dji/dji_protocol_stream.h"
+#include "ble_writer.hpp"
+#include "capture.hpp"
+#include "dji/enums_logic.h"
+#include "dispatcher.hpp"
+#include "event_loop.hpp"
+#include "frame_cache.hpp"
+#include "frame_view.hpp"
+#include "pending_requests.hpp"
+#include "slab_pool.hpp"
+#include "spsc_frame_ring.hpp"
+#include "static_frame.hpp"
+#include "message_registry.hpp"
+#include "metrics.hpp"
+#include "trace.hpp"
+#include "transport.hpp"
+
+// 持有解析出的结构体，析构时归还到分配它的缓冲池
+class CommandResult {
+public:
+    CommandResult() = default;
+    CommandResult(void *structure, size_t length) : structure_(structure), length_(length) {}
+    CommandResult(CommandResult &&other) noexcept
+        : structure_(std::exchange(other.structure_, nullptr)), length_(std::exchange(other.length_, 0)) {}
+    CommandResult &operator=(CommandResult &&other) noexcept {
+        if (this != &other) {
+            dji_free(structure_);
+            structure_ = std::exchange(other.structure_, nullptr);
+            length_ = std::exchange(other.length_, 0);
+        }
+        return *this;
+    }
+    ~CommandResult() { dji_free(structure_); }
+
+    CommandResult(const CommandResult &) = delete;
+    CommandResult &operator=(const CommandResult &) = delete;
+
+    explicit operator bool() const { return structure_ != nullptr; }
+
+    // 结构体内存长度，不包含 CmdSet 和 CmdId
+    size_t length() const { return length_; }
+
+    template <typename T> const T *as() const {
+        return length_ >= sizeof(T) ? static_cast<const T *>(structure_) : nullptr;
+    }
+
+private:
+    void *structure_ = nullptr;
+    size_t length_ = 0;
+};
+
+/**
+ * @brief Metrics of one device, all labelled with its address
+ *        单台设备的指标，均带有设备地址标签
+ *
+ * Per-command metrics are indexed by (cmd_set << 8) | cmd_id and labelled with both. Hot paths update them directly;
+ * collect() runs before every export and turns the statistics the queues already keep into metrics.
+ * 按命令细分的指标以 (cmd_set << 8) | cmd_id 索引，并带有这两个标签。热路径直接更新指标；collect() 在每次导出前
+ * 运行，将各队列已有的统计转换为指标。
+ */
+class DeviceMetrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    DeviceMetrics(MetricsRegistry &registry, std::string device)
+        : registry_(registry), device_(std::move(device)),
+          frames_received_(keyed_counter("osmo_frames_received_total", "Frames received from the camera")),
+          commands_sent_(keyed_counter("osmo_commands_sent_total", "Commands queued for writing")),
+          command_failures_(keyed_counter("osmo_command_failures_total",
+                                          "Commands that timed out or failed to write before a response arrived")),
+          parse_failures_(keyed_counter("osmo_parse_failures_total", "Response payloads that failed to parse")),
+          round_trip_(
+              keyed_histogram("osmo_command_round_trip_seconds", "Time from queueing a command to its response")),
+          dispatch_delay_(keyed_histogram("osmo_dispatch_delay_seconds",
+                                          "Time from receiving a pushed frame to running its subscriber")),
+          rx_discarded_bytes_(registry.counter("osmo_rx_discarded_bytes_total",
+                                               "Bytes skipped while searching for a frame start", labels())),
+          rx_depth_(registry.gauge("osmo_rx_queue_depth", "Frames waiting in the notify ring", labels())),
+          rx_high_water_(registry.gauge("osmo_rx_queue_high_water", "Most frames ever waiting in the notify ring",
+                                        labels())),
+          rx_overflows_(registry.counter("osmo_rx_queue_overflows_total", "Frames dropped by the full notify ring",
+                                         labels())),
+          in_flight_(registry.gauge("osmo_requests_in_flight", "Commands waiting for a response", labels())),
+          dispatch_dropped_(registry.counter("osmo_dispatch_dropped_total",
+                                             "Pushed frames dropped by the full dispatcher queue", labels())),
+          dispatch_unhandled_(registry.counter("osmo_dispatch_unhandled_total", "Pushed frames without a subscriber",
+                                               labels())),
+          tx_bytes_(registry.counter("osmo_tx_bytes_total", "Bytes written to the camera", labels())),
+          tx_writes_(registry.counter("osmo_tx_writes_total", "write_command calls, including fragments", labels())),
+          tx_failures_(registry.counter("osmo_tx_failures_total", "Frames that failed to write or were dropped",
+                                        labels())) {
+        const char *reasons[] = {"length", "crc16", "crc32"};
+        for (size_t i = 0; i < frame_errors_.size(); i++) {
+            frame_errors_[i] = &registry.counter("osmo_rx_frame_errors_total", "Frames rejected by the stream decoder",
+                                                 labels({{"reason", reasons[i]}}));
+        }
+    }
+
+    DeviceMetrics(const DeviceMetrics &) = delete;
+    DeviceMetrics &operator=(const DeviceMetrics &) = delete;
+
+    void frame_received(uint8_t cmd_set, uint8_t cmd_id) { frames_received_[key(cmd_set, cmd_id)].inc(); }
+    void command_sent(uint8_t cmd_set, uint8_t cmd_id) { commands_sent_[key(cmd_set, cmd_id)].inc(); }
+    void command_completed(uint8_t cmd_set, uint8_t cmd_id, Clock::duration round_trip) {
+        round_trip_[key(cmd_set, cmd_id)].observe(round_trip);
+    }
+    void command_failed(uint8_t cmd_set, uint8_t cmd_id) { command_failures_[key(cmd_set, cmd_id)].inc(); }
+    void parse_failed(uint8_t cmd_set, uint8_t cmd_id) { parse_failures_[key(cmd_set, cmd_id)].inc(); }
+    void dispatched(uint8_t cmd_set, uint8_t cmd_id, Clock::duration delay) {
+        dispatch_delay_[key(cmd_set, cmd_id)].observe(delay);
+    }
+
+    // 仅在 BLE 通知回调线程上调用，将流式解码器的错误计数增量计入指标
+    void publish(const protocol_stream_stats_t &stream) {
+        advance(*frame_errors_[0], stream.length_errors, stream_.length_errors);
+        advance(*frame_errors_[1], stream.crc16_errors, stream_.crc16_errors);
+        advance(*frame_errors_[2], stream.crc32_errors, stream_.crc32_errors);
+        advance(rx_discarded_bytes_, stream.bytes_discarded, stream_.bytes_discarded);
+    }
+
+    // 由注册表在导出前调用
+    void collect(const SpscFrameRing::Stats &ring, const Dispatcher::Stats &dispatcher, const BleWriter::Stats &writer,
+                 size_t pending) {
+        rx_depth_.set((int64_t)ring.depth);
+        rx_high_water_.set((int64_t)ring.high_water);
+        advance(rx_overflows_, ring.overflows, collected_.rx_overflows);
+        in_flight_.set((int64_t)pending);
+        advance(dispatch_dropped_, dispatcher.dropped, collected_.dispatch_dropped);
+        advance(dispatch_unhandled_, dispatcher.unhandled, collected_.dispatch_unhandled);
+        advance(tx_bytes_, writer.link.bytes, collected_.tx_bytes);
+        advance(tx_writes_, writer.link.writes, collected_.tx_writes);
+        advance(tx_failures_, writer.failed, collected_.tx_failures);
+    }
+
+private:
+    static uint16_t key(uint8_t cmd_set, uint8_t cmd_id) { return (uint16_t)((cmd_set << 8) | cmd_id); }
+
+    MetricsRegistry::Labels labels(MetricsRegistry::Labels extra = {}) const {
+        MetricsRegistry::Labels result = {{"device", device_}};
+        result.insert(result.end(), extra.begin(), extra.end());
+        return result;
+    }
+
+    MetricsRegistry::Labels command_labels(uint16_t key) const {
+        char cmd_set[8];
+        char cmd_id[8];
+        std::snprintf(cmd_set, sizeof(cmd_set), "0x%02X", key >> 8);
+        std::snprintf(cmd_id, sizeof(cmd_id), "0x%02X", key & 0xFF);
+        return labels({{"cmd_set", cmd_set}, {"cmd_id", cmd_id}});
+    }
+
+    KeyedMetrics<Counter>::Factory keyed_counter(std::string name, std::string help) {
+        return [this, name = std::move(name), help = std::move(help)](uint16_t key) -> Counter & {
+            return registry_.counter(name, help, command_labels(key));
+        };
+    }
+
+    KeyedMetrics<Histogram>::Factory keyed_histogram(std::string name, std::string help) {
+        return [this, name = std::move(name), help = std::move(help)](uint16_t key) -> Histogram & {
+            return registry_.histogram(name, help, command_labels(key));
+        };
+    }
+
+    // 将累计值 total 相对上次的增量计入计数器
+    static void advance(Counter &counter, uint64_t total, uint64_t &last) {
+        if (total > last) {
+            counter.inc(total - last);
+        }
+        last = total;
+    }
+
+    MetricsRegistry &registry_;
+    const std::string device_;
+
+    KeyedMetrics<Counter> frames_received_;
+    KeyedMetrics<Counter> commands_sent_;
+    KeyedMetrics<Counter> command_failures_;
+    KeyedMetrics<Counter> parse_failures_;
+    KeyedMetrics<Histogram> round_trip_;
+    KeyedMetrics<Histogram> dispatch_delay_;
+
+    Counter &rx_discarded_bytes_;
+    Gauge &rx_depth_;
+    Gauge &rx_high_water_;
+    Counter &rx_overflows_;
+    Gauge &in_flight_;
+    Counter &dispatch_dropped_;
+    Counter &dispatch_unhandled_;
+    Counter &tx_bytes_;
+    Counter &tx_writes_;
+    Counter &tx_failures_;
+    std::array<Counter *, 3> frame_errors_{};
+
+    // 上次计入的累计值；stream_ 仅在 BLE 回调线程上访问，collected_ 仅在导出时访问
+    protocol_stream_stats_t stream_{};
+    struct {
+        uint64_t rx_overflows = 0;
+        uint64_t dispatch_dropped = 0;
+        uint64_t dispatch_unhandled = 0;
+        uint64_t tx_bytes = 0;
+        uint64_t tx_writes = 0;
+        uint64_t tx_failures = 0;
+    } collected_;
+};
+
+class OsmoDevice {
+public:
+    // transport 由设备持有，在构造时连接；mac 为本机蓝牙适配器地址，用于连接请求
+    OsmoDevice(std::string mac, std::unique_ptr<Transport> transport,
+               MetricsRegistry &metrics = MetricsRegistry::global())
+        : registry_(metrics), metrics_(metrics, transport->address()),
+          trace_device_(OSMO_TRACE_DEVICE(transport->address())) {
+        parse_mac(mac);
+        protocol_stream_init(&stream_);
+        // 在 dji 库第一次分配之前设置分配钩子
+        SlabPool::install_hooks();
+
+        transport_ = std::move(transport);
+        transport_->connect();
+        writer_.set_mtu(transport_->mtu());
+        writer_.set_trace_device(trace_device_);
+
+        // 读取线程需在订阅之前启动，保证第一帧到达时已有消费者
+        reader_ = std::thread([this] { reader_loop(); });
+        transport_->subscribe([this](const uint8_t *data, size_t length) { osmo_notify_callback(data, length); });
+
+        collector_ = registry_.add_collector([this] {
+            metrics_.collect(rx_ring_.stats(), dispatcher_.stats(), writer_.stats(), pending_.in_flight());
+        });
+    }
+    ~OsmoDevice() {
+        registry_.remove_collector(collector_);
+        // 先停止写线程，排队中的命令以失败完成
+        writer_.stop();
+        if (transport_->is_connected()) {
+            transport_->disconnect();
+        }
+
+        // 关闭环形缓冲区唤醒读取线程
+        running_ = false;
+        rx_ring_.close();
+        reader_.join();
+        pending_.cancel_all();
+        dispatcher_.stop();
+    }
+
+    uint16_t get_seq() {
+        // 多个协程或线程可能同时发送，读取与自增必须是一次原子操作
+        return seq_.fetch_add(1);
+    }
+
+    // 设置后协程接口在该事件循环线程上恢复，否则在 BLE 读取线程上恢复
+    void set_event_loop(EventLoop *loop) { loop_ = loop; }
+
+    // 开始把本设备收到的原始通知与写出的原始数据记录到 capture，传入 nullptr 停止；capture 需比设备活得更久
+    void set_capture(CaptureWriter *capture) {
+        if (capture != nullptr) {
+            capture_device_.store(capture->device(transport_->address()), std::memory_order_relaxed);
+        }
+        capture_.store(capture, std::memory_order_release);
+    }
+
+    SlabPool::Stats payload_pool_stats() const { return payload_pool_.stats(); }
+
+    // 阻塞等待 connect() 完成；不能在驱动本设备协程的事件循环线程上调用
+    void request_connect() { sync_wait(connect()); }
+
+    // 完成连接握手，成功返回 true
+    Task<bool> connect();
+
+    // 立即发送命令并返回可等待的应答帧，超时或无需应答时得到空视图
+    AsyncValue<FrameView> request(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure,
+                                  std::chrono::milliseconds timeout = default_timeout);
+
+    // 立即发送已编码的帧并返回可等待的应答帧，例如 FrameTemplateCache 的模板或 make_static_frame 的结果；
+    // SEQ 由设备分配，在副本上改写
+    AsyncValue<FrameView> request_frame(const uint8_t *frame, size_t frame_length,
+                                        std::chrono::milliseconds timeout = default_timeout);
+
+    // 发送已在 OsmoMessages 中注册的命令结构体并等待类型化的应答，例如 co_await dev.send(record_control)
+    template <typename T, typename Response = response_of_t<T>>
+        requires(!std::is_void_v<Response> && !std::is_same_v<T, Response>)
+    Task<std::optional<Response>> send(T payload, uint8_t cmd_type = CMD_WAIT_RESULT,
+                                       std::chrono::milliseconds timeout = default_timeout) {
+        using M = message_of_t<T>;
+        uint16_t seq = get_seq();
+        uint8_t frame[PROTOCOL_FULL_FRAME_LENGTH(sizeof(T))];
+        OSMO_TRACE_BEGIN(encode_begin);
+        size_t frame_length = encode_message<M>(payload, cmd_type, seq, frame, sizeof(frame));
+        OSMO_TRACE_END("encode", trace_device_, seq, encode_begin);
+
+        AsyncValue<FrameView> response(loop_);
+        if (frame_length == 0 || !write_frame(frame, frame_length, M::cmd_set, M::cmd_id, cmd_type, seq, timeout,
+                                              response.completer())) {
+            co_return std::nullopt;
+        }
+
+        auto view = view_as<Response>(co_await response);
+        if (!view) {
+            co_return std::nullopt;
+        }
+        co_return view->copy();
+    }
+
+    // 开始等待下一个满足 match 的 T 类型主动上报帧；先于触发它的命令调用，可避免该帧在等待前到达而被错过
+    template <typename T>
+    AsyncValue<FrameView> expect(
+        std::chrono::milliseconds timeout = default_timeout,
+        std::function<bool(const MessageView<T> &)> match = [](const MessageView<T> &) { return true; }) {
+        AsyncValue<FrameView> frame(loop_);
+        pending_.expect(
+            [match = std::move(match)](const FrameView &candidate) {
+                auto view = view_as<T>(candidate);
+                return view && match(*view);
+            },
+            PendingRequests::Clock::now() + timeout, frame.completer());
+        return frame;
+    }
+
+    // 持续接收 T 类型的主动上报帧，handler 在分发线程上以 MessageView<T> 调用，例如相机状态推送与按键上报
+    template <typename T, typename F> Dispatcher::Token subscribe(F handler) {
+        return dispatcher_.template subscribe<T>([this, handler = std::move(handler)](const MessageView<T> &view) {
+            const FrameView &frame = view.frame();
+            metrics_.dispatched(frame.cmd_set(), frame.cmd_id(), DeviceMetrics::Clock::now() - frame.received_at());
+            OSMO_TRACE_SCOPE("deliver", trace_device_, frame.seq());
+            handler(view);
+        });
+    }
+    bool unsubscribe(Dispatcher::Token token) { return dispatcher_.unsubscribe(token); }
+
+    Dispatcher::Stats dispatcher_stats() const { return dispatcher_.stats(); }
+    BleWriter::Stats writer_stats() const { return writer_.stats(); }
+
+    // 等待下一个 T 类型的主动上报帧，例如 co_await dev.next<camera_status_push_command_frame>()
+    template <typename T>
+    Task<std::optional<MessageView<T>>> next(std::chrono::milliseconds timeout = default_timeout) {
+        FrameView frame = co_await expect<T>(timeout);
+        if (!frame) {
+            co_return std::nullopt;
+        }
+        co_return view_as<T>(frame);
+    }
+    void parse_mac(std::string mac);
+    CommandResult send_command(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint16_t seq,
+                               std::chrono::milliseconds timeout = default_timeout);
+
+    // 发送命令但不等待；需要应答的命令在收到应答、超时或写出失败后调用 callback，后两种情况参数为空视图
+    // 返回 false 表示命令未能编码或排队，此时 callback 不会被调用
+    bool send_async(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure, uint16_t seq,
+                    std::chrono::milliseconds timeout, PendingRequests::Callback callback);
+
+    // 与 send_async 相同，但发送已编码的帧：拷贝后只改写 SEQ 与两个校验值，命令字与帧类型从帧头读取
+    bool send_frame_async(const uint8_t *frame, size_t frame_length, uint16_t seq, std::chrono::milliseconds timeout,
+                          PendingRequests::Callback callback);
+
+    // 发送命令并返回应答帧的 future，超时、无需应答或发送失败时得到空视图
+    std::future<FrameView> send_request(uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type, const void *structure,
+                                        uint16_t seq, std::chrono::milliseconds timeout = default_timeout);
+
+    void osmo_notify_callback(const uint8_t *data, size_t length) {
+        if (CaptureWriter *capture = capture_.load(std::memory_order_acquire)) {
+            capture->record(CaptureType::Notify, capture_device_.load(std::memory_order_relaxed), data, length);
+        }
+#ifdef OSMO_ENABLE_TRACE
+        notify_trace_.arrived = TraceRecorder::Clock::now();
+        notify_trace_.verify_from = notify_trace_.arrived;
+        // 解码器中没有残留字节时，本次通知携带下一帧的第一个字节
+        if (stream_.head == stream_.tail) {
+            notify_trace_.first_byte = notify_trace_.arrived;
+        }
+#endif
+        // 一个通知可能只包含半帧，也可能包含多帧，交给流式解码器重组后逐帧入队
+        protocol_stream_push(
+            &stream_, data, length,
+            [](const protocol_frame_t *frame, const uint8_t *frame_bytes, void *user_data) {
+                OsmoDevice *self = static_cast<OsmoDevice *>(user_data);
+#ifdef OSMO_ENABLE_TRACE
+                // notify：帧的第一个通知到达至最后一个通知到达；verify：搜索帧头与两次 CRC 校验
+                NotifyTrace &trace = self->notify_trace_;
+                TraceRecorder::Clock::time_point verified = TraceRecorder::Clock::now();
+                OSMO_TRACE_RECORD("notify", self->trace_device_, frame->seq, trace.first_byte, trace.arrived);
+                OSMO_TRACE_RECORD("verify", self->trace_device_, frame->seq, trace.verify_from, verified);
+                trace.first_byte = trace.arrived;
+                trace.verify_from = verified;
+#endif
+                // 帧字节只在回调期间有效；回调线程只做一次拷贝到环形缓冲区，不加锁也不分配内存
+                self->rx_ring_.push(frame_bytes, frame->frame_length);
+            },
+            this);
+        metrics_.publish(stream_.stats);
+    }
+
+private:
+    static constexpr std::chrono::milliseconds default_timeout = std::chrono::seconds(5);
+
+    static bool expects_response(uint8_t cmd_type) { return (cmd_type & 0x03) != 0; }
+
+    void reader_loop();
+    // 在写线程上调用，失败时抛出异常
+    void write_to_device(const uint8_t *frame, size_t frame_length);
+
+    // 记录请求的往返时间或失败，再以应答调用其回调
+    void deliver(PendingRequests::Result &result, FrameView response);
+
+    // 登记等待项（如需应答）后将已编码的帧交给写线程
+    bool write_frame(const uint8_t *frame, size_t frame_length, uint8_t cmd_set, uint8_t cmd_id, uint8_t cmd_type,
+                     uint16_t seq, std::chrono::milliseconds timeout, PendingRequests::Callback callback);
+
+    // 拍录控制与按键上报对延迟敏感，GPS 推送是周期性的后台流量，新值取代旧值；状态订阅只发送一次，
+    // 不能被后续帧挤掉，与其他命令一样属于 Normal
+    static BleWriter::Priority priority_for(uint8_t cmd_set, uint8_t cmd_id) {
+        if ((cmd_set == 0x1D && cmd_id == 0x03) || (cmd_set == 0x00 && cmd_id == 0x11)) {
+            return BleWriter::Priority::Control;
+        }
+        if (cmd_set == 0x00 && cmd_id == 0x17) {
+            return BleWriter::Priority::Telemetry;
+        }
+        return BleWriter::Priority::Normal;
+    }
+
+#ifdef OSMO_ENABLE_TRACE
+    // 仅在 BLE 通知回调线程中访问，用于划分每帧的 notify 与 verify 区间
+    struct NotifyTrace {
+        TraceRecorder::Clock::time_point arrived;
+        TraceRecorder::Clock::time_point first_byte;
+        TraceRecorder::Clock::time_point verify_from;
+    };
+    NotifyTrace notify_trace_;
+#endif
+
+    // 需先于其他成员构造、晚于其析构；调用方持有的 CommandResult 不能比设备活得更久
+    SlabPool payload_pool_;
+    // 各线程都会更新指标，需先于这些线程启动、晚于其停止
+    MetricsRegistry &registry_;
+    DeviceMetrics metrics_;
+    size_t collector_ = 0;
+    // 跟踪区间所属的设备编号，未启用跟踪时为 0
+    const uint32_t trace_device_;
+    // 未设置抓包时为 nullptr，通知回调与写线程只多一次原子读
+    std::atomic<CaptureWriter *> capture_ = nullptr;
+    std::atomic<uint32_t> capture_device_ = 0;
+
+    std::array<int8_t, 6> adapter_mac_;
+
+    std::atomic<uint16_t> seq_ = 1;
+    // 仅在 BLE 通知回调线程中访问
+    protocol_stream_t stream_;
+    // BLE 回调线程写入、读取线程读出的已重组帧
+    SpscFrameRing rx_ring_;
+    // 需先于持有视图的成员构造、晚于其析构，保证视图释放时缓冲池仍然存在
+    RxBufferPool rx_pool_;
+    // 不属于任何在途请求与等待项的帧，例如状态推送和按键上报，在独立线程上交给订阅者
+    Dispatcher dispatcher_;
+    // 登记了更早的截止时间时唤醒读取线程
+    PendingRequests pending_{[this] { rx_ring_.wake(); },
+                             [this](PendingRequests::Result &result, FrameView response) {
+                                 deliver(result, std::move(response));
+                             }};
+    // 所有线程的命令都经由它按提交顺序写出，只有它的线程调用 write_command
+    BleWriter writer_{[this](const uint8_t *frame, size_t frame_length) { write_to_device(frame, frame_length); }};
+    std::atomic<bool> running_ = true;
+    std::thread reader_;
+    EventLoop *loop_ = nullptr;
+
+    /**
+     * @brief 链接状态信息
+     * 0 - 未链接
+     * 1 - 链接中
+     * 2 - 链接成功
+     * -1 - 链接失败
+     */
+    std::atomic<uint32_t> connect_status_ = 0;
+    uint16_t verify_data_ = 0;
+
+    std::unique_ptr<Transport> transport_;
+};
@@ -0,0 +1,292 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "frame_view.hpp"
+
+/**
+ * @brief Table of commands waiting for their response, indexed by SEQ
+ *        以 SEQ 为索引的待应答命令表
+ *
+ * A single reader feeds every received frame to complete(). A response matches when its SEQ, CmdSet and CmdId
+ * equal those of a registered request and the response bit is set; anything else is left to the caller as an
+ * unsolicited frame. Callbacks run outside the table lock, normally on the reader thread, and receive an empty
+ * FrameView when the deadline passes, the request fails to be written or the table is cancelled.
+ * 由单一读取线程将每个接收到的帧交给 complete()。当 SEQ、CmdSet、CmdId 与已登记的请求一致且为应答帧时匹配成功，
+ * 其余帧作为主动上报帧交由调用方处理。回调在表锁之外执行（通常在读取线程中），超时、请求未能写出或整表取消时
+ * 收到空的 FrameView。
+ *
+ * Slots are selected by the low bits of SEQ, so up to slot_count requests with consecutive SEQs can be in flight.
+ * Frames that answer no request can be claimed by expectations registered with expect(), for example the
+ * connection request the camera sends during the handshake. Unlike callbacks, their matchers run while the table
+ * lock is held and must not call back into the table.
+ *
+ * The reader sleeps until next_deadline(). When add() or expect() registers an earlier deadline the table calls
+ * wake, outside the lock, so a short timeout is not held up by a longer one or by the reader's idle wait. Results
+ * of requests go through deliver when one is given, which lets the owner record them without wrapping every
+ * callback.
+ * 槽位由 SEQ 的低位选择，连续 SEQ 的请求最多可同时有 slot_count 个在途。
+ * 不是任何请求应答的帧可以被 expect() 登记的等待项认领，例如握手过程中相机发来的连接请求。
+ * 与回调不同，等待项的匹配函数在持有表锁时执行，不得再调用本表。
+ *
+ * 读取线程休眠到 next_deadline()。add() 或 expect() 登记了更早的截止时间时，本表在锁外调用 wake，
+ * 因此较短的超时不会被较长的超时或读取线程的空闲等待耽误。给出 deliver 时请求的结果经由它交付，所有者无需包装
+ * 每个回调即可记录结果。
+ */
+class PendingRequests {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void(FrameView)>;
+    using Matcher = std::function<bool(const FrameView &)>;
+
+    static constexpr size_t slot_count = 256;
+
+    // 已完成请求的结果，在表锁之外交付
+    struct Result {
+        uint16_t seq = 0;
+        uint8_t cmd_set = 0;
+        uint8_t cmd_id = 0;
+        Clock::time_point added; // 登记的时间
+        Callback callback;
+    };
+    // 交付结果，须以 frame 调用 result.callback；frame 为应答，超时、失败或取消时为空视图
+    using Deliver = std::function<void(Result &result, FrameView frame)>;
+
+    explicit PendingRequests(std::function<void()> wake = nullptr, Deliver deliver = nullptr)
+        : wake_(std::move(wake)), deliver_(std::move(deliver)) {}
+
+    // 登记请求，应在发送前调用以免应答先于登记到达；槽位被占用时返回 false
+    bool add(uint16_t seq, uint8_t cmd_set, uint8_t cmd_id, Clock::time_point deadline, Callback callback) {
+        Clock::time_point added = Clock::now();
+        bool earlier;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Slot &slot = slots_[seq % slot_count];
+            if (slot.active) {
+                return false;
+            }
+            slot.active = true;
+            slot.deadline = deadline;
+            slot.request.seq = seq;
+            slot.request.cmd_set = cmd_set;
+            slot.request.cmd_id = cmd_id;
+            slot.request.added = added;
+            slot.request.callback = std::move(callback);
+            in_flight_++;
+            earlier = arm_locked(deadline);
+        }
+        if (earlier) {
+            wake_();
+        }
+        return true;
+    }
+
+    // 请求未能发出时撤销并以空的 FrameView 调用其回调
+    void fail(uint16_t seq) {
+        Result result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Slot &slot = slots_[seq % slot_count];
+            if (!slot.active || slot.request.seq != seq) {
+                return;
+            }
+            result = release(slot);
+        }
+        settle(result, FrameView());
+    }
+
+    // 匹配应答并调用其回调，帧不是任何在途请求的应答时返回 false
+    bool complete(const FrameView &frame) {
+        if ((frame.cmd_type() & message_detail::response_bit) == 0) {
+            return false;
+        }
+
+        Result result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Slot &slot = slots_[frame.seq() % slot_count];
+            if (!slot.active || slot.request.seq != frame.seq() || slot.request.cmd_set != frame.cmd_set() ||
+                slot.request.cmd_id != frame.cmd_id()) {
+                return false;
+            }
+            result = release(slot);
+        }
+        settle(result, frame);
+        return true;
+    }
+
+    // 登记一次性等待项，第一个满足 match 的主动上报帧会交给 callback；match 持锁调用，不得重入本表
+    void expect(Matcher match, Clock::time_point deadline, Callback callback) {
+        bool earlier;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            expectations_.push_back(Expectation{std::move(match), deadline, std::move(callback)});
+            earlier = arm_locked(deadline);
+        }
+        if (earlier) {
+            wake_();
+        }
+    }
+
+    // 将不属于任何请求的帧交给最早登记且匹配的等待项，没有等待项认领时返回 false
+    bool offer(const FrameView &frame) {
+        Callback callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = expectations_.begin();
+            while (it != expectations_.end() && !it->match(frame)) {
+                ++it;
+            }
+            if (it == expectations_.end()) {
+                return false;
+            }
+            callback = std::move(it->callback);
+            expectations_.erase(it);
+        }
+        callback(frame);
+        return true;
+    }
+
+    // 让所有截止时间不晚于 now 的请求与等待项超时，返回超时的数量
+    size_t expire(Clock::time_point now) {
+        std::vector<Result> expired;
+        std::vector<Callback> unmet;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (now < next_deadline_locked()) {
+                return 0;
+            }
+            for (Slot &slot : slots_) {
+                if (slot.active && slot.deadline <= now) {
+                    expired.push_back(release(slot));
+                }
+            }
+            for (auto it = expectations_.begin(); it != expectations_.end();) {
+                if (it->deadline <= now) {
+                    unmet.push_back(std::move(it->callback));
+                    it = expectations_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        for (Result &result : expired) {
+            settle(result, FrameView());
+        }
+        for (Callback &callback : unmet) {
+            callback(FrameView());
+        }
+        return expired.size() + unmet.size();
+    }
+
+    // 最近的截止时间，没有在途请求和等待项时返回 Clock::time_point::max()；由读取线程在休眠前调用，
+    // 之后登记的截止时间早于它时调用 wake
+    Clock::time_point next_deadline() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        armed_ = next_deadline_locked();
+        return armed_;
+    }
+
+    // 取消所有在途请求与等待项，回调收到空的 FrameView
+    void cancel_all() {
+        std::vector<Result> cancelled;
+        std::vector<Callback> unmet;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (Slot &slot : slots_) {
+                if (slot.active) {
+                    cancelled.push_back(release(slot));
+                }
+            }
+            for (Expectation &expectation : expectations_) {
+                unmet.push_back(std::move(expectation.callback));
+            }
+            expectations_.clear();
+        }
+        for (Result &result : cancelled) {
+            settle(result, FrameView());
+        }
+        for (Callback &callback : unmet) {
+            callback(FrameView());
+        }
+    }
+
+    size_t in_flight() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return in_flight_;
+    }
+
+private:
+    struct Slot {
+        bool active = false;
+        Clock::time_point deadline;
+        Result request;
+    };
+
+    struct Expectation {
+        Matcher match;
+        Clock::time_point deadline;
+        Callback callback;
+    };
+
+    // 调用方已持有 mutex_；取出请求以便在锁外交付结果
+    Result release(Slot &slot) {
+        slot.active = false;
+        in_flight_--;
+        Result request = std::move(slot.request);
+        slot.request.callback = nullptr;
+        return request;
+    }
+
+    void settle(Result &result, FrameView frame) {
+        if (deliver_) {
+            deliver_(result, std::move(frame));
+        } else {
+            result.callback(std::move(frame));
+        }
+    }
+
+    // 调用方已持有 mutex_；deadline 早于读取线程等待的时间时将其提前并返回 true
+    bool arm_locked(Clock::time_point deadline) {
+        if (!wake_ || deadline >= armed_) {
+            return false;
+        }
+        armed_ = deadline;
+        return true;
+    }
+
+    // 调用方已持有 mutex_
+    Clock::time_point next_deadline_locked() const {
+        Clock::time_point deadline = Clock::time_point::max();
+        for (const Expectation &expectation : expectations_) {
+            if (expectation.deadline < deadline) {
+                deadline = expectation.deadline;
+            }
+        }
+        if (in_flight_ == 0) {
+            return deadline;
+        }
+        for (const Slot &slot : slots_) {
+            if (slot.active && slot.deadline < deadline) {
+                deadline = slot.deadline;
+            }
+        }
+        return deadline;
+    }
+
+    const std::function<void()> wake_;
+    const Deliver deliver_;
+
+    mutable std::mutex mutex_;
+    std::array<Slot, slot_count> slots_;
+    size_t in_flight_ = 0;
+    // 数量很少（通常只有握手时的一项），按登记顺序线性匹配
+    std::vector<Expectation> expectations_;
+    // 读取线程上次调用 next_deadline() 得到的时间，之后被更早的截止时间提前
+    Clock::time_point armed_ = Clock::time_point::max();
+};
@@ -0,0 +1,203 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "dji/dji_protocol_parser.h"
+
+class RxBufferPool;
+
+/**
+ * @brief One received frame, owned by a pool and shared through RxBufferRef
+ *        一个已接收的帧，归属于缓冲池，通过 RxBufferRef 共享
+ */
+class RxBuffer {
+public:
+    const uint8_t *data() const { return bytes_.data(); }
+    size_t size() const { return length_; }
+    std::chrono::steady_clock::time_point received_at() const { return received_at_; }
+
+private:
+    friend class RxBufferPool;
+    friend class RxBufferRef;
+
+    std::array<uint8_t, PROTOCOL_MAX_FRAME_LENGTH> bytes_;
+    size_t length_ = 0;
+    std::chrono::steady_clock::time_point received_at_;
+    std::atomic<uint32_t> refs_ = 0;
+    // 池外的临时缓冲区，释放时直接删除
+    bool pooled_ = true;
+    RxBufferPool *pool_ = nullptr;
+#ifndef NDEBUG
+    // 每次归还到池中加一，用于在调试版本中发现悬空引用
+    std::atomic<uint32_t> generation_ = 0;
+#endif
+};
+
+/**
+ * @brief Refcounted handle to an RxBuffer, the buffer returns to its pool when the last handle is released
+ *        RxBuffer 的引用计数句柄，最后一个句柄释放时缓冲区归还到池中
+ */
+class RxBufferRef {
+public:
+    RxBufferRef() = default;
+    RxBufferRef(const RxBufferRef &other) : buffer_(other.buffer_) {
+#ifndef NDEBUG
+        generation_ = other.generation_;
+#endif
+        if (buffer_ != nullptr) {
+            buffer_->refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    RxBufferRef(RxBufferRef &&other) noexcept : buffer_(std::exchange(other.buffer_, nullptr)) {
+#ifndef NDEBUG
+        generation_ = other.generation_;
+#endif
+    }
+    RxBufferRef &operator=(RxBufferRef other) noexcept {
+        std::swap(buffer_, other.buffer_);
+#ifndef NDEBUG
+        std::swap(generation_, other.generation_);
+#endif
+        return *this;
+    }
+    ~RxBufferRef() { reset(); }
+
+    void reset();
+
+    const uint8_t *data() const {
+        check_alive();
+        return buffer_->data();
+    }
+    size_t size() const {
+        check_alive();
+        return buffer_->size();
+    }
+    std::chrono::steady_clock::time_point received_at() const {
+        check_alive();
+        return buffer_->received_at();
+    }
+    explicit operator bool() const { return buffer_ != nullptr; }
+
+private:
+    friend class RxBufferPool;
+
+    explicit RxBufferRef(RxBuffer *buffer) : buffer_(buffer) {
+#ifndef NDEBUG
+        generation_ = buffer->generation_.load(std::memory_order_relaxed);
+#endif
+    }
+
+    void check_alive() const {
+        assert(buffer_ != nullptr && "empty RxBufferRef");
+        assert(buffer_->refs_.load(std::memory_order_relaxed) > 0 && "RxBuffer used after release");
+#ifndef NDEBUG
+        assert(buffer_->generation_.load(std::memory_order_relaxed) == generation_ &&
+               "RxBuffer reused while referenced");
+#endif
+    }
+
+    RxBuffer *buffer_ = nullptr;
+#ifndef NDEBUG
+    uint32_t generation_ = 0;
+#endif
+};
+
+/**
+ * @brief Fixed set of frame-sized receive buffers recycled without touching the heap
+ *        固定数量的帧长度接收缓冲区，循环使用，不经过堆分配
+ *
+ * When every buffer is in use acquire() falls back to a heap buffer and counts it in overflows(), so a slow
+ * consumer costs allocations rather than dropped frames. The pool must outlive every RxBufferRef it hands out.
+ * 所有缓冲区都被占用时 acquire() 退回到堆分配并计入 overflows()，消费者过慢时只会多出分配而不会丢帧。
+ * 缓冲池的生命周期必须长于它发出的所有 RxBufferRef。
+ */
+class RxBufferPool {
+public:
+    explicit RxBufferPool(size_t capacity = 32) : buffers_(capacity) {
+        free_.reserve(capacity);
+        for (auto &buffer : buffers_) {
+            buffer.pool_ = this;
+            free_.push_back(&buffer);
+        }
+    }
+    ~RxBufferPool() {
+        // 仍有句柄持有缓冲区说明存在悬空引用
+        assert(free_.size() == buffers_.size() && "RxBufferPool destroyed while buffers are still referenced");
+    }
+
+    RxBufferPool(const RxBufferPool &) = delete;
+    RxBufferPool &operator=(const RxBufferPool &) = delete;
+
+    // 拷贝一帧到缓冲区，返回持有该缓冲区的句柄；长度超过最大帧长，或不足以容纳 CmdSet 与 CmdID 时返回空句柄
+    RxBufferRef acquire(const uint8_t *data, size_t length,
+                        std::chrono::steady_clock::time_point received_at = std::chrono::steady_clock::now()) {
+        // 流式解码器接受 PROTOCOL_MIN_FRAME_LENGTH 起的帧，更短的帧没有 CmdSet 与 CmdID，FrameView 无法解读
+        if (length < PROTOCOL_FULL_FRAME_LENGTH(0) || length > PROTOCOL_MAX_FRAME_LENGTH) {
+            return RxBufferRef();
+        }
+
+        RxBuffer *buffer = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                buffer = free_.back();
+                free_.pop_back();
+            }
+        }
+        if (buffer == nullptr) {
+            overflows_.fetch_add(1, std::memory_order_relaxed);
+            buffer = new RxBuffer();
+            buffer->pooled_ = false;
+            buffer->pool_ = this;
+        }
+
+        std::memcpy(buffer->bytes_.data(), data, length);
+        buffer->length_ = length;
+        buffer->received_at_ = received_at;
+        buffer->refs_.store(1, std::memory_order_relaxed);
+        return RxBufferRef(buffer);
+    }
+
+    size_t capacity() const { return buffers_.size(); }
+    size_t available() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return free_.size();
+    }
+    uint64_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+private:
+    friend class RxBufferRef;
+
+    void release(RxBuffer *buffer) {
+        if (!buffer->pooled_) {
+            delete buffer;
+            return;
+        }
+#ifndef NDEBUG
+        // 填充无效数据，让越过句柄生命周期的裸指针读到明显错误的内容
+        std::memset(buffer->bytes_.data(), 0xDD, buffer->length_);
+        buffer->generation_.fetch_add(1, std::memory_order_relaxed);
+#endif
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(buffer);
+    }
+
+    std::vector<RxBuffer> buffers_;
+    mutable std::mutex mutex_;
+    std::vector<RxBuffer *> free_;
+    std::atomic<uint64_t> overflows_ = 0;
+};
+
+inline void RxBufferRef::reset() {
+    RxBuffer *buffer = std::exchange(buffer_, nullptr);
+    if (buffer != nullptr && buffer->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        buffer->pool_->release(buffer);
+    }
+}
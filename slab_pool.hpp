@@ -0,0 +1,207 @@
+#pragma once
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "dji/dji_allocator.h"
+
+/**
+ * @brief Size-class slab allocator for payload structures and frames
+ *        用于有效载荷结构体和帧的按尺寸分级的 slab 分配器
+ *
+ * Blocks are carved from slabs and recycled through per-class free lists; slabs are only returned to the heap
+ * when the pool is destroyed, so after warm-up a session allocates nothing and its footprint stays at the high
+ * water mark. Every block carries a small header naming its pool, which lets a block be released from any
+ * thread and through dji_free without knowing where it came from. Requests larger than the biggest class fall
+ * back to the heap and are counted as misses.
+ * 内存块从 slab 中切分，并通过各尺寸级别的空闲链表循环使用；slab 只在缓冲池销毁时归还给堆，
+ * 因此预热后会话不再分配内存，占用稳定在峰值。每个内存块带有记录所属缓冲池的块头，
+ * 可以在任意线程通过 dji_free 释放而无需知道其来源。超过最大尺寸级别的请求退回到堆分配并计为未命中。
+ */
+class SlabPool {
+public:
+    struct Stats {
+        uint64_t hits = 0;     // 由空闲链表满足的分配
+        uint64_t misses = 0;   // 需要新 slab 或退回到堆的分配
+        size_t in_use = 0;     // 当前未释放的块数
+        size_t high_water = 0; // in_use 的历史峰值
+        size_t slab_bytes = 0; // 已向堆申请的 slab 总字节数
+    };
+
+    explicit SlabPool(size_t blocks_per_slab = 16) : blocks_per_slab_(blocks_per_slab) {}
+    ~SlabPool() {
+        // 仍有未释放的块说明调用方持有的指针将悬空
+        assert(stats_.in_use == 0 && "SlabPool destroyed while blocks are still in use");
+    }
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    void *allocate(size_t size) {
+        size_t size_class = class_for(size);
+        if (size_class == heap_class) {
+            return allocate_from_heap(size, this);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        FreeBlock *block = free_[size_class];
+        if (block != nullptr) {
+            free_[size_class] = block->next;
+            stats_.hits++;
+        } else {
+            block = grow(size_class);
+            stats_.misses++;
+        }
+        note_in_use(+1);
+
+        Header *header = reinterpret_cast<Header *>(block);
+        header->pool = this;
+        header->size_class = (uint32_t)size_class;
+        header->magic = header_magic;
+        return header + 1;
+    }
+
+    // 将块归还到其所属的缓冲池，任意线程均可调用
+    static void release(void *ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+        Header *header = static_cast<Header *>(ptr) - 1;
+        assert(header->magic == header_magic && "pointer was not allocated by SlabPool");
+
+        SlabPool *pool = header->pool;
+        if (header->size_class == heap_class) {
+            if (pool != nullptr) {
+                std::lock_guard<std::mutex> lock(pool->mutex_);
+                pool->note_in_use(-1);
+            }
+            std::free(header);
+            return;
+        }
+
+        // 清除标记，重复释放会在上面的断言处被发现
+        header->magic = 0;
+        std::lock_guard<std::mutex> lock(pool->mutex_);
+        FreeBlock *block = reinterpret_cast<FreeBlock *>(header);
+        block->next = pool->free_[header->size_class];
+        pool->free_[header->size_class] = block;
+        pool->note_in_use(-1);
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    /**
+     * @brief Routes dji_malloc on the current thread to a pool for the lifetime of the scope
+     *        在作用域内将当前线程的 dji_malloc 路由到指定缓冲池
+     *
+     * Outside any scope dji_malloc still returns headed heap blocks, so dji_free stays valid for every pointer.
+     * 不在任何作用域内时 dji_malloc 仍返回带块头的堆内存，因此 dji_free 对所有指针都有效。
+     */
+    class Scope {
+    public:
+        explicit Scope(SlabPool &pool) : previous_(current_) {
+            install_hooks();
+            current_ = &pool;
+        }
+        ~Scope() { current_ = previous_; }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        SlabPool *previous_;
+    };
+
+    // 设置 dji 库的分配钩子，只在第一次调用时生效
+    static void install_hooks() {
+        static std::once_flag once;
+        std::call_once(once, [] { dji_set_allocator(hook_malloc, hook_free, nullptr); });
+    }
+
+private:
+    // 块头，保持 max_align_t 对齐，使返回给调用方的指针可以存放任意结构体
+    struct alignas(std::max_align_t) Header {
+        SlabPool *pool;
+        uint32_t size_class;
+        uint32_t magic = header_magic;
+    };
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static constexpr uint32_t header_magic = 0x51AB0C0D;
+    static constexpr size_t heap_class = 0xFFFFFFFF;
+    // 覆盖常见应答结构体到最大帧长度
+    static constexpr std::array<size_t, 6> class_sizes = {32, 64, 128, 256, 512, 1024};
+
+    static size_t class_for(size_t size) {
+        for (size_t i = 0; i < class_sizes.size(); i++) {
+            if (size <= class_sizes[i]) {
+                return i;
+            }
+        }
+        return heap_class;
+    }
+
+    static void *allocate_from_heap(size_t size, SlabPool *pool) {
+        Header *header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+        if (header == nullptr) {
+            return nullptr;
+        }
+        new (header) Header{pool, (uint32_t)heap_class};
+        if (pool != nullptr) {
+            std::lock_guard<std::mutex> lock(pool->mutex_);
+            pool->stats_.misses++;
+            pool->note_in_use(+1);
+        }
+        return header + 1;
+    }
+
+    // 调用方已持有 mutex_
+    FreeBlock *grow(size_t size_class) {
+        size_t block_size = sizeof(Header) + class_sizes[size_class];
+        slabs_.push_back(std::make_unique<std::byte[]>(block_size * blocks_per_slab_));
+        stats_.slab_bytes += block_size * blocks_per_slab_;
+
+        std::byte *slab = slabs_.back().get();
+        for (size_t i = 1; i < blocks_per_slab_; i++) {
+            FreeBlock *block = reinterpret_cast<FreeBlock *>(slab + i * block_size);
+            block->next = free_[size_class];
+            free_[size_class] = block;
+        }
+        return new (slab) FreeBlock{nullptr};
+    }
+
+    // 调用方已持有 mutex_
+    void note_in_use(int delta) {
+        stats_.in_use += delta;
+        if (stats_.in_use > stats_.high_water) {
+            stats_.high_water = stats_.in_use;
+        }
+    }
+
+    static void *hook_malloc(size_t size, void *) {
+        SlabPool *pool = current_;
+        return pool != nullptr ? pool->allocate(size) : allocate_from_heap(size, nullptr);
+    }
+
+    static void hook_free(void *ptr, void *) { release(ptr); }
+
+    static inline thread_local SlabPool *current_ = nullptr;
+
+    size_t blocks_per_slab_;
+    mutable std::mutex mutex_;
+    std::array<FreeBlock *, class_sizes.size()> free_{};
+    std::vector<std::unique_ptr<std::byte[]>> slabs_;
+    Stats stats_;
+};
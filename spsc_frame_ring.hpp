@@ -0,0 +1,206 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "dji/dji_protocol_parser.h"
+
+/**
+ * @brief Bounded single-producer/single-consumer ring of whole frames stored inline
+ *        单生产者/单消费者的有界环形缓冲区，帧内容直接存放在槽位中
+ *
+ * The BLE callback thread pushes reassembled frames and the reader thread consumes them. A push is a memcpy into
+ * the next slot plus an atomic store of the tail index: no lock, no allocation. The consumer only takes a lock
+ * when the ring is empty and it is about to sleep, and the producer only touches that lock when it sees a
+ * sleeping consumer, so under sustained traffic both sides stay lock-free.
+ * BLE 回调线程推入重组后的完整帧，读取线程消费。推入操作只是一次拷贝到下一个槽位，加上一次对尾索引的
+ * 原子写入：不加锁、不分配内存。消费者只在缓冲区为空准备休眠时加锁，生产者只在发现消费者休眠时才
+ * 访问该锁，因此在持续有数据时两侧都是无锁的。
+ *
+ * When the ring is full the overflow policy decides: DropNewest discards the incoming frame and counts it,
+ * Block makes the producer wait for a free slot (only suitable when the consumer can never stall).
+ * 缓冲区满时由溢出策略决定：DropNewest 丢弃新到的帧并计数，Block 让生产者等待空闲槽位（仅适用于消费者
+ * 不会停滞的场景）。
+ */
+class SpscFrameRing {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class OverflowPolicy : uint8_t {
+        DropNewest,
+        Block,
+    };
+
+    class Slot {
+    public:
+        const uint8_t *data() const { return bytes_; }
+        size_t size() const { return length_; }
+        // 帧到达（重组完成）的时间
+        Clock::time_point timestamp() const { return timestamp_; }
+
+    private:
+        friend class SpscFrameRing;
+
+        Clock::time_point timestamp_;
+        uint16_t length_ = 0;
+        uint8_t bytes_[PROTOCOL_MAX_FRAME_LENGTH];
+    };
+
+    struct Stats {
+        uint64_t pushed = 0;    // 成功推入的帧数
+        uint64_t overflows = 0; // 因缓冲区已满或帧过长而丢弃的帧数
+        size_t depth = 0;       // 当前排队的帧数
+        size_t high_water = 0;  // 消费者取帧时见到的 depth 峰值
+    };
+
+    // capacity 向上取整为 2 的幂
+    explicit SpscFrameRing(size_t capacity = 64, OverflowPolicy policy = OverflowPolicy::DropNewest)
+        : mask_(std::bit_ceil(capacity) - 1), policy_(policy), slots_(std::make_unique<PaddedSlot[]>(mask_ + 1)) {}
+
+    SpscFrameRing(const SpscFrameRing &) = delete;
+    SpscFrameRing &operator=(const SpscFrameRing &) = delete;
+
+    // 生产者：拷贝一帧到下一个槽位，被丢弃时返回 false
+    bool push(const uint8_t *data, size_t length) {
+        if (length > PROTOCOL_MAX_FRAME_LENGTH) {
+            producer_.overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        size_t tail = producer_.tail.load(std::memory_order_relaxed);
+        if (tail - producer_.cached_head > mask_) {
+            producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+            while (tail - producer_.cached_head > mask_) {
+                if (policy_ == OverflowPolicy::DropNewest || closed_.load(std::memory_order_relaxed)) {
+                    producer_.overflows.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                std::this_thread::yield();
+                producer_.cached_head = consumer_.head.load(std::memory_order_acquire);
+            }
+        }
+
+        Slot &slot = slots_[tail & mask_].slot;
+        slot.timestamp_ = Clock::now();
+        slot.length_ = (uint16_t)length;
+        std::memcpy(slot.bytes_, data, length);
+        // seq_cst 与 wait_until 中对 sleeping_ 的写入构成 Dekker 式同步，消费者在运行时不会进入下面的加锁分支
+        producer_.tail.store(tail + 1, std::memory_order_seq_cst);
+
+        producer_.pushed.fetch_add(1, std::memory_order_relaxed);
+
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+        return true;
+    }
+
+    // 消费者：最早的帧，为空时返回 nullptr；槽位在 pop() 之前保持有效
+    const Slot *front() {
+        size_t head = consumer_.head.load(std::memory_order_relaxed);
+        if (head == consumer_.cached_tail) {
+            consumer_.cached_tail = producer_.tail.load(std::memory_order_acquire);
+            if (head == consumer_.cached_tail) {
+                return nullptr;
+            }
+            // 生产者缓存的 head 可能早已过时，因此由消费者在读到新的 tail 时计算深度，此时排队的帧也最多
+            size_t depth = consumer_.cached_tail - head;
+            if (depth > consumer_.high_water.load(std::memory_order_relaxed)) {
+                consumer_.high_water.store(depth, std::memory_order_relaxed);
+            }
+        }
+        return &slots_[head & mask_].slot;
+    }
+
+    // 消费者：释放 front() 返回的槽位
+    void pop() {
+        consumer_.head.store(consumer_.head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 消费者：等待到有帧可读或 deadline，有帧时返回 true；close() 之后立即返回
+    bool wait_until(Clock::time_point deadline) {
+        if (front() != nullptr) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        sleeping_.store(true, std::memory_order_seq_cst);
+        cv_.wait_until(lock, deadline, [this] {
+            return producer_.tail.load(std::memory_order_seq_cst) != consumer_.head.load(std::memory_order_relaxed) ||
+                   woken_.load(std::memory_order_seq_cst) || closed_.load();
+        });
+        sleeping_.store(false, std::memory_order_relaxed);
+        woken_.store(false, std::memory_order_relaxed);
+        return front() != nullptr;
+    }
+
+    // 让消费者的下一次或当前的 wait_until 立即返回，例如它等待的截止时间已提前；可在任意线程调用
+    void wake() {
+        woken_.store(true, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+    }
+
+    // 唤醒消费者并让 Block 策略的生产者不再等待，可在任意线程调用
+    void close() {
+        closed_.store(true);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_one();
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // 可在任意线程调用，各计数器分别读取，彼此之间不保证是同一时刻的快照
+    Stats stats() const {
+        Stats stats;
+        stats.pushed = producer_.pushed.load(std::memory_order_relaxed);
+        stats.overflows = producer_.overflows.load(std::memory_order_relaxed);
+        stats.high_water = consumer_.high_water.load(std::memory_order_relaxed);
+        size_t head = consumer_.head.load(std::memory_order_acquire);
+        size_t tail = producer_.tail.load(std::memory_order_acquire);
+        stats.depth = tail >= head ? tail - head : 0;
+        return stats;
+    }
+
+private:
+    static constexpr size_t cache_line = 64;
+
+    // 槽位按缓存行对齐，相邻槽位的读写不会互相干扰
+    struct alignas(cache_line) PaddedSlot {
+        Slot slot;
+    };
+
+    // 生产者与消费者各自写入的字段放在不同缓存行，并缓存对方的索引以减少跨核读取
+    struct alignas(cache_line) ProducerSide {
+        std::atomic<size_t> tail = 0;
+        size_t cached_head = 0;
+        std::atomic<uint64_t> pushed = 0;
+        std::atomic<uint64_t> overflows = 0;
+    };
+    struct alignas(cache_line) ConsumerSide {
+        std::atomic<size_t> head = 0;
+        size_t cached_tail = 0;
+        std::atomic<size_t> high_water = 0;
+    };
+
+    const size_t mask_;
+    const OverflowPolicy policy_;
+    std::unique_ptr<PaddedSlot[]> slots_;
+
+    ProducerSide producer_;
+    ConsumerSide consumer_;
+
+    alignas(cache_line) std::atomic<bool> sleeping_ = false;
+    std::atomic<bool> woken_ = false;
+    std::atomic<bool> closed_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
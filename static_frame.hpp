@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "dji/dji_protocol_parser.h"
+
+/**
+ * @brief Compile-time frame encoder, produces the same bytes as protocol_encode_frame_into
+ *        编译期帧编码，结果与 protocol_encode_frame_into 完全一致
+ */
+namespace static_frame_detail {
+
+template <typename T, T Poly> constexpr std::array<T, 256> make_crc_table() {
+    std::array<T, 256> table{};
+    for (uint32_t n = 0; n < 256; n++) {
+        T c = static_cast<T>(n);
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? static_cast<T>((c >> 1) ^ Poly) : static_cast<T>(c >> 1);
+        }
+        table[n] = c;
+    }
+    return table;
+}
+
+inline constexpr auto crc16_table = make_crc_table<uint16_t, 0xA001>();
+inline constexpr auto crc32_table = make_crc_table<uint32_t, 0xEDB88320>();
+
+template <typename T, size_t N> constexpr T crc(const std::array<T, 256> &table, const std::array<uint8_t, N> &data,
+                                                 size_t length) {
+    T c = 0x3aa3;
+    for (size_t i = 0; i < length; i++) {
+        c = static_cast<T>(table[(c ^ data[i]) & 0xff] ^ (c >> 8));
+    }
+    return c;
+}
+
+} // namespace static_frame_detail
+
+template <uint8_t CmdSet, uint8_t CmdId, uint8_t CmdType, size_t N>
+constexpr std::array<uint8_t, PROTOCOL_FULL_FRAME_LENGTH(N)> make_static_frame(const std::array<uint8_t, N> &payload,
+                                                                                uint16_t seq = 0) {
+    static_assert(PROTOCOL_FULL_FRAME_LENGTH(N) <= PROTOCOL_MAX_FRAME_LENGTH, "payload too large for one frame");
+    constexpr size_t length = PROTOCOL_FULL_FRAME_LENGTH(N);
+
+    std::array<uint8_t, length> frame{};
+    frame[0] = 0xAA;
+    frame[1] = length & 0xFF;
+    frame[2] = (length >> 8) & 0x03;
+    frame[3] = CmdType;
+    frame[8] = (seq >> 8) & 0xFF;
+    frame[9] = seq & 0xFF;
+
+    uint16_t crc16 = static_frame_detail::crc(static_frame_detail::crc16_table, frame, PROTOCOL_CRC16_COVERED_LENGTH);
+    frame[10] = crc16 & 0xFF;
+    frame[11] = (crc16 >> 8) & 0xFF;
+    frame[12] = CmdSet;
+    frame[13] = CmdId;
+    for (size_t i = 0; i < N; i++) {
+        frame[PROTOCOL_HEADER_LENGTH + i] = payload[i];
+    }
+
+    uint32_t crc32 = static_frame_detail::crc(static_frame_detail::crc32_table, frame, length - PROTOCOL_TAIL_LENGTH);
+    for (size_t i = 0; i < PROTOCOL_TAIL_LENGTH; i++) {
+        frame[length - PROTOCOL_TAIL_LENGTH + i] = (crc32 >> (8 * i)) & 0xFF;
+    }
+    return frame;
+}
+
+/**
+ * @brief Encode a packed command structure at compile time, e.g.
+ *        在编译期编码紧凑命令结构体，例如
+ *        constexpr auto stop = make_static_frame<0x1D, 0x03, CMD_WAIT_RESULT>(record_control_command_frame_t{...});
+ *        co_await dev.request_frame(stop.data(), stop.size());
+ *
+ * The SEQ baked in here is a placeholder, OsmoDevice::request_frame and send_frame_async stamp a fresh one per send.
+ * 这里写入的 SEQ 只是占位，OsmoDevice::request_frame 与 send_frame_async 每次发送时改写为新的 SEQ。
+ */
+template <uint8_t CmdSet, uint8_t CmdId, uint8_t CmdType, typename T>
+    requires(!std::is_array_v<T> && std::is_trivially_copyable_v<T>)
+constexpr auto make_static_frame(const T &structure, uint16_t seq = 0) {
+    return make_static_frame<CmdSet, CmdId, CmdType>(std::bit_cast<std::array<uint8_t, sizeof(T)>>(structure), seq);
+}
+
+// 版本号查询帧（无有效载荷）与运行时编码结果一致
+static_assert(make_static_frame<0x00, 0x00, 0x02>(std::array<uint8_t, 0>{}, 0x1235) ==
+              std::array<uint8_t, 18>{0xaa, 0x12, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x12, 0x35, 0xc1, 0x59, 0x00,
+                                      0x00, 0x23, 0xd6, 0x04, 0x95});
@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Gives every producer thread its own Ring and lets one consumer thread collect them
+ *        为每个生产者线程提供自己的 Ring，并由单个消费者线程汇总
+ *
+ * local() returns the calling thread's ring, creating Ring(capacity) and registering it on the first call. Each
+ * thread keeps a small list of its rings keyed by the registry instance, so several registries of the same Ring type
+ * can be alive at once without taking each other's rings. The lookup is a thread_local read and a compare against the
+ * entry hit last, so producers take the registry lock only once per thread and registry. A ring outlives its thread
+ * until the consumer has emptied it: snapshot() hands it to the reap callback and drops it once the thread has exited
+ * and the drained predicate holds. A thread drops the entries of registries that have since been destroyed the next
+ * time it registers a ring. Only the consumer calls snapshot(), so the rings it returns stay valid until its next
+ * call.
+ * local() 返回调用线程的缓冲区，第一次调用时创建 Ring(capacity) 并登记。每个线程按登记表实例保存一个小的缓冲区
+ * 列表，因此同一 Ring 类型的多个登记表可以同时存在而不会互相抢占缓冲区。查找只是一次 thread_local 读取并与上次
+ * 命中的条目比较，生产者每个线程、每个登记表只加一次登记锁。线程退出后缓冲区保留到消费者取空为止：当所属线程已
+ * 退出且 drained 成立时，snapshot() 先把它交给 reap 回调再移除。线程下一次登记缓冲区时，丢弃已销毁的登记表留下的
+ * 条目。只有消费者调用 snapshot()，因此它返回的缓冲区在下一次调用之前一直有效。
+ */
+template <typename Ring> class ThreadRingRegistry {
+public:
+    explicit ThreadRingRegistry(size_t capacity) : capacity_(capacity), generation_(next_generation()) {}
+
+    ThreadRingRegistry(const ThreadRingRegistry &) = delete;
+    ThreadRingRegistry &operator=(const ThreadRingRegistry &) = delete;
+
+    Ring &local() {
+        static thread_local Locals locals;
+        if (locals.last < locals.entries.size() && locals.entries[locals.last].generation == generation_) {
+            return locals.entries[locals.last].owned->ring;
+        }
+        for (size_t i = 0; i < locals.entries.size(); i++) {
+            if (locals.entries[i].generation == generation_) {
+                locals.last = i;
+                return locals.entries[i].owned->ring;
+            }
+        }
+
+        // 只剩本线程持有的缓冲区，其登记表已经销毁，不会再被取用
+        std::erase_if(locals.entries, [](const Local &local) { return local.owned.use_count() == 1; });
+        auto owned = std::make_shared<Owned>(capacity_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            owned_.push_back(owned);
+        }
+        locals.entries.push_back(Local{generation_, std::move(owned)});
+        locals.last = locals.entries.size() - 1;
+        return locals.entries.back().owned->ring;
+    }
+
+    // 回收所属线程已退出且 drained(ring) 为真的缓冲区（回收前持锁调用 reap(ring)），再拷贝仍登记的缓冲区
+    template <typename Drained, typename Reap>
+    void snapshot(std::vector<std::shared_ptr<Ring>> &rings, Drained drained, Reap reap) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto reaped = [&](const std::shared_ptr<Owned> &owned) {
+            if (!owned->retired.load(std::memory_order_acquire) || !drained(owned->ring)) {
+                return false;
+            }
+            reap(owned->ring);
+            return true;
+        };
+        owned_.erase(std::remove_if(owned_.begin(), owned_.end(), reaped), owned_.end());
+        rings.clear();
+        for (const auto &owned : owned_) {
+            rings.push_back(std::shared_ptr<Ring>(owned, &owned->ring));
+        }
+    }
+
+    // 持锁对每个已登记的缓冲区调用 each，再调用 then，返回缓冲区数。reap 回调也在此锁下运行，因此在 then 中读取
+    // 被回收缓冲区的累计值，不会与 each 重复或遗漏
+    template <typename Each, typename Then> size_t visit(Each each, Then then) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &owned : owned_) {
+            each(static_cast<const Ring &>(owned->ring));
+        }
+        then();
+        return owned_.size();
+    }
+
+private:
+    struct Owned {
+        explicit Owned(size_t capacity) : ring(capacity) {}
+
+        Ring ring;
+        std::atomic<bool> retired = false;
+    };
+
+    struct Local {
+        uint64_t generation = 0;
+        std::shared_ptr<Owned> owned;
+    };
+
+    // 本线程在各个登记表中的缓冲区；线程退出时全部标记，由各自的消费者取空后回收
+    struct Locals {
+        ~Locals() {
+            for (const Local &local : entries) {
+                local.owned->retired.store(true, std::memory_order_release);
+            }
+        }
+
+        std::vector<Local> entries;
+        size_t last = 0;
+    };
+
+    static uint64_t next_generation() {
+        static std::atomic<uint64_t> generation = 0;
+        return ++generation;
+    }
+
+    const size_t capacity_;
+    const uint64_t generation_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<Owned>> owned_;
+};
+
+/**
+ * @brief Background thread that runs a drain step every poll interval or sooner when producers call wake()
+ *        后台线程每个轮询间隔执行一次 drain，生产者调用 wake() 时提前执行
+ *
+ * wake() is lock-free: it bumps a counter and only notifies when the thread is asleep, and a wake-up lost between
+ * the two is covered by the next poll, so producers on latency-sensitive threads never block on it. stop() runs the
+ * drain step one last time and joins. The thread starts in the constructor, so declare the worker after every member
+ * that drain uses, and call stop() in the owner's destructor before releasing anything drain touches.
+ * wake() 不加锁：只增加计数，并且仅在线程休眠时通知，两者之间错过的唤醒由下一次轮询兜底，因此对时延敏感的生产者
+ * 线程不会阻塞在这里。stop() 最后执行一次 drain 后等待线程结束。线程在构造函数中启动，因此应声明在 drain 用到的
+ * 所有成员之后，并在所有者的析构函数中、释放 drain 用到的资源之前调用 stop()。
+ */
+class PollingWorker {
+public:
+    PollingWorker(std::chrono::milliseconds poll_interval, std::function<void()> drain)
+        : poll_interval_(poll_interval), drain_(std::move(drain)), thread_([this] { run(); }) {}
+    ~PollingWorker() { stop(); }
+
+    PollingWorker(const PollingWorker &) = delete;
+    PollingWorker &operator=(const PollingWorker &) = delete;
+
+    void wake() {
+        signal_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            cv_.notify_one();
+        }
+    }
+
+    // 可重复调用
+    void stop() {
+        stopping_.store(true, std::memory_order_seq_cst);
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+private:
+    void run() {
+        for (;;) {
+            bool stopping = stopping_.load(std::memory_order_seq_cst);
+            uint32_t seen = signal_.load(std::memory_order_seq_cst);
+            drain_();
+            if (stopping) {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_.store(true, std::memory_order_seq_cst);
+            cv_.wait_for(lock, poll_interval_, [this, seen] {
+                return signal_.load(std::memory_order_seq_cst) != seen || stopping_.load(std::memory_order_seq_cst);
+            });
+            sleeping_.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    const std::chrono::milliseconds poll_interval_;
+    const std::function<void()> drain_;
+
+    std::atomic<uint32_t> signal_ = 0;
+    std::atomic<bool> sleeping_ = false;
+    std::atomic<bool> stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    std::thread thread_;
+};
@@ -1,26 +1,225 @@
 #pragma once
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <deque>
 #include <mutex>
-#include <queue>
+#include <utility>
+#include <vector>
 
+/**
+ * @brief Multi-producer/multi-consumer queue with timed, batched and closable operations
+ *        支持超时、批量与关闭操作的多生产者/多消费者队列
+ *
+ * capacity 0 means unbounded. With a bound, push() and emplace() block until there is room and try_push() fails,
+ * which gives producers backpressure; push_evicting() drops the oldest item instead. After close() every waiter
+ * wakes up, pushes fail, and pops keep returning the remaining items until the queue is empty. Waiters are only
+ * signalled when somebody is actually waiting, and the signal is sent after the lock is released so the woken
+ * thread does not immediately block on it again.
+ * capacity 为 0 表示不限长度。设置上限后 push() 与 emplace() 在队列满时阻塞，try_push() 直接失败，从而给生产者施加
+ * 背压；push_evicting() 则丢弃最旧的元素。close() 之后所有等待者被唤醒，入队失败，出队操作继续取出剩余元素直到
+ * 队列为空。只有确实有线程在等待时才发出通知，并且在释放锁之后通知，避免被唤醒的线程立即再次阻塞在锁上。
+ */
 template <typename T> class ThreadSafeQueue {
 private:
-    std::queue<T> queue;
+    std::deque<T> queue;
     std::mutex mtx;
-    std::condition_variable cv;
+    std::condition_variable not_empty;
+    std::condition_variable not_full;
+    size_t capacity;
+    size_t waiting_consumers = 0;
+    size_t waiting_producers = 0;
+    bool closed = false;
+
+    // 调用方持有锁；阻塞到有空位或队列关闭，可以入队时返回 true
+    bool wait_for_room(std::unique_lock<std::mutex> &lock) {
+        if (capacity != 0 && queue.size() >= capacity && !closed) {
+            waiting_producers++;
+            not_full.wait(lock, [this] { return queue.size() < capacity || closed; });
+            waiting_producers--;
+        }
+        return !closed;
+    }
+
+    // 调用方持有锁；阻塞到有元素或队列关闭，有元素时返回 true
+    bool wait_for_item(std::unique_lock<std::mutex> &lock) {
+        if (queue.empty() && !closed) {
+            waiting_consumers++;
+            not_empty.wait(lock, [this] { return !queue.empty() || closed; });
+            waiting_consumers--;
+        }
+        return !queue.empty();
+    }
+
+    // 调用方持有锁；阻塞到有元素、队列关闭或 deadline，有元素时返回 true
+    template <typename Clock, typename Duration>
+    bool wait_for_item(std::unique_lock<std::mutex> &lock, const std::chrono::time_point<Clock, Duration> &deadline) {
+        if (queue.empty() && !closed) {
+            waiting_consumers++;
+            not_empty.wait_until(lock, deadline, [this] { return !queue.empty() || closed; });
+            waiting_consumers--;
+        }
+        return !queue.empty();
+    }
+
+    // 入队后在锁外唤醒一个消费者
+    void notify_pushed(std::unique_lock<std::mutex> &lock) {
+        bool wake = waiting_consumers > 0;
+        lock.unlock();
+        if (wake) {
+            not_empty.notify_one();
+        }
+    }
+
+    // 出队 count 个元素后在锁外唤醒等待空位的生产者
+    void notify_popped(std::unique_lock<std::mutex> &lock, size_t count) {
+        bool wake = waiting_producers > 0;
+        lock.unlock();
+        if (wake) {
+            count == 1 ? not_full.notify_one() : not_full.notify_all();
+        }
+    }
+
+    T take_front() {
+        T item = std::move(queue.front());
+        queue.pop_front();
+        return item;
+    }
+
+    // 调用方持有锁；取出最多 max_n 个元素追加到 out 并释放锁
+    size_t take_batch(std::unique_lock<std::mutex> &lock, std::vector<T> &out, size_t max_n) {
+        size_t count = 0;
+        while (count < max_n && !queue.empty()) {
+            out.push_back(take_front());
+            count++;
+        }
+        notify_popped(lock, count);
+        return count;
+    }
 
 public:
-    void push(T item) {
-        std::lock_guard<std::mutex> lock(mtx);
-        queue.push(item);
-        cv.notify_one();
+    explicit ThreadSafeQueue(size_t capacity = 0) : capacity(capacity) {}
+
+    ThreadSafeQueue(const ThreadSafeQueue &) = delete;
+    ThreadSafeQueue &operator=(const ThreadSafeQueue &) = delete;
+
+    // 队列满时阻塞，队列已关闭时返回 false
+    bool push(T item) { return emplace(std::move(item)); }
+
+    template <typename... Args> bool emplace(Args &&...args) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!wait_for_room(lock)) {
+            return false;
+        }
+        queue.emplace_back(std::forward<Args>(args)...);
+        notify_pushed(lock);
+        return true;
+    }
+
+    // 队列满或已关闭时立即返回 false，此时 item 保持不变
+    bool try_push(T &&item) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (closed || (capacity != 0 && queue.size() >= capacity)) {
+            return false;
+        }
+        queue.push_back(std::move(item));
+        notify_pushed(lock);
+        return true;
+    }
+
+    // 队列满时丢弃最旧的元素而不阻塞，evicted 表示是否发生了丢弃；队列已关闭时返回 false
+    bool push_evicting(T item, bool &evicted) {
+        std::unique_lock<std::mutex> lock(mtx);
+        evicted = false;
+        if (closed) {
+            return false;
+        }
+        if (capacity != 0 && queue.size() >= capacity) {
+            queue.pop_front();
+            evicted = true;
+        }
+        queue.push_back(std::move(item));
+        notify_pushed(lock);
+        return true;
     }
 
+    // 阻塞到取出一个元素；队列已关闭且为空时返回 false
     bool pop(T &item) {
         std::unique_lock<std::mutex> lock(mtx);
-        cv.wait(lock, [this] { return !queue.empty(); });
-        item = queue.front();
-        queue.pop();
+        if (!wait_for_item(lock)) {
+            return false;
+        }
+        item = take_front();
+        notify_popped(lock, 1);
         return true;
     }
-};
\ No newline at end of file
+
+    bool try_pop(T &item) {
+        return pop_until(item, std::chrono::steady_clock::time_point::min());
+    }
+
+    template <typename Rep, typename Period> bool pop_for(T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        return pop_until(item, std::chrono::steady_clock::now() + timeout);
+    }
+
+    // 等待到 deadline 为止，超时或队列已关闭且为空时返回 false
+    template <typename Clock, typename Duration>
+    bool pop_until(T &item, const std::chrono::time_point<Clock, Duration> &deadline) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!wait_for_item(lock, deadline)) {
+            return false;
+        }
+        item = take_front();
+        notify_popped(lock, 1);
+        return true;
+    }
+
+    // 加一次锁取出最多 max_n 个元素追加到 out，不等待，返回取出的数量
+    size_t drain(std::vector<T> &out, size_t max_n = (size_t)-1) {
+        return drain_until(out, max_n, std::chrono::steady_clock::time_point::min());
+    }
+
+    // 阻塞到至少有一个元素，然后加一次锁取出最多 max_n 个元素；队列已关闭且为空时返回 0
+    size_t drain_wait(std::vector<T> &out, size_t max_n = (size_t)-1) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!wait_for_item(lock)) {
+            return 0;
+        }
+        return take_batch(lock, out, max_n);
+    }
+
+    // 等待到至少有一个元素或 deadline，然后加一次锁取出最多 max_n 个元素，返回取出的数量
+    template <typename Clock, typename Duration>
+    size_t drain_until(std::vector<T> &out, size_t max_n, const std::chrono::time_point<Clock, Duration> &deadline) {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (!wait_for_item(lock, deadline)) {
+            return 0;
+        }
+        return take_batch(lock, out, max_n);
+    }
+
+    // 关闭队列并唤醒所有等待者，可重复调用
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            closed = true;
+        }
+        not_empty.notify_all();
+        not_full.notify_all();
+    }
+
+    bool is_closed() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return closed;
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return queue.size();
+    }
+
+    bool empty() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return queue.empty();
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "transport.hpp"
+
+/**
+ * @brief Connection state of a simulated transport whose notifications are delivered by a TimedScheduler
+ *        由 TimedScheduler 投递通知的模拟传输层的连接状态
+ *
+ * Scheduled events record the generation they were created in. Connecting and disconnecting bump it, so everything
+ * scheduled before is dropped on delivery. The scheduler thread holds mutex while it calls callback, therefore no
+ * notification arrives after disconnect_locked() has returned and the lock is released.
+ * 排定的事件记录其创建时的 generation，连接与断开都会使其加一，之前排定的事件在投递时被丢弃。调度线程持有 mutex
+ * 调用 callback，因此 disconnect_locked() 返回并释放锁之后不会再有通知。
+ */
+struct SimulatedEndpoint {
+    std::mutex mutex;
+    Transport::NotifyCallback callback;
+    bool connected = false;
+    uint64_t generation = 0;
+
+    // 以下方法由调用方持有 mutex
+    void connect_locked() {
+        connected = true;
+        generation++;
+    }
+
+    void disconnect_locked() {
+        connected = false;
+        callback = nullptr;
+        generation++;
+    }
+
+    // 在 scheduled 代排定的事件是否仍应投递
+    bool current_locked(uint64_t scheduled) const { return connected && generation == scheduled; }
+};
+
+/**
+ * @brief One thread that hands items to a handler when they fall due, ties in scheduling order
+ *        单个线程在条目到期时将其交给处理函数，到期时间相同时按排定顺序
+ *
+ * Every item due by now is taken under one lock and handled with the lock released, so the handler may schedule
+ * further items. Items still queued at destruction are discarded. The handler keeps running until the destructor
+ * has joined the thread, so declare the scheduler after the members the handler uses.
+ * 所有已到期的条目在一次加锁中取出，并在释放锁后处理，因此处理函数可以继续排定新的条目。析构时仍在排队的条目被
+ * 丢弃。析构函数等待线程结束之前处理函数都可能运行，因此调度器应声明在处理函数用到的成员之后。
+ */
+template <typename T> class TimedScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        Clock::time_point due;
+        T item;
+    };
+
+    using Handler = std::function<void(Event &)>;
+
+    explicit TimedScheduler(Handler handler) : handler_(std::move(handler)), worker_([this] { run(); }) {}
+    ~TimedScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        worker_.join();
+    }
+
+    TimedScheduler(const TimedScheduler &) = delete;
+    TimedScheduler &operator=(const TimedScheduler &) = delete;
+
+    void schedule(Event event) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push(Entry{std::move(event), next_order_++});
+        }
+        cv_.notify_one();
+    }
+
+    // 一次加锁排定一批事件，到期时间相同的事件按其在批中的顺序处理
+    void schedule(std::vector<Event> events) {
+        if (events.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (Event &event : events) {
+                queue_.push(Entry{std::move(event), next_order_++});
+            }
+        }
+        cv_.notify_one();
+    }
+
+private:
+    struct Entry {
+        Event event;
+        uint64_t order = 0;
+
+        bool operator>(const Entry &other) const {
+            return event.due != other.event.due ? event.due > other.event.due : order > other.order;
+        }
+    };
+
+    void run() {
+        std::vector<Event> due;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (queue_.empty()) {
+                cv_.wait(lock);
+                continue;
+            }
+            Clock::time_point now = Clock::now();
+            Clock::time_point deadline = queue_.top().event.due;
+            if (deadline > now) {
+                cv_.wait_until(lock, deadline);
+                continue;
+            }
+            while (!queue_.empty() && queue_.top().event.due <= now) {
+                due.push_back(queue_.top().event);
+                queue_.pop();
+            }
+            lock.unlock();
+
+            for (Event &event : due) {
+                handler_(event);
+            }
+            due.clear();
+
+            lock.lock();
+        }
+    }
+
+    const Handler handler_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue_;
+    uint64_t next_order_ = 0;
+    bool stopping_ = false;
+
+    std::thread worker_;
+};
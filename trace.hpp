@@ -0,0 +1,253 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Flight recorder for command lifecycle spans, exported as Chrome trace-event JSON
+ *        命令生命周期区间的飞行记录器，导出为 Chrome trace-event JSON
+ *
+ * Each span is one fixed-size slot claimed with a single fetch_add; recording never locks or allocates, and the
+ * oldest spans are overwritten once the ring is full, so the file always holds the most recent capacity spans.
+ * Spans carry a device and a SEQ and are written as nestable async events whose id combines the two: Perfetto and
+ * chrome://tracing draw every command as its own track, from encode through result delivery, no matter which
+ * thread recorded each step.
+ * 每个区间占用一个定长槽位，只需一次 fetch_add 认领；记录时不加锁也不分配内存，环形缓冲区写满后覆盖最旧的区间，
+ * 因此文件中总是最近的 capacity 个区间。区间带有设备与 SEQ，以二者组合为 id 的嵌套异步事件写出：Perfetto 与
+ * chrome://tracing 会把每条命令画成独立的轨道，从编码一直到结果交付，无论每一步由哪个线程记录。
+ *
+ * Instrumentation goes through the OSMO_TRACE_* macros below, which expand to nothing unless OSMO_ENABLE_TRACE is
+ * defined; their arguments are not evaluated in that case.
+ * 埋点通过下方的 OSMO_TRACE_* 宏进行，未定义 OSMO_ENABLE_TRACE 时宏展开为空，参数也不会被求值。
+ */
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t default_capacity = 1 << 16;
+
+    // capacity 向上取整为 2 的幂
+    explicit TraceRecorder(size_t capacity = default_capacity)
+        : mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1), slots_(new Slot[mask_ + 1]),
+          epoch_(Clock::now()) {}
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    static TraceRecorder &global() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // 返回设备编号，同名设备得到同一编号；编号 0 保留给未知设备
+    uint32_t device(const std::string &name) {
+        std::lock_guard<std::mutex> lock(devices_mutex_);
+        for (size_t i = 0; i < devices_.size(); i++) {
+            if (devices_[i] == name) {
+                return (uint32_t)i + 1;
+            }
+        }
+        devices_.push_back(name);
+        return (uint32_t)devices_.size();
+    }
+
+    // 记录一个区间，任意线程调用；name 必须是字符串字面量或生命周期不短于记录器的字符串
+    void record(const char *name, uint32_t device, uint16_t seq, Clock::time_point begin, Clock::time_point end) {
+        uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = slots_[index & mask_];
+        // 顺序锁：先作废槽位，写完字段后再发布序号，导出线程据此丢弃正在被改写的槽位
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.track.store((device << 16) | seq, std::memory_order_relaxed);
+        slot.thread.store(thread_index(), std::memory_order_relaxed);
+        slot.begin.store((begin - epoch_).count(), std::memory_order_relaxed);
+        slot.end.store((end - epoch_).count(), std::memory_order_relaxed);
+        slot.sequence.store(index + 1, std::memory_order_release);
+    }
+
+    // 已记录的区间总数，超过容量的部分已被覆盖
+    uint64_t recorded() const { return next_.load(std::memory_order_relaxed); }
+    size_t capacity() const { return mask_ + 1; }
+
+    // 以 Chrome trace-event JSON 格式返回仍保留在环形缓冲区中的区间，可与记录并发调用
+    std::string json() const {
+        std::string out = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        {
+            std::lock_guard<std::mutex> lock(devices_mutex_);
+            for (size_t i = 0; i <= devices_.size(); i++) {
+                append_separator(out, first);
+                out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(i) +
+                       ",\"args\":{\"name\":\"";
+                append_escaped(out, i == 0 ? std::string("unknown device") : devices_[i - 1]);
+                out += "\"}}";
+            }
+        }
+
+        uint64_t end = next_.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity() ? end - capacity() : 0;
+        for (uint64_t index = begin; index < end; index++) {
+            const Slot &slot = slots_[index & mask_];
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const char *name = slot.name.load(std::memory_order_relaxed);
+            uint32_t track = slot.track.load(std::memory_order_relaxed);
+            uint32_t thread = slot.thread.load(std::memory_order_relaxed);
+            Ticks span_begin = slot.begin.load(std::memory_order_relaxed);
+            Ticks span_end = slot.end.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // 尚未发布、正在改写或已被下一圈覆盖的槽位
+            if (sequence != index + 1 || slot.sequence.load(std::memory_order_relaxed) != sequence) {
+                continue;
+            }
+            append_event(out, first, name, 'b', track, thread, span_begin);
+            append_event(out, first, name, 'e', track, thread, span_end);
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    // 写出 json()，失败时返回 false
+    bool write_json(const std::string &path) const {
+        std::string text = json();
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        bool ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+private:
+    using Ticks = Clock::duration::rep;
+
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> sequence = 0; // 下标加一，0 表示未发布
+        std::atomic<const char *> name = nullptr;
+        std::atomic<uint32_t> track = 0; // 设备编号 << 16 | SEQ
+        std::atomic<uint32_t> thread = 0;
+        std::atomic<Ticks> begin = 0; // 相对 epoch_ 的时钟刻度
+        std::atomic<Ticks> end = 0;
+    };
+
+    static uint32_t thread_index() {
+        static std::atomic<uint32_t> next = 1;
+        thread_local uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+    static void append_separator(std::string &out, bool &first) {
+        if (!first) {
+            out += ",\n";
+        }
+        first = false;
+    }
+
+    static void append_escaped(std::string &out, const std::string &value) {
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if ((unsigned char)c < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+    }
+
+    void append_event(std::string &out, bool &first, const char *name, char phase, uint32_t track, uint32_t thread,
+                      Ticks ticks) const {
+        append_separator(out, first);
+        // trace-event 的时间单位为微秒，保留到纳秒
+        double us = std::chrono::duration<double, std::micro>(Clock::duration(ticks)).count();
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "{\"name\":\"%s\",\"cat\":\"osmo\",\"ph\":\"%c\",\"id\":\"0x%x\",\"pid\":%u,\"tid\":%u,"
+                      "\"ts\":%.3f,\"args\":{\"seq\":%u}}",
+                      name, phase, track, track >> 16, thread, us, track & 0xFFFF);
+        out += line;
+    }
+
+    const size_t mask_;
+    const std::unique_ptr<Slot[]> slots_;
+    const Clock::time_point epoch_;
+    alignas(64) std::atomic<uint64_t> next_ = 0;
+
+    mutable std::mutex devices_mutex_;
+    std::vector<std::string> devices_;
+};
+
+/**
+ * @brief Records one span from construction to destruction
+ *        记录从构造到析构的一个区间
+ */
+class TraceScope {
+public:
+    TraceScope(const char *name, uint32_t device, uint16_t seq)
+        : name_(name), device_(device), seq_(seq), begin_(TraceRecorder::Clock::now()) {}
+    ~TraceScope() { TraceRecorder::global().record(name_, device_, seq_, begin_, TraceRecorder::Clock::now()); }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    uint32_t device_;
+    uint16_t seq_;
+    TraceRecorder::Clock::time_point begin_;
+};
+
+/**
+ * @brief Writes the global recorder to a file when it goes out of scope
+ *        离开作用域时将全局记录器写入文件
+ */
+class TraceFile {
+public:
+    explicit TraceFile(std::string path) : path_(std::move(path)) {}
+    ~TraceFile() {
+        if (!TraceRecorder::global().write_json(path_)) {
+            std::fprintf(stderr, "Failed to write trace to %s\n", path_.c_str());
+        }
+    }
+
+    TraceFile(const TraceFile &) = delete;
+    TraceFile &operator=(const TraceFile &) = delete;
+
+private:
+    std::string path_;
+};
+
+#define OSMO_TRACE_CONCAT_INNER(a, b) a##b
+#define OSMO_TRACE_CONCAT(a, b) OSMO_TRACE_CONCAT_INNER(a, b)
+
+#ifdef OSMO_ENABLE_TRACE
+// 注册设备并返回编号，用于之后的区间
+#define OSMO_TRACE_DEVICE(name) TraceRecorder::global().device(name)
+// 记录从此处到所在作用域结束的区间
+#define OSMO_TRACE_SCOPE(name, device, seq)                                                                         \
+    TraceScope OSMO_TRACE_CONCAT(osmo_trace_scope_, __LINE__)(name, device, seq)
+// 声明区间起点变量 var，与 OSMO_TRACE_END 成对使用
+#define OSMO_TRACE_BEGIN(var) const TraceRecorder::Clock::time_point var = TraceRecorder::Clock::now()
+// 记录从 OSMO_TRACE_BEGIN(var) 到此处的区间
+#define OSMO_TRACE_END(name, device, seq, var)                                                                      \
+    TraceRecorder::global().record(name, device, seq, var, TraceRecorder::Clock::now())
+// 记录起止时间已知的区间，适用于跨线程的阶段
+#define OSMO_TRACE_RECORD(name, device, seq, begin, end) TraceRecorder::global().record(name, device, seq, begin, end)
+#else
+#define OSMO_TRACE_DEVICE(name) 0u
+#define OSMO_TRACE_SCOPE(name, device, seq) ((void)0)
+#define OSMO_TRACE_BEGIN(var) ((void)0)
+#define OSMO_TRACE_END(name, device, seq, var) ((void)0)
+#define OSMO_TRACE_RECORD(name, device, seq, begin, end) ((void)0)
+#endif
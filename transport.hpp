@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Byte link to one camera: connection, notifications from the camera and writes to it
+ *        到单台相机的字节链路：连接、相机发来的通知以及向相机的写入
+ *
+ * OsmoDevice only sees this interface, so the same host stack runs over Bluetooth (BleTransport) or against
+ * in-process simulated cameras (CameraSimulator). Notifications arrive on a thread owned by the transport and may
+ * carry part of a frame or several frames; writes never exceed mtu() bytes and come from a single writer thread.
+ * OsmoDevice 只依赖此接口，因此同一套主机协议栈既可以运行在蓝牙上（BleTransport），也可以对接进程内的模拟相机
+ * （CameraSimulator）。通知在传输层自己的线程上到达，可能只包含半帧，也可能包含多帧；写入不超过 mtu() 字节，
+ * 且只来自单一写线程。
+ */
+class Transport {
+public:
+    // data 只在回调期间有效
+    using NotifyCallback = std::function<void(const uint8_t *data, size_t length)>;
+
+    virtual ~Transport() = default;
+
+    // 建立连接并找到通知与写入特征，失败时抛出异常
+    virtual void connect() = 0;
+    // 断开连接；返回后不会再调用通知回调
+    virtual void disconnect() = 0;
+    virtual bool is_connected() = 0;
+
+    virtual std::string address() = 0;
+    // 单次写操作可携带的最大字节数，已扣除 ATT 头
+    virtual size_t mtu() = 0;
+
+    // 订阅相机的通知，在 connect() 之后调用
+    virtual void subscribe(NotifyCallback callback) = 0;
+    // 无应答写入，失败时抛出异常
+    virtual void write(const uint8_t *data, size_t length) = 0;
+};